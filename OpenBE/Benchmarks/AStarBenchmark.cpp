@@ -0,0 +1,75 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "AStar.h"
+#include "Fixtures.h"
+#include "PathPlanner.h"
+
+using namespace BE;
+
+/*
+ * Bare AStar on the dilated map of each corpus map, one query per
+ * iteration: nodes expanded per second, and the p50 and p99 latency of the
+ * queries, in microseconds. BM_AStar/<map>.
+ */
+
+namespace {
+
+    double percentile (std::vector<double>& samples, double fraction)
+    {
+        if (samples.empty())
+            return 0.0;
+        const size_t i = std::min (samples.size() - 1, (size_t)(fraction * samples.size()));
+        std::nth_element (samples.begin(), samples.begin() + i, samples.end());
+        return samples[i];
+    }
+
+    void aStar (benchmark::State& state, const Fixtures::CorpusMap* map)
+    {
+        PathPlanner planner;
+        planner.load (map->raw, Fixtures::kRobotRadius);
+        const auto endpoints = Fixtures::endpointPairs (planner, 256, 1);
+        if (endpoints.empty())
+        {
+            state.SkipWithError ("no connected endpoints");
+            return;
+        }
+
+        AStar search;
+        std::vector<GridPoint> path;
+        std::vector<double> latencies;
+        size_t next = 0, expanded = 0;
+        for (auto _ : state)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            search.findPath (planner.map(), endpoints[next].first, endpoints[next].second, path);
+            latencies.push_back (std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now() - start).count());
+            expanded += search.stats().expanded;
+            next = (next + 1) % endpoints.size();
+        }
+
+        state.SetItemsProcessed (state.iterations());
+        state.counters["expanded/s"] = benchmark::Counter ((double)expanded, benchmark::Counter::kIsRate);
+        state.counters["expanded"] = benchmark::Counter ((double)expanded / state.iterations());
+        state.counters["p50_us"] = percentile (latencies, 0.5);
+        state.counters["p99_us"] = percentile (latencies, 0.99);
+    }
+
+    const bool registered = []
+    {
+        for (const Fixtures::CorpusMap& map : Fixtures::mapCorpus())
+            benchmark::RegisterBenchmark (("BM_AStar/" + map.name).c_str(), aStar, &map)->Unit (benchmark::kMicrosecond);
+        return true;
+    }();
+
+} // anonymous
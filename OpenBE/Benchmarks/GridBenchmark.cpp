@@ -0,0 +1,125 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Fixtures.h"
+#include "Grid.h"
+#include "PathPlanner.h"
+
+using namespace BE;
+
+/*
+ * Construction and query throughput of the map grids on 512 x 512 and
+ * 2048 x 2048 cluttered maps: copying the raw map into a guarded grid,
+ * deriving every layer from it as initWithImage: does, and the point queries
+ * and full scans PathFinding answers on the caller's thread.
+ */
+
+namespace {
+
+    const Grid<unsigned char>& clutteredMap (int size)
+    {
+        static Grid<unsigned char> maps[2];
+        Grid<unsigned char>& map = maps[size > 512];
+        if (map.width() != size)
+            Fixtures::clutteredMap (size, size, 1, map);
+        return map;
+    }
+
+    void BM_GridCopy (benchmark::State& state)
+    {
+        const Grid<unsigned char>& raw = clutteredMap ((int)state.range (0));
+        Grid<unsigned char> map;
+        for (auto _ : state)
+        {
+            map.copy (raw, 1, 255);
+            benchmark::DoNotOptimize (map.row (0));
+        }
+        state.SetItemsProcessed (state.iterations() * raw.width() * raw.height());
+    }
+    BENCHMARK (BM_GridCopy)->Arg (512)->Arg (2048)->Unit (benchmark::kMicrosecond);
+
+    void BM_GridLoadLayers (benchmark::State& state)
+    {
+        const Grid<unsigned char>& raw = clutteredMap ((int)state.range (0));
+        for (auto _ : state)
+        {
+            PathPlanner planner;
+            planner.load (raw, Fixtures::kRobotRadius);
+            benchmark::DoNotOptimize (planner.largestComponent());
+        }
+        state.SetItemsProcessed (state.iterations() * raw.width() * raw.height());
+    }
+    BENCHMARK (BM_GridLoadLayers)->Arg (512)->Arg (2048)->Unit (benchmark::kMillisecond);
+
+    /** count random cells of a size x size map, looked up in turn so the queries miss the cache. */
+    std::vector<GridPoint> randomCells (int size, size_t count)
+    {
+        std::mt19937 rng (2);
+        std::vector<GridPoint> cells (count);
+        for (GridPoint& cell : cells)
+            cell = GridPoint{ (int)(rng() % (unsigned)size), (int)(rng() % (unsigned)size) };
+        return cells;
+    }
+
+    void BM_GridIsOccupied (benchmark::State& state)
+    {
+        const int size = (int)state.range (0);
+        PathPlanner planner;
+        planner.load (clutteredMap (size), Fixtures::kRobotRadius);
+        const std::vector<GridPoint> cells = randomCells (size, 1 << 16);
+
+        size_t occupied = 0;
+        for (auto _ : state)
+        {
+            for (const GridPoint& cell : cells)
+                occupied += planner.isOccupied (cell.x, cell.y);
+        }
+        benchmark::DoNotOptimize (occupied);
+        state.SetItemsProcessed (state.iterations() * cells.size());
+    }
+    BENCHMARK (BM_GridIsOccupied)->Arg (512)->Arg (2048);
+
+    void BM_GridCanPath (benchmark::State& state)
+    {
+        const int size = (int)state.range (0);
+        PathPlanner planner;
+        planner.load (clutteredMap (size), Fixtures::kRobotRadius);
+        const std::vector<GridPoint> cells = randomCells (size, 1 << 16);
+
+        size_t connected = 0;
+        for (auto _ : state)
+        {
+            for (size_t i = 1; i < cells.size(); i++)
+                connected += planner.canPath (cells[i - 1], cells[i]);
+        }
+        benchmark::DoNotOptimize (connected);
+        state.SetItemsProcessed (state.iterations() * (cells.size() - 1));
+    }
+    BENCHMARK (BM_GridCanPath)->Arg (512)->Arg (2048);
+
+    void BM_GridOccupiedCells (benchmark::State& state)
+    {
+        const int size = (int)state.range (0);
+        PathPlanner planner;
+        planner.load (clutteredMap (size), Fixtures::kRobotRadius);
+        std::vector<Float3> points;
+        for (auto _ : state)
+        {
+            planner.occupiedCells (GridTransform(), points);
+            benchmark::DoNotOptimize (points.data());
+        }
+        state.SetItemsProcessed (state.iterations() * size * size);
+        state.SetLabel ("items = cells scanned");
+    }
+    BENCHMARK (BM_GridOccupiedCells)->Arg (512)->Arg (2048)->Unit (benchmark::kMicrosecond);
+
+} // anonymous
@@ -0,0 +1,93 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Fixtures.h"
+#include "HeightField.h"
+#include "HeightRasterizer.h"
+
+using namespace BE;
+
+/*
+ * Height queries per second on the 6 x 6 m room's map at 2 cm cells, for
+ * batches of 8, 64 and 1024 random positions, about a sixth of them off the map.
+ * BM_HeightFieldBatch makes one call per batch, BM_HeightFieldScalar one per
+ * position as getInterpolatedHeight: does.
+ */
+
+namespace {
+
+    const float kCellSize = 0.02f;
+
+    const HeightField& roomField ()
+    {
+        static const HeightField field = []
+        {
+            const Fixtures::Mesh mesh = Fixtures::roomMesh (5);
+            const int size = (int)(6.f / kCellSize);
+            HeightRasterizer rasterizer;
+            rasterizer.reset (size, size, GridTransform{ -3.f, -3.f, kCellSize }, 1.8f, -0.5f);
+            rasterizer.addTriangles (mesh.vertices.data(), mesh.vertices.size(), mesh.faces.data(), mesh.faces.size() / 3);
+
+            HeightField field;
+            field.assign (size, size, -3.f, -3.f, kCellSize, rasterizer.heights().data());
+            return field;
+        }();
+        return field;
+    }
+
+    /** Interleaved (x, z) positions over the room and a margin of 30 cm around it. */
+    std::vector<float> queryPositions (size_t count)
+    {
+        std::mt19937 rng (11);
+        std::uniform_real_distribution<float> coordinate (-3.3f, 3.3f);
+        std::vector<float> positions (2 * count);
+        for (float& p : positions)
+            p = coordinate (rng);
+        return positions;
+    }
+
+    void BM_HeightFieldBatch (benchmark::State& state)
+    {
+        const HeightField& field = roomField();
+        const size_t count = (size_t)state.range (0);
+        const std::vector<float> positions = queryPositions (count);
+        std::vector<float> heights (count);
+        std::vector<uint32_t> valid ((count + 31) / 32);
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize (field.interpolate (positions.data(), count, heights.data(), valid.data()));
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed (state.iterations() * count);
+    }
+    BENCHMARK (BM_HeightFieldBatch)->Arg (8)->Arg (64)->Arg (1024);
+
+    void BM_HeightFieldScalar (benchmark::State& state)
+    {
+        const HeightField& field = roomField();
+        const size_t count = (size_t)state.range (0);
+        const std::vector<float> positions = queryPositions (count);
+        std::vector<float> heights (count);
+
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < count; i++)
+                heights[i] = field.interpolate (positions[2 * i], positions[2 * i + 1]);
+            benchmark::DoNotOptimize (heights.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed (state.iterations() * count);
+    }
+    BENCHMARK (BM_HeightFieldScalar)->Arg (8)->Arg (64)->Arg (1024);
+
+} // anonymous
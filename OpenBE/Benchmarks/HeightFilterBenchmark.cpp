@@ -0,0 +1,102 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Fixtures.h"
+#include "HeightFilter.h"
+#include "HeightRasterizer.h"
+
+using namespace BE;
+
+/*
+ * Erosion of the 6 x 6 m room's height map by the agent radius, across cell
+ * sizes of 4, 2 and 1 cm and radii of 10, 25 and 50 cm: arguments are the
+ * cell size in mm and the radius in cm. BM_HeightFilterWindow scans the full
+ * window of every sample as NavigationComponent used to, on the coarser maps
+ * only; its cost grows with the square of the radius in cells.
+ */
+
+namespace {
+
+    const float kNoHeight = HeightRasterizer::kNoHeight;
+
+    const std::vector<float>& roomHeights (int cellSizeMillimeters, int& size)
+    {
+        static std::map<int, std::vector<float>> heights;
+        const float cellSize = cellSizeMillimeters * 0.001f;
+        size = (int)(6.f / cellSize);
+
+        std::vector<float>& map = heights[cellSizeMillimeters];
+        if (map.empty())
+        {
+            const Fixtures::Mesh mesh = Fixtures::roomMesh (5);
+            HeightRasterizer rasterizer;
+            rasterizer.reset (size, size, GridTransform{ -3.f, -3.f, cellSize }, 1.8f, -0.5f);
+            rasterizer.addTriangles (mesh.vertices.data(), mesh.vertices.size(), mesh.faces.data(), mesh.faces.size() / 3);
+            map = rasterizer.heights();
+        }
+        return map;
+    }
+
+    int radiusInCells (const benchmark::State& state)
+    {
+        return std::max (1, (int)(state.range (1) * 10 / state.range (0)));
+    }
+
+    void BM_HeightFilter (benchmark::State& state)
+    {
+        int size = 0;
+        const std::vector<float>& heights = roomHeights ((int)state.range (0), size);
+        const int radius = radiusInCells (state);
+
+        HeightFilter filter;
+        for (auto _ : state)
+        {
+            filter.apply (heights.data(), size, size, radius, HeightFilter::Maximum, kNoHeight);
+            benchmark::DoNotOptimize (filter.heights().data());
+        }
+        state.SetItemsProcessed (state.iterations() * size * size);
+        state.counters["radius_cells"] = radius;
+    }
+    BENCHMARK (BM_HeightFilter)->ArgsProduct ({ { 40, 20, 10 }, { 10, 25, 50 } })->Unit (benchmark::kMicrosecond);
+
+    void BM_HeightFilterWindow (benchmark::State& state)
+    {
+        int size = 0;
+        const std::vector<float>& heights = roomHeights ((int)state.range (0), size);
+        const int radius = radiusInCells (state);
+
+        std::vector<float> eroded (heights.size());
+        for (auto _ : state)
+        {
+            for (int y = 0; y < size; y++)
+            {
+                for (int x = 0; x < size; x++)
+                {
+                    float highest = -kNoHeight;
+                    for (int wy = std::max (0, y - radius); wy <= std::min (size - 1, y + radius); wy++)
+                    {
+                        for (int wx = std::max (0, x - radius); wx <= std::min (size - 1, x + radius); wx++)
+                            highest = std::max (highest, heights[(size_t)wx + (size_t)wy * size]);
+                    }
+                    eroded[(size_t)x + (size_t)y * size] = highest;
+                }
+            }
+            benchmark::DoNotOptimize (eroded.data());
+        }
+        state.SetItemsProcessed (state.iterations() * size * size);
+        state.counters["radius_cells"] = radius;
+    }
+    BENCHMARK (BM_HeightFilterWindow)->ArgsProduct ({ { 40, 20 }, { 10, 25, 50 } })->Unit (benchmark::kMicrosecond);
+
+} // anonymous
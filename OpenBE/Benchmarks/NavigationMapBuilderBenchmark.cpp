@@ -0,0 +1,70 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include "Fixtures.h"
+#include "NavigationMapBuilder.h"
+#include "TaskPool.h"
+
+using namespace BE;
+
+/*
+ * Tiled navigation map build of the 6 x 6 m room on 1 to N threads, N the
+ * number of cores: arguments are the cell size in mm and the thread count.
+ * Wall time, plus focus_ms, how long until the cell at the focus could be
+ * read.
+ */
+
+namespace {
+
+    void BM_NavigationMapBuild (benchmark::State& state)
+    {
+        const float cellSize = state.range (0) * 0.001f;
+        const GridTransform transform = { -3.f, -3.f, cellSize };
+        const std::vector<Float3> triangles = Fixtures::roomMesh (5).triangles();
+
+        NavigationMapBuilder::Settings settings;
+        settings.width = settings.height = (int)(6.f / cellSize);
+        settings.startY = 1.8f;
+        settings.endY = -0.5f;
+        settings.radius = (int)(0.25f / cellSize);
+        settings.focus = { settings.width / 2, settings.height / 2 };
+
+        TaskPool pool ((unsigned)state.range (1));
+        double focusSeconds = 0.0;
+        for (auto _ : state)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            std::shared_ptr<NavigationMapBuilder> builder =
+                NavigationMapBuilder::start (pool, settings, NavigationMapBuilder::rasterize (triangles, transform, settings));
+            while (builder->height (settings.focus.x, settings.focus.y) == NavigationMapBuilder::kNoHeight && !builder->isFinished())
+                std::this_thread::yield();
+            focusSeconds += std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+            builder->wait();
+        }
+        state.SetItemsProcessed (state.iterations() * settings.width * settings.height);
+        state.counters["focus_ms"] = 1000.0 * focusSeconds / state.iterations();
+    }
+
+    void threadCounts (benchmark::internal::Benchmark* benchmark)
+    {
+        const int cores = (int)std::max (1u, std::thread::hardware_concurrency());
+        for (int cellSize : { 20, 10 })
+        {
+            for (int threads = 1; threads < cores; threads *= 2)
+                benchmark->Args ({ cellSize, threads });
+            benchmark->Args ({ cellSize, cores });
+        }
+    }
+    BENCHMARK (BM_NavigationMapBuild)->Apply (threadCounts)->UseRealTime()->Unit (benchmark::kMillisecond);
+
+} // anonymous
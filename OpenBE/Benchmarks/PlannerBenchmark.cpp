@@ -0,0 +1,99 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "Fixtures.h"
+#include "PathPlanner.h"
+
+using namespace BE;
+
+/*
+ * Layer build and every planner algorithm on each map of the corpus, one
+ * benchmark per map and algorithm: BM_PlannerLoad/<map> and
+ * BM_Planner/<map>/<algorithm>. Queries cycle through the same random
+ * connected endpoints for every algorithm, with the path cache off.
+ */
+
+namespace {
+
+    const struct { PathPlanner::Algorithm algorithm; const char* name; } kAlgorithms[] = {
+        { PathPlanner::AStarAlgorithm, "AStar" },
+        { PathPlanner::JumpPointAlgorithm, "JumpPoint" },
+        { PathPlanner::HierarchicalAlgorithm, "Hierarchical" },
+        { PathPlanner::IncrementalAlgorithm, "Incremental" },
+        { PathPlanner::CoarseToFineAlgorithm, "CoarseToFine" },
+        { PathPlanner::AnyAngleAlgorithm, "AnyAngle" },
+        { PathPlanner::BidirectionalAlgorithm, "Bidirectional" },
+    };
+
+    void plannerLoad (benchmark::State& state, const Fixtures::CorpusMap* map)
+    {
+        for (auto _ : state)
+        {
+            PathPlanner planner;
+            planner.load (map->raw, Fixtures::kRobotRadius);
+            benchmark::DoNotOptimize (planner.largestComponent());
+        }
+        state.SetItemsProcessed (state.iterations() * map->raw.width() * map->raw.height());
+        state.SetLabel ("items = cells");
+    }
+
+    void planner (benchmark::State& state, const Fixtures::CorpusMap* map, PathPlanner::Algorithm algorithm)
+    {
+        PathPlanner planner;
+        planner.load (map->raw, Fixtures::kRobotRadius);
+        planner.pathCache().setCapacity (0);
+        const auto endpoints = Fixtures::endpointPairs (planner, 64, 1);
+        if (endpoints.empty())
+        {
+            state.SkipWithError ("no connected endpoints");
+            return;
+        }
+
+        // Builds the HPA* abstraction outside the timed loop.
+        PathPlanner::Query query;
+        query.algorithm = algorithm;
+        PathPlanner::Result result;
+        query.start = endpoints[0].first;
+        query.goal = endpoints[0].second;
+        planner.findPath (query, result);
+
+        size_t next = 0, expanded = 0, found = 0;
+        for (auto _ : state)
+        {
+            query.start = endpoints[next].first;
+            query.goal = endpoints[next].second;
+            next = (next + 1) % endpoints.size();
+            found += planner.findPath (query, result);
+            expanded += result.expanded;
+        }
+        state.SetItemsProcessed (state.iterations());
+        state.counters["expanded/s"] = benchmark::Counter ((double)expanded, benchmark::Counter::kIsRate);
+        state.counters["found"] = benchmark::Counter ((double)found / state.iterations());
+    }
+
+    const bool registered = []
+    {
+        for (const Fixtures::CorpusMap& map : Fixtures::mapCorpus())
+        {
+            benchmark::RegisterBenchmark (("BM_PlannerLoad/" + map.name).c_str(), plannerLoad, &map)
+                ->Unit (benchmark::kMillisecond);
+            for (const auto& algorithm : kAlgorithms)
+            {
+                benchmark::RegisterBenchmark (("BM_Planner/" + map.name + "/" + algorithm.name).c_str(), planner,
+                                              &map, algorithm.algorithm)
+                    ->Unit (benchmark::kMicrosecond);
+            }
+        }
+        return true;
+    }();
+
+} // anonymous
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Regenerate the synthetic occupancy maps of this corpus.
+
+Each map is laid out like an OccupancyMap.png exported from a scan at 4 cm
+per pixel: 255 where there is an obstacle or nothing was scanned, 0 on free
+floor. Walls come out a few pixels thick with ragged edges, furniture as
+boxes and round tables, and scan noise as isolated specks. The output is
+deterministic, so rerunning this leaves the checked-in files unchanged.
+
+Usage: generate.py [output directory]
+"""
+
+import os
+import random
+import sys
+
+BLOCKED = 255
+FREE = 0
+
+
+class Floor:
+    def __init__(self, width, height):
+        self.width = width
+        self.height = height
+        self.cells = bytearray([BLOCKED]) * (width * height)
+
+    def fill(self, x0, y0, x1, y1, value):
+        x0, y0 = max(x0, 0), max(y0, 0)
+        x1, y1 = min(x1, self.width), min(y1, self.height)
+        for y in range(y0, y1):
+            self.cells[y * self.width + x0:y * self.width + x1] = bytes([value]) * max(0, x1 - x0)
+
+    def disc(self, cx, cy, r, value):
+        for y in range(cy - r, cy + r + 1):
+            for x in range(cx - r, cx + r + 1):
+                if 0 <= x < self.width and 0 <= y < self.height and (x - cx) ** 2 + (y - cy) ** 2 <= r * r:
+                    self.cells[y * self.width + x] = value
+
+    def speckle(self, rng, count, value):
+        for _ in range(count):
+            x, y = rng.randrange(self.width), rng.randrange(self.height)
+            self.cells[y * self.width + x] = value
+
+    def rag(self, rng, amount):
+        """Flip cells along the edges between free and blocked, like a noisy scan."""
+        edges = []
+        w = self.width
+        for y in range(1, self.height - 1):
+            for x in range(1, w - 1):
+                c = self.cells[y * w + x]
+                if c != self.cells[y * w + x + 1] or c != self.cells[(y + 1) * w + x]:
+                    edges.append(y * w + x)
+        for i in rng.sample(edges, int(len(edges) * amount)):
+            self.cells[i] = BLOCKED if self.cells[i] == FREE else FREE
+
+    def write(self, path, comment):
+        with open(path, "wb") as f:
+            f.write(b"P5\n# " + comment.encode() + b"\n")
+            f.write(b"%d %d\n255\n" % (self.width, self.height))
+            f.write(bytes(self.cells))
+
+
+def furnish(floor, rng, x0, y0, x1, y1, pieces):
+    for _ in range(pieces):
+        if rng.random() < 0.3:
+            r = rng.randint(8, 16)
+            floor.disc(rng.randint(x0 + r + 12, max(x0 + r + 12, x1 - r - 12)),
+                       rng.randint(y0 + r + 12, max(y0 + r + 12, y1 - r - 12)), r, BLOCKED)
+        else:
+            w, h = rng.randint(10, 50), rng.randint(10, 30)
+            if rng.random() < 0.5:
+                w, h = h, w
+            # Against a wall half of the time, like sofas, beds and shelves.
+            x = rng.randint(x0, max(x0, x1 - w)) if rng.random() < 0.5 else rng.choice([x0, max(x0, x1 - w)])
+            y = rng.randint(y0, max(y0, y1 - h))
+            floor.fill(x, y, x + w, y + h, BLOCKED)
+
+
+def rooms(floor, rng, x0, y0, x1, y1, depth, wall, door):
+    """Split a free rectangle into rooms by walls with a door each, binary space partition style."""
+    w, h = x1 - x0, y1 - y0
+    if depth == 0 or max(w, h) < 140:
+        furnish(floor, rng, x0 + wall, y0 + wall, x1 - wall, y1 - wall, rng.randint(1, 4) * max(1, w * h // 40000))
+        return
+    if w >= h:
+        cut = rng.randint(x0 + w // 3, x1 - w // 3)
+        floor.fill(cut - wall // 2, y0, cut + wall - wall // 2, y1, BLOCKED)
+        d = rng.randint(y0 + wall, y1 - wall - door)
+        floor.fill(cut - wall, d, cut + wall, d + door, FREE)
+        rooms(floor, rng, x0, y0, cut, y1, depth - 1, wall, door)
+        rooms(floor, rng, cut, y0, x1, y1, depth - 1, wall, door)
+    else:
+        cut = rng.randint(y0 + h // 3, y1 - h // 3)
+        floor.fill(x0, cut - wall // 2, x1, cut + wall - wall // 2, BLOCKED)
+        d = rng.randint(x0 + wall, x1 - wall - door)
+        floor.fill(d, cut - wall, d + door, cut + wall, FREE)
+        rooms(floor, rng, x0, y0, x1, cut, depth - 1, wall, door)
+        rooms(floor, rng, x0, cut, x1, y1, depth - 1, wall, door)
+
+
+def room(seed):
+    """One furnished 6.4 x 6.4 m room, the size of a typical Bridge Engine scan."""
+    rng = random.Random(seed)
+    floor = Floor(160, 160)
+    floor.fill(8, 10, 152, 148, FREE)
+    furnish(floor, rng, 8, 10, 152, 148, 6)
+    floor.rag(rng, 0.15)
+    floor.speckle(rng, 60, BLOCKED)
+    return floor
+
+
+def apartment(seed):
+    """12 x 10 m of rooms joined by doors, with an unscanned notch."""
+    rng = random.Random(seed)
+    floor = Floor(300, 250)
+    floor.fill(6, 6, 294, 244, FREE)
+    floor.fill(200, 170, 300, 250, BLOCKED)
+    rooms(floor, rng, 6, 6, 294, 244, 3, 4, 22)
+    floor.rag(rng, 0.1)
+    floor.speckle(rng, 300, BLOCKED)
+    return floor
+
+
+def office(seed):
+    """20 x 20 m open plan: rows of desks around a corridor, meeting rooms on one side."""
+    rng = random.Random(seed)
+    floor = Floor(512, 512)
+    floor.fill(8, 8, 504, 504, FREE)
+    rooms(floor, rng, 8, 8, 160, 504, 3, 4, 24)
+    floor.fill(160, 8, 164, 504, BLOCKED)
+    for d in range(40, 480, 110):
+        floor.fill(158, d, 166, d + 24, FREE)
+    for y in range(40, 470, 60):
+        for x in range(200, 480, 70):
+            if rng.random() < 0.85:
+                floor.fill(x, y, x + 40, y + 18, BLOCKED)
+                for _ in range(3):
+                    floor.disc(x + rng.randint(0, 40), y + rng.choice([-6, 24]), 3, BLOCKED)
+    floor.rag(rng, 0.08)
+    floor.speckle(rng, 800, BLOCKED)
+    return floor
+
+
+def warehouse(seed):
+    """40 x 40 m: long shelf aisles with cross aisles and scattered pallets."""
+    rng = random.Random(seed)
+    floor = Floor(1024, 1024)
+    floor.fill(10, 10, 1014, 1014, FREE)
+    for x in range(60, 960, 64):
+        y = 60
+        while y < 960:
+            length = rng.randint(120, 300)
+            floor.fill(x, y, x + 24, min(y + length, 960), BLOCKED)
+            y += length + rng.randint(30, 50)
+    for _ in range(120):
+        x, y = rng.randint(20, 990), rng.randint(20, 990)
+        floor.fill(x, y, x + 25, y + 25, BLOCKED)
+    floor.rag(rng, 0.05)
+    floor.speckle(rng, 3000, BLOCKED)
+    return floor
+
+
+def main():
+    out = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    maps = [("room", room(1)), ("apartment", apartment(2)), ("office", office(3)), ("warehouse", warehouse(4))]
+    for name, floor in maps:
+        floor.write(os.path.join(out, name + ".pgm"), "MetersPerPixel 0.04")
+
+
+if __name__ == "__main__":
+    main()
@@ -149,6 +149,10 @@ typedef void (^callback)(void);
             self.pathFinding = [[PathFinding alloc] init];
             self.noCoverPathFinding = nil;
         }
+
+        // Corner-to-corner waypoints: fewer moveTo segments than the 8-connected staircase.
+        self.pathFinding.smoothing = PathFindingSmoothingStringPull;
+        self.noCoverPathFinding.smoothing = PathFindingSmoothingStringPull;
     }
 
     self.moveTo = (MoveToBehaviourComponent *)[self.entity componentForClass:[MoveToBehaviourComponent class]];
@@ -196,7 +200,7 @@ typedef void (^callback)(void);
     // Check if our reference point needs adjusting.
     if( [_pathFinding occupied:reachableReferencePoint] ) {
         be_NSDbg(@"The refrence point for path finding is sitting on an occupied point.");
-        unsigned char largestCC = [_pathFinding largestConnectedComponent];
+        uint32_t largestCC = [_pathFinding largestConnectedComponent];
         
         GLKVector3 nearestPt;
         if( [_pathFinding closestAccessiblePointTo:_reachableReferencePoint inComponent:largestCC result:&nearestPt] ) {
@@ -221,10 +225,11 @@ typedef void (^callback)(void);
             SCNGeometry *geo = [SCNBox boxWithWidth:nodeSize height:nodeSize length:nodeSize chamferRadius:0];
             geo.firstMaterial.diffuse.contents = [UIColor yellowColor]; // [[UIColor yellowColor] colorWithAlphaComponent:0.5];
 
-            NSMutableArray<NSValue*> *points = [_pathFinding occupiedPoints];
-            for( NSValue *pt in points ){
-                GLKVector3 p;
-                [pt getValue:&p];
+            NSData *pointData = [_pathFinding occupiedPointData];
+            const GLKVector3 *points = (const GLKVector3 *)pointData.bytes;
+            NSUInteger pointCount = pointData.length / sizeof(GLKVector3);
+            for( NSUInteger i=0; i<pointCount; i++ ){
+                GLKVector3 p = points[i];
                 p.y -= nodeSize*0.5; // Offset above ground
                 
                 // Create SCNNodes
@@ -270,10 +275,11 @@ typedef void (^callback)(void);
                 [geoColors addObject:geo];
             }
             
-            NSMutableArray<NSValue*> *points = [_pathFinding connectedComponentPoints];
-            for( NSValue *pt in points ){
-                GLKVector3 p;
-                [pt getValue:&p];
+            NSData *pointData = [_pathFinding connectedComponentPointData];
+            const GLKVector3 *points = (const GLKVector3 *)pointData.bytes;
+            NSUInteger pointCount = pointData.length / sizeof(GLKVector3);
+            for( NSUInteger i=0; i<pointCount; i++ ){
+                GLKVector3 p = points[i];
                 
                 // Create SCNNodes with a component colour
                 int componentSet = (int)p.y % 8;
@@ -300,7 +306,7 @@ typedef void (^callback)(void);
  */
 - (GLKVector3) findLargestOpenAreaPoint:(PathFinding*) pathFinding {
 
-    unsigned char largestComponent = [pathFinding largestConnectedComponent];
+    uint32_t largestComponent = [pathFinding largestConnectedComponent];
     GLKVector3 point;
     if( [pathFinding closestAccessiblePointTo:(GLKVector3){0,0,-.3} inComponent:largestComponent result:&point] ) {
         return point;
@@ -355,7 +361,7 @@ typedef void (^callback)(void);
         // Check if our reference point needs adjusting.
         if( [_pathFinding occupied:_reachableReferencePoint] ) {
             be_NSDbg(@"The refrence point for path finding is sitting on an occupied point.");
-            unsigned char largestCC = [_pathFinding largestConnectedComponent];
+            uint32_t largestCC = [_pathFinding largestConnectedComponent];
             
             GLKVector3 nearestPt;
             if( [_pathFinding closestAccessiblePointTo:_reachableReferencePoint inComponent:largestCC result:&nearestPt] ) {
@@ -383,10 +389,10 @@ typedef void (^callback)(void);
         from = ptTmp;
         float duration = [_moveTo durationToTarget:ptTmp];
         [_moveTo runBehaviourFor:duration*_moveSpeedModifier targetPosition:ptTmp callback:^(){
-            self.pathFindingOperation = [self.pathFinding findNearestPath:ptTmp to:target completion:nil];
+            self.pathFindingOperation = [self.pathFinding findNearestPath:ptTmp to:target algorithm:PathFindingAlgorithmJumpPoint agent:self completion:nil];
         }];
     } else {
-        self.pathFindingOperation = [self.pathFinding findNearestPath:from to:target completion:nil];
+        self.pathFindingOperation = [self.pathFinding findNearestPath:from to:target algorithm:PathFindingAlgorithmJumpPoint agent:self completion:nil];
     }
 }
 
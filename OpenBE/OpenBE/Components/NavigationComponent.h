@@ -7,12 +7,39 @@
 
 #import "../Core/Component.h"
 
+@class BEMesh;
+
+/// How heights are stored in the navigation map cache file, which queries read in place once the map is built.
+typedef NS_ENUM(NSInteger, NavigationMapEncoding) {
+    NavigationMapEncodingQuantized16 = 0,   // 16 bits spread over the heights present in the map; sub-millimetre in a room.
+    NavigationMapEncodingFloat16,           // Half floats, about 1 mm steps at 2 m.
+    NavigationMapEncodingFloat32,           // Exact, twice the size.
+};
+
 @interface NavigationComponent : Component
 
+/// Encoding of maps cached by the next preProcess. Caches are keyed on the geometry they were built from, so a rescan rebuilds the map.
+@property (nonatomic) NavigationMapEncoding mapEncoding;
+
 - (void) preProcess:(SCNNode *)collisionNode startY:(float)startY endY:(float)endY minBB:(GLKVector2)minBB maxBB:(GLKVector2)maxBB resolution:(float)resolution agentRadius:(float)radius;
 
+/// Same as above, but builds the heightmap by rasterizing the triangles of mesh, the geometry of collisionNode in its local coordinates, instead of ray casting every cell.
+/// Cells any surface overlaps are covered, so thin obstacles between cell centres are not missed.
+- (void) preProcess:(SCNNode *)collisionNode mesh:(BEMesh *)mesh startY:(float)startY endY:(float)endY minBB:(GLKVector2)minBB maxBB:(GLKVector2)maxBB resolution:(float)resolution agentRadius:(float)radius;
+
+/// Same as above, but returns at once and builds the map in tiles on worker threads, starting with those nearest focus.
+/// Each tile can be queried as soon as it is done; cells not built yet read as 999.f, like unreachable ones.
+/// progress (the fraction done) and completion are called on the main queue. completion runs once the whole map is ready, and never if the build is
+/// cancelled, which happens when another preProcess replaces this one or the component is deallocated.
+/// Without a mesh, ray casts run one at a time on a background thread, only erosion on the worker threads; collisionNode must not change until completion.
+- (void) preProcessAsync:(SCNNode *)collisionNode mesh:(BEMesh *)mesh startY:(float)startY endY:(float)endY minBB:(GLKVector2)minBB maxBB:(GLKVector2)maxBB resolution:(float)resolution agentRadius:(float)radius focus:(GLKVector3)focus progress:(void (^)(float progress))progress completion:(void (^)(void))completion;
+
 - (float) getHeight:(GLKVector3)position;
 - (float) getInterpolatedHeight:(GLKVector3)position;
+
+/// Heights at count (x, z) positions, as getInterpolatedHeight: would return them; 999.f where there is none.
+/// Much faster once the map is finished, as the whole batch is interpolated at once. Returns how many have a height.
+- (int) getInterpolatedHeights:(const GLKVector2 *)positions count:(int)count heights:(float *)heights;
 - (GLKVector3) getRandomPoint:(GLKVector3)position maxDistance:(float)distance minY:(float)minY maxTry:(int)maxTry;
 
 @end
@@ -0,0 +1,363 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+// Todo: heightmap should really be rendered on GPU
+// Todo: should return NO, instead of using a height of 999.f if navigationPoint is not reachable.
+
+#import "NavigationComponent.h"
+#import "../Utils/Math.h"
+#import <BridgeEngine/BEDebugging.h>
+#import <BridgeEngine/BEMesh.h>
+#import <GLKit/GLKit.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Core/HeightField.h"
+#include "../Core/NavigationCache.h"
+#include "../Core/NavigationMapBuilder.h"
+#include "../Core/TaskPool.h"
+
+static_assert(sizeof(GLKVector3) == sizeof(BE::Float3), "mesh vertices are rasterized as BE::Float3");
+static_assert(sizeof(GLKVector2) == 2 * sizeof(float), "positions are queried as interleaved (x, z) floats");
+
+// Workers shared by every navigation map build.
+static BE::TaskPool& navigationTaskPool() {
+    static BE::TaskPool pool;
+    return pool;
+}
+
+// One thread for SceneKit hit tests, which are not documented as safe to run concurrently.
+static BE::TaskPool& rayCastTaskPool() {
+    static BE::TaskPool pool(1);
+    return pool;
+}
+
+static BE::NavigationCache::Encoding cacheEncoding(NavigationMapEncoding encoding) {
+    switch( encoding ) {
+        case NavigationMapEncodingFloat32: return BE::NavigationCache::Float32;
+        case NavigationMapEncodingFloat16: return BE::NavigationCache::Float16;
+        default: return BE::NavigationCache::Quantized16;
+    }
+}
+
+// bytes identifying the geometry under node: the vertices of every geometry and where they are placed
+static NSData * collisionGeometryData(SCNNode * node) {
+    NSMutableData * data = [NSMutableData data];
+    NSMutableArray<SCNNode *> * nodes = [NSMutableArray arrayWithObject:node];
+    [nodes addObjectsFromArray:[node childNodesPassingTest:^BOOL(SCNNode * child, BOOL * stop) {
+        return child.geometry != nil;
+    }]];
+    
+    for( SCNNode * geometryNode in nodes ) {
+        if( !geometryNode.geometry ) continue;
+        SCNMatrix4 transform = geometryNode.worldTransform;
+        [data appendBytes:&transform length:sizeof(transform)];
+        for( SCNGeometrySource * source in [geometryNode.geometry geometrySourcesForSemantic:SCNGeometrySourceSemanticVertex] ) {
+            [data appendData:source.data];
+        }
+    }
+    return data;
+}
+
+@interface NavigationComponent()
+@property (atomic) GLKVector2 minMapCoord;
+@property (atomic) float mapResolution;
+@property (atomic) int mapWidth;
+@property (atomic) int mapHeight;
+
+@end
+
+@implementation NavigationComponent {
+    // map being built; once done, or read from its cache file, every query goes to the height field
+    std::shared_ptr<BE::NavigationMapBuilder> _builder;
+    std::shared_ptr<BE::HeightField> _heightField;   // the finished map, padded for bulk bilinear queries
+    std::atomic<unsigned> _generation;  // preProcess calls, so a stale build does not replace a newer map
+}
+
+- (void) dealloc {
+    std::shared_ptr<BE::NavigationMapBuilder> builder = std::atomic_load(&_builder);
+    if( builder ) builder->cancel();
+}
+
+- (void) preProcess:(SCNNode *)collisionNode startY:(float)startY endY:(float)endY minBB:(GLKVector2)minBB maxBB:(GLKVector2)maxBB resolution:(float)resolution agentRadius:(float)radius {
+    [self preProcess:collisionNode mesh:nil startY:startY endY:endY minBB:minBB maxBB:maxBB resolution:resolution agentRadius:radius];
+}
+
+- (void) preProcess:(SCNNode *)collisionNode mesh:(BEMesh *)mesh startY:(float)startY endY:(float)endY minBB:(GLKVector2)minBB maxBB:(GLKVector2)maxBB resolution:(float)resolution agentRadius:(float)radius {
+    GLKVector3 center = GLKVector3Make((minBB.x+maxBB.x)*.5f, startY, (minBB.y+maxBB.y)*.5f);
+    [self preProcessAsync:collisionNode mesh:mesh startY:startY endY:endY minBB:minBB maxBB:maxBB resolution:resolution agentRadius:radius focus:center progress:nil completion:nil];
+    
+    std::shared_ptr<BE::NavigationMapBuilder> builder = std::atomic_load(&_builder);
+    if( builder ) builder->wait();
+}
+
+- (void) preProcessAsync:(SCNNode *)collisionNode mesh:(BEMesh *)mesh startY:(float)startY endY:(float)endY minBB:(GLKVector2)minBB maxBB:(GLKVector2)maxBB resolution:(float)resolution agentRadius:(float)radius focus:(GLKVector3)focus progress:(void (^)(float progress))progress completion:(void (^)(void))completion {
+    
+    // taken first, so whatever an earlier call still has in flight is stale from here on
+    unsigned generation = ++_generation;
+    __weak NavigationComponent * weakSelf = self;
+    
+    std::shared_ptr<BE::NavigationMapBuilder> previous = std::atomic_exchange(&_builder, std::shared_ptr<BE::NavigationMapBuilder>());
+    if( previous ) previous->cancel();
+    
+    // step 1, calculate heightmap
+    int width = (maxBB.x-minBB.x) / resolution;
+    int height = (maxBB.y-minBB.y) / resolution;
+    
+    self.minMapCoord = GLKVector2Make(MIN(maxBB.x, minBB.x), MIN(maxBB.y, minBB.y));
+    self.mapResolution = resolution;
+    self.mapWidth = width;
+    self.mapHeight = height;
+    
+    BE::GridTransform transform;
+    transform.originX = minBB.x;
+    transform.originZ = minBB.y;
+    transform.cellSize = resolution;
+    
+    BE::NavigationCache::Info info;
+    info.originX = transform.originX;
+    info.originZ = transform.originZ;
+    info.resolution = resolution;
+    info.agentRadius = radius;
+    info.startY = startY;
+    info.endY = endY;
+    info.encoding = cacheEncoding(self.mapEncoding);
+    
+    // the geometry the map is built from is hashed into the cache, so after a rescan the cache is stale
+    std::vector<BE::Float3> triangles;
+    uint64_t sourceHash;
+    if( mesh ) {
+        // walk the collision mesh triangles once, instead of one ray cast per cell;
+        // they are copied now, as the mesh may be unlocked as soon as this returns
+        GLKMatrix4 toWorld = collisionNode ? SCNMatrix4ToGLKMatrix4(collisionNode.worldTransform) : GLKMatrix4Identity;
+        
+        for(int i=0; i<[mesh numberOfMeshes]; i++) {
+            int vertexCount = [mesh numberOfMeshVertices:i];
+            int faceCount = [mesh numberOfMeshFaces:i];
+            const GLKVector3 * vertices = [mesh meshVertices:i];
+            const unsigned short * faces = [mesh meshFaces:i];
+            
+            triangles.reserve(triangles.size() + 3 * faceCount);
+            for(int f=0; f<3*faceCount; f+=3) {
+                if( faces[f] >= vertexCount || faces[f+1] >= vertexCount || faces[f+2] >= vertexCount ) continue;
+                for(int v=0; v<3; v++) {
+                    GLKVector3 world = GLKMatrix4MultiplyVector3WithTranslation(toWorld, vertices[faces[f+v]]);
+                    triangles.push_back(BE::Float3{ world.x, world.y, world.z });
+                }
+            }
+        }
+        sourceHash = BE::hashNavigationSource(triangles.data(), sizeof(BE::Float3) * triangles.size(), width, height, info);
+    } else {
+        NSData * geometry = collisionGeometryData(collisionNode);
+        sourceHash = BE::hashNavigationSource(geometry.bytes, geometry.length, width, height, info);
+    }
+    
+    // one cache per collision node; rasterized maps cover every cell a surface touches, so they are cached apart
+    NSString * cachedDataFileName = [NSString stringWithFormat:@"navMap_%@%@.cache", collisionNode.name ?: @"scene", mesh ? @"_raster" : @""];
+    
+    NSString *documentsPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+    std::string filePath = [[documentsPath stringByAppendingPathComponent:cachedDataFileName] fileSystemRepresentation];
+    
+    // the cache is decoded once into the height field and unmapped, so a map is held only once
+    BE::NavigationCache cache;
+    if( cache.open(filePath.c_str(), sourceHash) && cache.width() == width && cache.height() == height ) {
+        std::shared_ptr<BE::HeightField> field = std::make_shared<BE::HeightField>();
+        field->reset(width, height, self.minMapCoord.x, self.minMapCoord.y, resolution);
+        cache.read(field->row(0), field->stride());
+        cache.close();
+        
+        std::atomic_store(&_heightField, field);
+        if( completion ) {
+            void (^completionBlock)(void) = [completion copy];
+            dispatch_async(dispatch_get_main_queue(), ^{
+                NavigationComponent * strongSelf = weakSelf;
+                if( strongSelf && strongSelf->_generation.load() == generation ) completionBlock();
+            });
+        }
+        return;
+    }
+    std::atomic_store(&_heightField, std::shared_ptr<BE::HeightField>());
+    
+    be_dbg("size: %lu", sizeof(float) * width * height );
+    
+    // step 2 erodes the heightmap by the agent radius, tile by tile as soon as the tiles around are done
+    BE::NavigationMapBuilder::Settings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.startY = startY;
+    settings.endY = endY;
+    settings.radius = MAX(1,radius/resolution);
+    settings.focus = transform.toGrid(focus.x, focus.z);
+    
+    BE::NavigationMapBuilder::HeightSource source;
+    if( mesh ) {
+        source = BE::NavigationMapBuilder::rasterize(std::move(triangles), transform, settings);
+    } else {
+        // ray cast every cell, one tile after another on the ray cast thread; the node must not change meanwhile
+        source = [collisionNode, transform, startY, endY](const BE::GridRect& tile, float* heights) {
+            for(int y=tile.y0; y<tile.y1; y++) {
+                for(int x=tile.x0; x<tile.x1; x++) {
+                    BE::Float3 start = transform.toWorld(x, y, startY);
+                    BE::Float3 end = transform.toWorld(x, y, endY);
+                    
+                    SCNVector3 from = SCNVector3Make(start.x, start.y, start.z);
+                    SCNVector3 to = SCNVector3Make(end.x, end.y, end.z);
+                    
+                    NSArray<SCNHitTestResult *> *hitTestResults = [collisionNode hitTestWithSegmentFromPoint:from toPoint:to options:nil];
+                    
+                    float& sample = heights[(x-tile.x0) + (y-tile.y0)*(tile.x1-tile.x0)];
+                    if( [hitTestResults count] ) {
+                        sample = [hitTestResults objectAtIndex:0].worldCoordinates.y;
+                    } else {
+                        sample = 999.f;
+                    }
+                }
+            }
+        };
+    }
+    
+#if defined(DEBUG)
+    NSDate * buildStart = [NSDate date];
+#endif
+    
+    // handlers run on the workers and outlive this call, so hold on to copies of the blocks
+    void (^progressBlock)(float) = [progress copy];
+    void (^completionBlock)(void) = [completion copy];
+    GLKVector2 origin = self.minMapCoord;
+    
+    BE::NavigationMapBuilder::ProgressHandler progressHandler;
+    if( progressBlock ) {
+        progressHandler = [progressBlock](float fraction) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                progressBlock(fraction);
+            });
+        };
+    }
+    
+    BE::NavigationMapBuilder::CompletionHandler completionHandler = [=](bool finished, const std::vector<float>& map) {
+        // cancelled: replaced by a newer preProcess or the component went away; the caller's completion is dropped
+        if( !finished ) return;
+        
+#if defined(DEBUG)
+        be_dbg("navigation map built in %.1f ms", -[buildStart timeIntervalSinceNow] * 1000.0);
+#endif
+        be_NSDbg(@"Navigation Map is build, save to cached file %@", cachedDataFileName);
+        
+        // queries move over to the height field, so the float map goes away with the builder; the cache is for next time
+        if( !BE::NavigationCache::write(filePath.c_str(), sourceHash, info, width, height, map.data()) ) {
+            be_NSDbg(@"Could not write navigation map cache %@", cachedDataFileName);
+        }
+        std::shared_ptr<BE::HeightField> field = std::make_shared<BE::HeightField>();
+        field->assign(width, height, origin.x, origin.y, resolution, map.data());
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            NavigationComponent * strongSelf = weakSelf;
+            if( strongSelf && strongSelf->_generation.load() == generation ) {
+                std::atomic_store(&strongSelf->_heightField, field);
+                std::atomic_store(&strongSelf->_builder, std::shared_ptr<BE::NavigationMapBuilder>());
+                if( completionBlock ) completionBlock();
+            }
+        });
+    };
+    
+    std::shared_ptr<BE::NavigationMapBuilder> builder = BE::NavigationMapBuilder::start(navigationTaskPool(), settings, source, progressHandler, completionHandler, mesh ? nullptr : &rayCastTaskPool());
+    std::atomic_store(&_builder, builder);
+}
+
+// height of cell (x, y) of the map, 999.f outside it or while its tile is being built
+- (float) mapHeightAtX:(int)x y:(int)y {
+    if( x < 0 || x >= self.mapWidth || y < 0 || y >= self.mapHeight ) {
+        return 999.f;
+    }
+    
+    std::shared_ptr<BE::NavigationMapBuilder> builder = std::atomic_load(&_builder);
+    if( builder ) {
+        return builder->height(x, y);
+    }
+    
+    std::shared_ptr<BE::HeightField> field = std::atomic_load(&_heightField);
+    return field ? field->height(x, y) : 999.f;
+}
+
+- (float) getHeight:(GLKVector3)position {
+    int x = (position.x - self.minMapCoord.x ) / self.mapResolution;
+    int y = (position.z - self.minMapCoord.y ) / self.mapResolution;
+    
+    return [self mapHeightAtX:x y:y];
+}
+
+- (float) getInterpolatedHeight:(GLKVector3)position {
+    std::shared_ptr<BE::HeightField> field = std::atomic_load(&_heightField);
+    if( field ) {
+        return field->interpolate(position.x, position.z);
+    }
+    
+    float x = (position.x - self.minMapCoord.x ) / self.mapResolution;
+    float y = (position.z - self.minMapCoord.y ) / self.mapResolution;
+    
+    int xi = (int)floor(x);
+    int yi = (int)floor(y);
+    
+    float xf = x-xi;
+    float yf = y-yi;
+    
+    // cells outside the map, or not built yet, read as 999.f
+    float h1 = [self mapHeightAtX:xi y:yi];
+    float h2 = [self mapHeightAtX:xi+1 y:yi];
+    float h3 = [self mapHeightAtX:xi y:yi+1];
+    float h4 = [self mapHeightAtX:xi+1 y:yi+1];
+    bool success = true;
+    
+    if( h1 > 998.f || h2 > 998.f  || h3 > 998.f  || h4 > 998.f ) success = false;
+    
+    return success?lerpf( lerpf( h1, h2, xf ), lerpf( h3, h4, xf), yf ):999.f;
+}
+
+- (int) getInterpolatedHeights:(const GLKVector2 *)positions count:(int)count heights:(float *)heights {
+    if( count <= 0 ) return 0;
+    
+    std::shared_ptr<BE::HeightField> field = std::atomic_load(&_heightField);
+    if( field ) {
+        return (int)field->interpolate(&positions[0].x, count, heights);
+    }
+    
+    // still building, tiles become readable one by one
+    int valid = 0;
+    for(int i=0; i<count; i++) {
+        heights[i] = [self getInterpolatedHeight:GLKVector3Make(positions[i].x, 0.f, positions[i].y)];
+        if( heights[i] < 999.f ) valid++;
+    }
+    return valid;
+}
+
+- (GLKVector3) getRandomPoint:(GLKVector3)position maxDistance:(float)distance minY:(float)minY maxTry:(int)maxTry {
+    if( maxTry <= 0 ) return GLKVector3Make(999.f, 999.f, 999.f);
+    
+    // random points around position, all tried at once
+    std::vector<GLKVector2> candidates(maxTry);
+    std::vector<float> heights(maxTry);
+    for(int i=0; i<maxTry; i++) {
+        float x = random11() * distance;
+        float y = random11() * distance;
+        candidates[i] = GLKVector2Make(position.x + x, position.z + y);
+    }
+    
+    [self getInterpolatedHeights:candidates.data() count:maxTry heights:heights.data()];
+    
+    for(int i=0; i<maxTry; i++) {
+        if( heights[i] < 999.f && heights[i] > minY ) {
+            return GLKVector3Make(candidates[i].x, heights[i], candidates[i].y);
+        }
+    }
+    return GLKVector3Make(999.f, 999.f, 999.f);
+}
+
+
+@end
@@ -0,0 +1,128 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "AStar.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace BE {
+
+void AStar::reset (size_t nodeCount)
+{
+    if (_nodes.size() != nodeCount || ++_generation == 0)
+    {
+        _nodes.assign (nodeCount, Node{ 0.f, 0, 0, 0 });
+        _generation = 1;
+    }
+    _open.reset (nodeCount);
+    _stats = SearchStats();
+    _pathCost = 0.f;
+}
+
+bool AStar::findPath (const Grid<unsigned char>& map, GridPoint start, GridPoint goal, std::vector<GridPoint>& path,
+                      const CancelFlag* cancel, const Landmarks* landmarks, const Corridor* corridor)
+{
+    assert(map.border() >= 1);
+    assert(!landmarks || !landmarks->isBuilt() || landmarks->cellCount() == map.capacity());
+
+    path.clear();
+    if (!map.inBounds (start.x, start.y) || !map.inBounds (goal.x, goal.y))
+        return false;
+
+    reset (map.capacity());
+
+    const NeighborKernel kernel (map.stride());
+
+    const uint32_t startIndex = (uint32_t)map.index (start.x, start.y);
+    const uint32_t goalIndex = (uint32_t)map.index (goal.x, goal.y);
+    if (landmarks && !landmarks->isBuilt())
+        landmarks = nullptr;
+
+    Node& startNode = _nodes[startIndex];
+    startNode.cost = 0.f;
+    startNode.parent = startIndex; // unique invariant for starting node: you are your parent
+    startNode.generation = _generation;
+    _open.push (startIndex, 0.f);
+
+    bool solutionFound = false;
+    while (!_open.empty())
+    {
+        const uint32_t current = _open.pop();
+        _stats.expanded++;
+
+        if (pollCancel (cancel, _stats.expanded))
+        {
+            _stats.cancelled = true;
+            return false;
+        }
+
+        // A* is "best-first" so if we get here we're done
+        if (current == goalIndex)
+        {
+            solutionFound = true;
+            break;
+        }
+
+        Node& currentNode = _nodes[current];
+        currentNode.closed = _generation;
+
+        int cx, cy;
+        map.coords (current, cx, cy);
+
+        for (int i = 0; i < NeighborKernel::kSize; i++)
+        {
+            const uint32_t neighbor = (uint32_t)(current + kernel.offset[i]);
+            if (isBlocked (map[neighbor]) || !kernel.passes (map, current, i, _cornerRule))
+                continue;
+            // Blocked guard cells never get here, so the corridor is only asked about cells on the map.
+            if (corridor && !corridor->contains (cx + kernel.dx[i], cy + kernel.dy[i]))
+                continue;
+
+            Node& neighborNode = _nodes[neighbor];
+            const bool isNew = neighborNode.generation != _generation;
+
+            const float neighborCost = currentNode.cost + kernel.cost[i];
+
+            // if the neighbor is not yet visited or if we found a new, better way to get there
+            // Closed cells are reopened too. With the octile heuristic that only happens through float
+            // rounding, but it keeps the resulting paths identical to the map-based search this replaced.
+            if (isNew || neighborCost < neighborNode.cost)
+            {
+                if (!isNew && neighborNode.closed == _generation)
+                    _stats.reopened++;
+                neighborNode.cost = neighborCost;
+                neighborNode.parent = current;
+                neighborNode.generation = _generation;
+                neighborNode.closed = 0;
+                float heuristic = diagonalDist (goal.x, goal.y, cx + kernel.dx[i], cy + kernel.dy[i]);
+                if (landmarks)
+                    heuristic = std::max (heuristic, landmarks->lowerBound (neighbor, goalIndex));
+                _open.push (neighbor, neighborCost + heuristic);
+                _stats.pushed++;
+            }
+        }
+    }
+
+    if (!solutionFound)
+        return false;
+
+    _pathCost = _nodes[goalIndex].cost;
+
+    for (uint32_t index = goalIndex; ; index = _nodes[index].parent)
+    {
+        GridPoint p;
+        map.coords (index, p.x, p.y);
+        path.push_back (p);
+        if (_nodes[index].parent == index)
+            break;
+    }
+    std::reverse (path.begin(), path.end());
+    return true;
+}
+
+} // BE namespace
@@ -0,0 +1,81 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+#include "Landmarks.h"
+#include "OccupancyPyramid.h"
+
+namespace BE {
+
+/**
+ * 8-connected A* over an occupancy grid.
+ *
+ * Per-cell search state (cost so far, parent, closed flag) lives in dense
+ * arrays indexed like the map, stamped with a generation counter so nothing
+ * needs clearing between queries. The open set is an IndexedHeap with
+ * decrease-key, so every cell is queued at most once.
+ *
+ * The map must carry a guard band of at least one blocked cell; neighbour
+ * expansion relies on it instead of bounds checks. One instance should be
+ * used by one thread at a time.
+ */
+class AStar
+{
+public:
+    /**
+     * Search from start to goal. On success fills path with every cell from
+     * start to goal inclusive and returns true.
+     * Gives up and returns false once cancel is raised.
+     *
+     * With landmarks built for this map, the heuristic is the larger of the
+     * octile distance and their lower bound; paths stay optimal but far fewer
+     * cells are expanded where obstacles force detours.
+     *
+     * With a corridor, only cells inside it are searched; start and goal must
+     * lie in it. The path is then the shortest one within the corridor.
+     */
+    bool findPath (const Grid<unsigned char>& map, GridPoint start, GridPoint goal, std::vector<GridPoint>& path,
+                   const CancelFlag* cancel = nullptr, const Landmarks* landmarks = nullptr,
+                   const Corridor* corridor = nullptr);
+
+    /** Whether diagonal steps may squeeze between two blocked cells; CutCorners by default. */
+    void setCornerRule (CornerRule rule) { _cornerRule = rule; }
+    CornerRule cornerRule () const { return _cornerRule; }
+
+    /** Cost of the last path found. */
+    float pathCost () const { return _pathCost; }
+
+    /** Counters of the last search. */
+    const SearchStats& stats () const { return _stats; }
+
+private:
+    struct Node
+    {
+        float cost;
+        uint32_t parent;
+        uint32_t generation;
+        uint32_t closed;
+    };
+
+    void reset (size_t nodeCount);
+
+    std::vector<Node> _nodes;
+    IndexedHeap _open;
+    uint32_t _generation = 0;
+    CornerRule _cornerRule = CutCorners;
+    float _pathCost = 0.f;
+    SearchStats _stats;
+};
+
+} // BE namespace
@@ -0,0 +1,166 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "BidirectionalAStar.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace BE {
+
+void BidirectionalAStar::reset (size_t nodeCount)
+{
+    if (_sides[Forward].nodes.size() != nodeCount || ++_generation == 0)
+    {
+        for (Side& side : _sides)
+            side.nodes.assign (nodeCount, Node{ 0.f, 0, 0 });
+        _closed.assign (nodeCount, 0);
+        _generation = 1;
+    }
+    for (Side& side : _sides)
+        side.open.reset (nodeCount);
+    _stats = SearchStats();
+    _bestCost = INFINITY;
+    _pathCost = 0.f;
+}
+
+void BidirectionalAStar::expand (const Grid<unsigned char>& map, Direction direction)
+{
+    Side& side = _sides[direction];
+    const Direction other = direction == Forward ? Backward : Forward;
+    const GridPoint target = direction == Forward ? _goal : _start;
+    const GridPoint origin = direction == Forward ? _start : _goal;
+
+    const uint32_t current = side.open.pop();
+    if (_closed[current] == _generation)
+        return;
+    _closed[current] = _generation;
+
+    const float currentCost = side.nodes[current].cost;
+    int cx, cy;
+    map.coords (current, cx, cy);
+
+    // Prune: no path through current can beat the best one, either by this side's heuristic
+    // or because the other side has nothing cheaper left to offer on the way back to origin.
+    const float otherFrontier = _sides[other].open.empty() ? INFINITY : _sides[other].open.topKey();
+    if (currentCost + diagonalDist (cx, cy, target.x, target.y) >= _bestCost
+        || currentCost + otherFrontier - diagonalDist (cx, cy, origin.x, origin.y) >= _bestCost)
+        return;
+
+    _stats.expanded++;
+
+    for (int i = 0; i < NeighborKernel::kSize; i++)
+    {
+        // Backwards, the step is a forward move into the current cell, which is free; only a blocked start may be left.
+        // Corners are symmetric, so they are checked the same way in both directions.
+        const uint32_t neighbor = (uint32_t)(current + _kernel.offset[i]);
+        if (isBlocked (map[neighbor]) && (direction == Forward || neighbor != _startIndex))
+            continue;
+        if (!_kernel.passes (map, current, i, _cornerRule))
+            continue;
+        if (_closed[neighbor] == _generation)
+            continue;
+
+        Node& neighborNode = side.nodes[neighbor];
+        const bool isNew = neighborNode.generation != _generation;
+        const float neighborCost = currentCost + _kernel.cost[i];
+        if (isNew || neighborCost < neighborNode.cost)
+        {
+            neighborNode.cost = neighborCost;
+            neighborNode.parent = current;
+            neighborNode.generation = _generation;
+            const int nx = cx + _kernel.dx[i];
+            const int ny = cy + _kernel.dy[i];
+            side.open.push (neighbor, neighborCost + diagonalDist (nx, ny, target.x, target.y), -neighborCost);
+            _stats.pushed++;
+
+            if (reached (other, neighbor))
+            {
+                const float total = neighborCost + _sides[other].nodes[neighbor].cost;
+                if (total < _bestCost)
+                {
+                    _bestCost = total;
+                    _meeting = neighbor;
+                }
+            }
+        }
+    }
+}
+
+bool BidirectionalAStar::findPath (const Grid<unsigned char>& map, GridPoint start, GridPoint goal,
+                                   std::vector<GridPoint>& path, const CancelFlag* cancel)
+{
+    assert(map.border() >= 1);
+
+    path.clear();
+    if (!map.inBounds (start.x, start.y) || !map.inBounds (goal.x, goal.y))
+        return false;
+
+    reset (map.capacity());
+
+    _kernel.setStride (map.stride());
+
+    _startIndex = (uint32_t)map.index (start.x, start.y);
+    _goalIndex = (uint32_t)map.index (goal.x, goal.y);
+
+    if (_startIndex == _goalIndex)
+    {
+        path.push_back (start);
+        return true;
+    }
+    // Like AStar, never step into a blocked goal; the start may be blocked.
+    if (isBlocked (map[_goalIndex]))
+        return false;
+
+    _start = start;
+    _goal = goal;
+    _sides[Forward].nodes[_startIndex] = Node{ 0.f, _startIndex, _generation };
+    _sides[Forward].open.push (_startIndex, diagonalDist (start.x, start.y, goal.x, goal.y), 0.f);
+    _sides[Backward].nodes[_goalIndex] = Node{ 0.f, _goalIndex, _generation };
+    _sides[Backward].open.push (_goalIndex, diagonalDist (goal.x, goal.y, start.x, start.y), 0.f);
+
+    // Every cell ever closed was either expanded by one side or proven useless, so once a side
+    // runs dry nothing is left that could shorten the best path.
+    while (!_sides[Forward].open.empty() && !_sides[Backward].open.empty())
+    {
+        if (pollCancel (cancel, _stats.expanded + 1))
+        {
+            _stats.cancelled = true;
+            return false;
+        }
+
+        const Direction direction = _sides[Backward].open.size() < _sides[Forward].open.size() ? Backward : Forward;
+        expand (map, direction);
+    }
+
+    if (_bestCost == INFINITY)
+        return false;
+
+    _pathCost = _bestCost;
+
+    for (uint32_t index = _meeting; ; index = _sides[Forward].nodes[index].parent)
+    {
+        GridPoint p;
+        map.coords (index, p.x, p.y);
+        path.push_back (p);
+        if (index == _startIndex)
+            break;
+    }
+    std::reverse (path.begin(), path.end());
+
+    for (uint32_t index = _meeting; index != _goalIndex; )
+    {
+        index = _sides[Backward].nodes[index].parent;
+        GridPoint p;
+        map.coords (index, p.x, p.y);
+        path.push_back (p);
+    }
+    return true;
+}
+
+} // BE namespace
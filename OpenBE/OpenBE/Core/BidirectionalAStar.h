@@ -0,0 +1,105 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+
+namespace BE {
+
+/**
+ * Bidirectional 8-connected A* over an occupancy grid: NBA* (Pijls & Post),
+ * searching from start towards goal and from goal towards start with the
+ * octile heuristic until no open cell can improve on the best meeting.
+ *
+ * A cell popped by either side is closed for both. It is expanded only if a
+ * path through it could still beat the best one, judged by its own side's
+ * heuristic and by the smallest key left on the other side; so each side
+ * prunes most of what the other one has already covered and paths stay
+ * optimal like A*'s. Gains are largest where walls mislead the heuristic
+ * from one end, e.g. rooms joined by corridors.
+ *
+ * Ties are broken deterministically, so equal queries return the same path:
+ * - each open set pops the lowest key, then the largest cost so far, then the
+ *   cell whose key was set first;
+ * - the side with the smaller open set expands next, the forward side on a tie;
+ * - the meeting point only moves for a strictly cheaper path.
+ *
+ * Moves follow AStar: into any free cell, diagonals included unless the corner
+ * rule forbids them; the start may be blocked, the goal may not. The map must
+ * carry a guard band of at least one blocked cell. One instance should be used
+ * by one thread at a time.
+ */
+class BidirectionalAStar
+{
+public:
+    /**
+     * Search from start to goal. On success fills path with every cell from
+     * start to goal inclusive and returns true.
+     * Gives up and returns false once cancel is raised.
+     */
+    bool findPath (const Grid<unsigned char>& map, GridPoint start, GridPoint goal, std::vector<GridPoint>& path,
+                   const CancelFlag* cancel = nullptr);
+
+    /** Whether diagonal steps may squeeze between two blocked cells; CutCorners by default. */
+    void setCornerRule (CornerRule rule) { _cornerRule = rule; }
+    CornerRule cornerRule () const { return _cornerRule; }
+
+    /** Cost of the last path found. */
+    float pathCost () const { return _pathCost; }
+
+    /** Counters of the last search, both directions together; pruned cells are not counted as expanded. */
+    const SearchStats& stats () const { return _stats; }
+
+private:
+    enum Direction
+    {
+        Forward = 0,
+        Backward = 1
+    };
+
+    struct Node
+    {
+        float cost;
+        uint32_t parent;
+        uint32_t generation;
+    };
+
+    struct Side
+    {
+        std::vector<Node> nodes;
+        IndexedHeap open;
+    };
+
+    void reset (size_t nodeCount);
+
+    /** Close the top cell of one side and expand it unless pruned, lowering _bestCost where it touches the other side. */
+    void expand (const Grid<unsigned char>& map, Direction direction);
+
+    bool reached (Direction direction, uint32_t node) const { return _sides[direction].nodes[node].generation == _generation; }
+
+    Side _sides[2];
+    std::vector<uint32_t> _closed;  // generation at which either side closed the cell
+    NeighborKernel _kernel;
+    CornerRule _cornerRule = CutCorners;
+    GridPoint _start;
+    GridPoint _goal;
+    uint32_t _startIndex = 0;
+    uint32_t _goalIndex = 0;
+    uint32_t _generation = 0;
+    float _bestCost = 0.f;
+    uint32_t _meeting = 0;
+    float _pathCost = 0.f;
+    SearchStats _stats;
+};
+
+} // BE namespace
@@ -0,0 +1,182 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "CoarseToFinePlanner.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace BE {
+
+namespace {
+
+    // Corridor on the map itself when the first one holds no path, in level 1 cells.
+    const int kWideCorridorRadius = 4;
+
+} // anonymous
+
+const int CoarseToFinePlanner::kDefaultLevel;
+const int CoarseToFinePlanner::kCorridorRadius;
+constexpr float CoarseToFinePlanner::kMixedCellCost;
+
+bool CoarseToFinePlanner::findPath (const Grid<unsigned char>& map, const OccupancyPyramid& pyramid, GridPoint start,
+                                    GridPoint goal, std::vector<GridPoint>& path, const CancelFlag* cancel, int level)
+{
+    path.clear();
+    _pathCost = 0.f;
+    _stats = SearchStats();
+    _corridorMisses = 0;
+    if (!map.inBounds (start.x, start.y) || !map.inBounds (goal.x, goal.y)
+        || isBlocked (map(start.x, start.y)) || isBlocked (map(goal.x, goal.y)))
+        return false;
+
+    level = std::min (level, pyramid.levelCount() - 1);
+    if (level <= 0)
+    {
+        const bool found = _fine.findPath (map, start, goal, path, cancel);
+        addFineStats();
+        return found;
+    }
+    if ((int)_levels.size() <= level)
+        _levels.resize (level + 1);
+
+    // Every free route on the map crosses unblocked cells of every level, so no route on the top level means no path at all.
+    if (!searchLevel (pyramid, level, GridPoint{ start.x >> level, start.y >> level },
+                      GridPoint{ goal.x >> level, goal.y >> level }, nullptr, cancel))
+        return false;
+
+    for (int finer = level - 1; finer >= 1; finer--)
+    {
+        buildCorridor (pyramid, finer + 1, kCorridorRadius);
+        const GridPoint from = { start.x >> finer, start.y >> finer };
+        const GridPoint to = { goal.x >> finer, goal.y >> finer };
+        if (searchLevel (pyramid, finer, from, to, &_levels[finer + 1].corridor, cancel))
+            continue;
+        if (_stats.cancelled)
+            return false;
+
+        _corridorMisses++;
+        if (!searchLevel (pyramid, finer, from, to, nullptr, cancel))
+            return false;
+    }
+
+    buildCorridor (pyramid, 1, kCorridorRadius);
+    bool found = _fine.findPath (map, start, goal, path, cancel, nullptr, &_levels[1].corridor);
+    addFineStats();
+    if (!found && !_stats.cancelled)
+    {
+        _corridorMisses++;
+        buildCorridor (pyramid, 1, kWideCorridorRadius);
+        found = _fine.findPath (map, start, goal, path, cancel, nullptr, &_levels[1].corridor);
+        addFineStats();
+    }
+    if (!found && !_stats.cancelled)
+    {
+        _corridorMisses++;
+        found = _fine.findPath (map, start, goal, path, cancel);
+        addFineStats();
+    }
+
+    _pathCost = found ? _fine.pathCost() : 0.f;
+    return found;
+}
+
+void CoarseToFinePlanner::addFineStats ()
+{
+    _stats.expanded += _fine.stats().expanded;
+    _stats.pushed += _fine.stats().pushed;
+    _stats.reopened += _fine.stats().reopened;
+    _stats.cancelled = _fine.stats().cancelled;
+}
+
+void CoarseToFinePlanner::buildCorridor (const OccupancyPyramid& pyramid, int level, int radius)
+{
+    Level& search = _levels[level];
+    const Grid<unsigned char>& cells = pyramid.minimum (level);
+    search.corridor.reset (cells.width(), cells.height(), 1);
+    for (const GridPoint& cell : search.path)
+        search.corridor.add (cell.x, cell.y, radius);
+}
+
+bool CoarseToFinePlanner::searchLevel (const OccupancyPyramid& pyramid, int level, GridPoint start, GridPoint goal,
+                                       const Corridor* corridor, const CancelFlag* cancel)
+{
+    const Grid<unsigned char>& minimum = pyramid.minimum (level);
+    assert(minimum.border() >= 1);
+
+    Level& search = _levels[level];
+    search.path.clear();
+    search.nodes.resize (minimum.capacity());
+    search.open.reset (minimum.capacity());
+
+    const NeighborKernel kernel (minimum.stride());
+
+    const uint32_t startIndex = (uint32_t)minimum.index (start.x, start.y);
+    const uint32_t goalIndex = (uint32_t)minimum.index (goal.x, goal.y);
+    search.nodes[startIndex] = Node{ 0.f, startIndex };
+    search.open.push (startIndex, 0.f);
+
+    bool found = false;
+    size_t expanded = 0;
+    while (!search.open.empty())
+    {
+        const uint32_t current = search.open.pop();
+        expanded++;
+        if (pollCancel (cancel, expanded))
+        {
+            _stats.cancelled = true;
+            break;
+        }
+        if (current == goalIndex)
+        {
+            found = true;
+            break;
+        }
+
+        int cx, cy;
+        minimum.coords (current, cx, cy);
+        const float currentCost = search.nodes[current].cost;
+
+        for (int i = 0; i < NeighborKernel::kSize; i++)
+        {
+            const uint32_t neighbor = (uint32_t)(current + kernel.offset[i]);
+            const int nx = cx + kernel.dx[i];
+            const int ny = cy + kernel.dy[i];
+
+            // Guard cells are blocked, so the corridor is only asked about cells of the level.
+            const OccupancyPyramid::CellState state = pyramid.state (level, nx, ny);
+            if (state == OccupancyPyramid::BlockedCell || (corridor && !corridor->contains (nx, ny)))
+                continue;
+            // The heuristic is consistent, so settled cells are final.
+            if (search.open.seen (neighbor) && !search.open.contains (neighbor))
+                continue;
+
+            const float cost = currentCost + kernel.cost[i] * (state == OccupancyPyramid::MixedCell ? kMixedCellCost : 1.f);
+            if (!search.open.seen (neighbor) || cost < search.nodes[neighbor].cost)
+            {
+                search.nodes[neighbor] = Node{ cost, current };
+                search.open.push (neighbor, cost + diagonalDist (goal.x, goal.y, nx, ny));
+            }
+        }
+    }
+    _stats.expanded += expanded;
+
+    if (!found)
+        return false;
+
+    for (uint32_t index = goalIndex; ; index = search.nodes[index].parent)
+    {
+        GridPoint cell;
+        minimum.coords (index, cell.x, cell.y);
+        search.path.push_back (cell);
+        if (index == startIndex)
+            break;
+    }
+    return true;
+}
+
+} // BE namespace
@@ -0,0 +1,98 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "AStar.h"
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+#include "OccupancyPyramid.h"
+
+namespace BE {
+
+/**
+ * Coarse-to-fine planner over an OccupancyPyramid.
+ *
+ * A query first runs A* on a coarse level of the pyramid, where blocked cells
+ * are impassable and mixed cells cost kMixedCellCost times more, so routes
+ * prefer cells that are surely free. Each finer level down to the map itself
+ * is then searched only inside a corridor of kCorridorRadius cells around the
+ * route found one level up.
+ *
+ * Mixed cells may hide a wall, and dilated walls thinner than a coarse cell
+ * only show up as blocked a few levels down. A level whose corridor holds no
+ * route is searched again without one; a level is a quarter the size of the
+ * one below, so that costs little until the map itself, where the corridor
+ * is first widened. A path is found whenever one exists.
+ *
+ * Paths are the shortest within the final corridor, near-optimal rather than
+ * optimal; the fine search expands a few cells per path cell instead of a
+ * region of the map.
+ */
+class CoarseToFinePlanner
+{
+public:
+    static const int kDefaultLevel = 4;
+    static const int kCorridorRadius = 1;
+    static constexpr float kMixedCellCost = 1.5f;
+
+    /**
+     * Search from start to goal on map, starting from the given level of
+     * pyramid, which must be built from map. On success fills path with every
+     * cell from start to goal inclusive and returns true. Gives up and returns
+     * false once cancel is raised.
+     */
+    bool findPath (const Grid<unsigned char>& map, const OccupancyPyramid& pyramid, GridPoint start, GridPoint goal,
+                   std::vector<GridPoint>& path, const CancelFlag* cancel = nullptr, int level = kDefaultLevel);
+
+    /** Cost of the last path found. */
+    float pathCost () const { return _pathCost; }
+
+    /** Counters of the last search; `expanded` sums the expansions of every level. */
+    const SearchStats& stats () const { return _stats; }
+
+    /** Searches of the last query whose corridor held no route, so they were repeated on a wider area. */
+    int corridorMisses () const { return _corridorMisses; }
+
+private:
+    struct Node
+    {
+        float cost;
+        uint32_t parent;
+    };
+
+    /** Search state of one pyramid level, kept per level so none is resized between queries. */
+    struct Level
+    {
+        std::vector<Node> nodes;
+        IndexedHeap open;
+        std::vector<GridPoint> path;    // route found on this level, goal first
+        Corridor corridor;              // around path, for the level below
+    };
+
+    /** A* over the cells of level into its path, inside corridor if given. */
+    bool searchLevel (const OccupancyPyramid& pyramid, int level, GridPoint start, GridPoint goal,
+                      const Corridor* corridor, const CancelFlag* cancel);
+
+    /** Fill the corridor of level around its path. */
+    void buildCorridor (const OccupancyPyramid& pyramid, int level, int radius);
+
+    void addFineStats ();
+
+    std::vector<Level> _levels;     // index 0 unused, the map is searched by _fine
+    AStar _fine;
+
+    float _pathCost = 0.f;
+    SearchStats _stats;
+    int _corridorMisses = 0;
+};
+
+} // BE namespace
@@ -0,0 +1,416 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "ConnectedComponents.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace BE {
+
+namespace {
+
+    inline bool isFree (unsigned char value) { return value != 255; }
+
+    /**
+     * Union-find over provisional labels. Roots always point at the smaller
+     * label, so every label's parent is no larger than itself.
+     */
+    inline uint32_t findRoot (std::vector<uint32_t>& parent, uint32_t label)
+    {
+        uint32_t root = label;
+        while (parent[root] != root)
+            root = parent[root];
+        while (parent[label] != root)
+        {
+            const uint32_t next = parent[label];
+            parent[label] = root;
+            label = next;
+        }
+        return root;
+    }
+
+    inline uint32_t unite (std::vector<uint32_t>& parent, uint32_t a, uint32_t b)
+    {
+        a = findRoot (parent, a);
+        b = findRoot (parent, b);
+        if (a < b)
+            std::swap (a, b);
+        parent[a] = b;
+        return b;
+    }
+
+    /**
+     * First pass over rows [y0, y1). Provisional labels start at firstLabel, so
+     * strips never share labels and can run concurrently.
+     */
+    void labelStrip (const Grid<unsigned char>& map, Grid<uint32_t>& labels, std::vector<uint32_t>& parent,
+                     int y0, int y1, uint32_t firstLabel)
+    {
+        const int width = map.width();
+        uint32_t nextLabel = firstLabel;
+
+        for (int y = y0; y < y1; y++)
+        {
+            const unsigned char* src = map.row (y);
+            const unsigned char* srcAbove = map.row (y - 1);
+            uint32_t* dst = labels.row (y);
+            const uint32_t* dstAbove = labels.row (y - 1);
+            const bool hasAbove = y > y0;
+
+            for (int x = 0; x < width; x++)
+            {
+                if (!isFree (src[x]))
+                {
+                    dst[x] = 0;
+                    continue;
+                }
+
+                // Previously labelled neighbours: W, NW, N, NE.
+                uint32_t label = 0;
+                if (x > 0 && isFree (src[x - 1]))
+                    label = dst[x - 1];
+                if (hasAbove)
+                {
+                    for (int dx = -1; dx <= 1; dx++)
+                    {
+                        if (x + dx < 0 || x + dx >= width || !isFree (srcAbove[x + dx]))
+                            continue;
+                        label = label ? unite (parent, label, dstAbove[x + dx]) : dstAbove[x + dx];
+                    }
+                }
+
+                if (label == 0)
+                {
+                    label = nextLabel++;
+                    parent[label] = label;
+                }
+                dst[x] = label;
+            }
+        }
+    }
+
+} // anonymous
+
+uint32_t labelConnectedComponents (const Grid<unsigned char>& map, Grid<uint32_t>& labels, unsigned threads)
+{
+    const int width = map.width();
+    const int height = map.height();
+    if (labels.width() != width || labels.height() != height)
+        labels.resize (width, height, 1, 0);
+    if (width == 0 || height == 0)
+        return 0;
+
+    if (threads == 0)
+        threads = std::max (1u, std::thread::hardware_concurrency());
+    const int strips = std::max (1, std::min ((int)threads, height / 32));
+
+    // A strip starting at row y can use labels y * width + 1 onwards, one per cell at most.
+    std::vector<uint32_t> parent ((size_t)width * height + 1, 0);
+    std::vector<int> stripStart (strips + 1);
+    for (int i = 0; i <= strips; i++)
+        stripStart[i] = (int)((int64_t)height * i / strips);
+
+    if (strips == 1)
+    {
+        labelStrip (map, labels, parent, 0, height, 1);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < strips; i++)
+        {
+            const int y0 = stripStart[i], y1 = stripStart[i + 1];
+            workers.emplace_back ([&, y0, y1] { labelStrip (map, labels, parent, y0, y1, (uint32_t)y0 * width + 1); });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+
+        // Stitch the strips together along each seam.
+        for (int i = 1; i < strips; i++)
+        {
+            const int y = stripStart[i];
+            const unsigned char* src = map.row (y);
+            const unsigned char* srcAbove = map.row (y - 1);
+            const uint32_t* dst = labels.row (y);
+            const uint32_t* dstAbove = labels.row (y - 1);
+            for (int x = 0; x < width; x++)
+            {
+                if (!isFree (src[x]))
+                    continue;
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    if (x + dx >= 0 && x + dx < width && isFree (srcAbove[x + dx]))
+                        unite (parent, dst[x], dstAbove[x + dx]);
+                }
+            }
+        }
+    }
+
+    // Parents never exceed their label, so one ascending sweep resolves every root
+    // and numbers them in raster order of their first cell.
+    uint32_t count = 0;
+    for (size_t label = 1; label < parent.size(); label++)
+    {
+        const uint32_t p = parent[label];
+        if (p == 0)
+            continue; // never handed out
+        parent[label] = p == label ? ++count : parent[p];
+    }
+
+    auto finish = [&](int y0, int y1)
+    {
+        for (int y = y0; y < y1; y++)
+        {
+            uint32_t* dst = labels.row (y);
+            for (int x = 0; x < width; x++)
+                dst[x] = parent[dst[x]];
+        }
+    };
+
+    if (strips == 1)
+    {
+        finish (0, height);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < strips; i++)
+            workers.emplace_back (finish, stripStart[i], stripStart[i + 1]);
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+
+void ComponentRelabeller::reset (const Grid<uint32_t>& labels)
+{
+    _labelSizes.assign (1, 0);
+    for (int y = 0; y < labels.height(); y++)
+    {
+        const uint32_t* row = labels.row (y);
+        for (int x = 0; x < labels.width(); x++)
+        {
+            if (row[x] >= _labelSizes.size())
+                _labelSizes.resize (row[x] + 1, 0);
+            _labelSizes[row[x]]++;
+        }
+    }
+
+    _visited.assign (labels.capacity(), 0);
+    _generation = 0;
+}
+
+uint32_t ComponentRelabeller::largestComponent () const
+{
+    uint32_t best = 0;
+    for (uint32_t label = 1; label < _labelSizes.size(); label++)
+    {
+        if (_labelSizes[label] > 0 && (best == 0 || _labelSizes[label] > _labelSizes[best]))
+            best = label;
+    }
+    return best;
+}
+
+uint32_t ComponentRelabeller::freshLabel ()
+{
+    _labelSizes.push_back (0);
+    return (uint32_t)_labelSizes.size() - 1;
+}
+
+void ComponentRelabeller::relabel (const Grid<unsigned char>& dilated, Grid<uint32_t>& labels, GridRect region)
+{
+    if (_visited.size() != labels.capacity())
+        reset (labels);
+    if (++_generation == 0)
+    {
+        std::fill (_visited.begin(), _visited.end(), 0);
+        _generation = 1;
+    }
+
+    // Obstacles inside the region lose their label; the one-cell ring seeds the pieces next to them.
+    const GridRect inner = region.clipped (labels.width(), labels.height());
+    for (int y = inner.y0; y < inner.y1; y++)
+    {
+        for (int x = inner.x0; x < inner.x1; x++)
+        {
+            if (dilated(x, y) == 255 && labels(x, y) != 0)
+            {
+                _labelSizes[labels(x, y)]--;
+                _labelSizes[0]++;
+                labels(x, y) = 0;
+            }
+        }
+    }
+
+    struct Piece
+    {
+        size_t begin, end;
+    };
+    std::vector<size_t> cells;
+    std::vector<Piece> pieces;
+
+    const GridRect seeds = region.expanded (1).clipped (labels.width(), labels.height());
+    for (int sy = seeds.y0; sy < seeds.y1; sy++)
+    {
+        for (int sx = seeds.x0; sx < seeds.x1; sx++)
+        {
+            const size_t seed = labels.index (sx, sy);
+            if (dilated(sx, sy) == 255 || _visited[seed] == _generation)
+                continue;
+
+            // Flood the whole 8-connected free region around the seed.
+            Piece piece = { cells.size(), cells.size() };
+            _visited[seed] = _generation;
+            cells.push_back (seed);
+            for (size_t i = piece.begin; i < cells.size(); i++)
+            {
+                int x, y;
+                labels.coords (cells[i], x, y);
+                for (int dy = -1; dy <= 1; dy++)
+                {
+                    for (int dx = -1; dx <= 1; dx++)
+                    {
+                        const int nx = x + dx, ny = y + dy;
+                        if (!labels.inBounds (nx, ny) || dilated(nx, ny) == 255)
+                            continue;
+                        const size_t neighbor = labels.index (nx, ny);
+                        if (_visited[neighbor] == _generation)
+                            continue;
+                        _visited[neighbor] = _generation;
+                        cells.push_back (neighbor);
+                    }
+                }
+            }
+            piece.end = cells.size();
+            pieces.push_back (piece);
+        }
+    }
+
+    // Largest pieces pick first, each keeping the label most of its cells already had.
+    std::sort (pieces.begin(), pieces.end(), [](const Piece& a, const Piece& b) { return a.end - a.begin > b.end - b.begin; });
+
+    _counts.resize (_labelSizes.size(), 0);
+    _claimed.assign (_labelSizes.size(), 0);
+    for (const Piece& piece : pieces)
+    {
+        uint32_t label = 0;
+        for (size_t i = piece.begin; i < piece.end; i++)
+        {
+            const uint32_t old = labels[cells[i]];
+            if (old == 0 || _claimed[old])
+                continue;
+            if (++_counts[old] > _counts[label] || label == 0)
+                label = old;
+        }
+        for (size_t i = piece.begin; i < piece.end; i++)
+            _counts[labels[cells[i]]] = 0;
+
+        if (label == 0)
+        {
+            label = freshLabel();
+            _claimed.push_back (0);
+            _counts.push_back (0);
+        }
+        _claimed[label] = 1;
+
+        for (size_t i = piece.begin; i < piece.end; i++)
+        {
+            uint32_t& cell = labels[cells[i]];
+            _labelSizes[cell]--;
+            _labelSizes[label]++;
+            cell = label;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void NearestComponentCells::invalidate ()
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+    _entries.clear();
+}
+
+bool NearestComponentCells::nearest (const Grid<uint32_t>& labels, uint32_t component, GridPoint target, GridPoint& result)
+{
+    const int width = labels.width();
+    const int height = labels.height();
+    if (component == 0 || width == 0 || height == 0)
+        return false;
+
+    if (!labels.inBounds (target.x, target.y))
+    {
+        // Rare enough that a scan is fine; first strictly closer cell wins, like the old search.
+        int64_t bestDistSq = -1;
+        for (int y = 0; y < height; y++)
+        {
+            const uint32_t* row = labels.row (y);
+            for (int x = 0; x < width; x++)
+            {
+                if (row[x] != component)
+                    continue;
+                const int64_t distSq = (int64_t)(x - target.x) * (x - target.x) + (int64_t)(y - target.y) * (y - target.y);
+                if (bestDistSq < 0 || distSq < bestDistSq)
+                {
+                    bestDistSq = distSq;
+                    result.x = x;
+                    result.y = y;
+                }
+            }
+        }
+        return bestDistSq >= 0;
+    }
+
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    Entry* entry = nullptr;
+    for (Entry& candidate : _entries)
+    {
+        if (candidate.component == component)
+            entry = &candidate;
+    }
+
+    if (entry == nullptr)
+    {
+        if (_entries.size() < kMaxCached)
+        {
+            _entries.emplace_back();
+            entry = &_entries.back();
+        }
+        else
+        {
+            entry = &*std::min_element (_entries.begin(), _entries.end(),
+                                        [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+        }
+
+        entry->component = component;
+        _transform.computeMatching (labels, labels.bounds(), [component](uint32_t label) { return label == component; });
+        entry->nearest.resize ((size_t)width * height);
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                GridPoint cell;
+                entry->nearest[(size_t)y * width + x] = _transform.nearest (x, y, cell) ? cell.y * width + cell.x : -1;
+            }
+        }
+    }
+    entry->lastUse = ++_clock;
+
+    const int32_t index = entry->nearest[(size_t)target.y * width + target.x];
+    if (index < 0)
+        return false;
+    result.x = index % width;
+    result.y = index / width;
+    return true;
+}
+
+} // BE namespace
@@ -0,0 +1,105 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "DistanceTransform.h"
+#include "Grid.h"
+
+namespace BE {
+
+/**
+ * Connected component labels of the dilated occupancy map: 0 for obstacles
+ * (255), any other value names an 8-connected free region.
+ */
+
+/**
+ * Label every free region of map from scratch and return how many there are.
+ *
+ * Two-pass labelling with an array-based union-find. The map is cut into
+ * horizontal strips labelled concurrently on `threads` threads (0 picks one
+ * per core), whose label sets are then merged along the seams. Labels are
+ * numbered 1..count in the raster order of each region's first cell, so the
+ * result does not depend on the number of threads.
+ */
+uint32_t labelConnectedComponents (const Grid<unsigned char>& map, Grid<uint32_t>& labels, unsigned threads = 0);
+
+/**
+ * Keeps the connected component labels in sync with local map edits.
+ */
+class ComponentRelabeller
+{
+public:
+    /** Take over an existing label grid and count how often each label is used. */
+    void reset (const Grid<uint32_t>& labels);
+
+    /**
+     * Re-flood every component touching region after the dilated map changed
+     * there. Components that split keep their label on the largest piece and
+     * get fresh labels elsewhere; components that merge share one label.
+     * Cost is proportional to the size of the touched components.
+     */
+    void relabel (const Grid<unsigned char>& dilated, Grid<uint32_t>& labels, GridRect region);
+
+    /** One more than the largest label in use. */
+    uint32_t labelCount () const { return (uint32_t)_labelSizes.size(); }
+
+    /** Label covering the most cells, or 0 if there is no free cell. */
+    uint32_t largestComponent () const;
+
+private:
+    uint32_t freshLabel ();
+
+    std::vector<size_t> _labelSizes;
+    std::vector<uint32_t> _visited;
+    uint32_t _generation = 0;
+
+    // Per-piece label histogram scratch, indexed by label.
+    std::vector<size_t> _counts;
+    std::vector<uint32_t> _claimed;
+};
+
+/**
+ * Closest cell of a given component to any point of the map, in O(1).
+ *
+ * The first query for a component builds its feature transform (the nearest
+ * component cell for every map cell) in O(map area); later queries are a
+ * lookup. Only the few most recently used components are kept. Safe to query
+ * from several threads; invalidate() whenever the labels change.
+ */
+class NearestComponentCells
+{
+public:
+    void invalidate ();
+
+    /**
+     * Closest cell labelled component to target, by Euclidean distance. Targets
+     * off the map fall back to a scan. Returns false if the component is empty.
+     */
+    bool nearest (const Grid<uint32_t>& labels, uint32_t component, GridPoint target, GridPoint& result);
+
+private:
+    static const size_t kMaxCached = 2;
+
+    struct Entry
+    {
+        uint32_t component = 0;
+        uint64_t lastUse = 0;
+        std::vector<int32_t> nearest;  // row-major map index of the closest cell, -1 if none
+    };
+
+    std::mutex _mutex;
+    std::vector<Entry> _entries;
+    uint64_t _clock = 0;
+    DistanceTransform _transform;
+};
+
+} // BE namespace
@@ -0,0 +1,269 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "DStarLite.h"
+
+#include <cassert>
+#include <limits>
+
+namespace BE {
+
+namespace {
+
+    const float kInfinity = std::numeric_limits<float>::infinity();
+
+} // anonymous
+
+void DStarLite::initialize (const Grid<unsigned char>& map, GridPoint start, GridPoint goal)
+{
+    assert(map.border() >= 1);
+    assert(map.inBounds (start.x, start.y) && map.inBounds (goal.x, goal.y));
+
+    _map = &map;
+    _start = start;
+    _goal = goal;
+    _startIndex = (uint32_t)map.index (start.x, start.y);
+    _goalIndex = (uint32_t)map.index (goal.x, goal.y);
+    _km = 0.f;
+
+    _kernel.setStride (map.stride());
+
+    if (_states.size() != map.capacity() || ++_generation == 0)
+    {
+        _states.assign (map.capacity(), State{ kInfinity, kInfinity, 0 });
+        _generation = 1;
+    }
+    _open.reset (map.capacity());
+    _stats = SearchStats();
+
+    state (_goalIndex).rhs = 0.f;
+    _open.push (_goalIndex, heuristic (_goalIndex), 0.f);
+}
+
+DStarLite::State& DStarLite::state (uint32_t node)
+{
+    State& s = _states[node];
+    if (s.generation != _generation)
+    {
+        s.g = kInfinity;
+        s.rhs = kInfinity;
+        s.generation = _generation;
+    }
+    return s;
+}
+
+float DStarLite::g (uint32_t node) const
+{
+    const State& s = _states[node];
+    return s.generation == _generation ? s.g : kInfinity;
+}
+
+float DStarLite::heuristic (uint32_t node) const
+{
+    int x, y;
+    _map->coords (node, x, y);
+    return diagonalDist (_start.x, _start.y, x, y);
+}
+
+float DStarLite::lookahead (uint32_t node) const
+{
+    const Grid<unsigned char>& map = *_map;
+    float best = kInfinity;
+    for (int i = 0; i < NeighborKernel::kSize; i++)
+    {
+        const uint32_t neighbor = (uint32_t)(node + _kernel.offset[i]);
+        if (isBlocked (map[neighbor]))
+            continue;
+        best = std::min(best, _kernel.cost[i] + g (neighbor));
+    }
+    return best;
+}
+
+void DStarLite::updateVertex (uint32_t node)
+{
+    const State& s = state (node);
+    if (s.g != s.rhs)
+    {
+        const float k2 = std::min(s.g, s.rhs);
+        _open.push (node, k2 + heuristic (node) + _km, k2);
+        _stats.pushed++;
+    }
+    else
+    {
+        _open.erase (node);
+    }
+}
+
+void DStarLite::moveStart (GridPoint start)
+{
+    assert(isInitialized());
+    _km += diagonalDist (_start.x, _start.y, start.x, start.y);
+    _start = start;
+    _startIndex = (uint32_t)_map->index (start.x, start.y);
+}
+
+void DStarLite::cellChanged (int x, int y)
+{
+    assert(isInitialized());
+
+    // Only edges entering the cell changed cost, so only its neighbours need a new rhs.
+    const uint32_t cell = (uint32_t)_map->index (x, y);
+    for (int i = 0; i < NeighborKernel::kSize; i++)
+    {
+        const uint32_t neighbor = (uint32_t)(cell + _kernel.offset[i]);
+        if (neighbor == _goalIndex || !_map->inBounds (x + _kernel.dx[i], y + _kernel.dy[i]))
+            continue;
+        state (neighbor).rhs = lookahead (neighbor);
+        updateVertex (neighbor);
+    }
+}
+
+bool DStarLite::computeShortestPath (const CancelFlag* cancel)
+{
+    const Grid<unsigned char>& map = *_map;
+
+    while (!_open.empty())
+    {
+        const State& startState = state (_startIndex);
+        const float startK2 = std::min(startState.g, startState.rhs);
+        const float startK1 = startK2 + _km; // heuristic of the start to itself is zero
+        const float topK1 = _open.topKey();
+        const float topK2 = _open.topSecondaryKey();
+        const bool topBelowStart = topK1 < startK1 || (topK1 == startK1 && topK2 < startK2);
+        if (!topBelowStart && startState.rhs == startState.g)
+            break;
+
+        const uint32_t current = _open.top();
+        State& currentState = state (current);
+        const float k2 = std::min(currentState.g, currentState.rhs);
+        const float k1 = k2 + heuristic (current) + _km;
+
+        if (topK1 < k1 || (topK1 == k1 && topK2 < k2))
+        {
+            // Key went stale when the start moved; requeue it with the current one.
+            _open.push (current, k1, k2);
+            _stats.pushed++;
+            continue;
+        }
+
+        _open.pop();
+        _stats.expanded++;
+
+        if (pollCancel (cancel, _stats.expanded))
+        {
+            // Put it back so the next repair picks up where this one stopped.
+            _open.push (current, k1, k2);
+            _stats.cancelled = true;
+            return false;
+        }
+
+        // Nothing can be entered through a blocked cell, so it never improves its predecessors.
+        const bool currentBlocked = isBlocked (map[current]);
+        int x, y;
+        map.coords (current, x, y);
+
+        if (currentState.g > currentState.rhs)
+        {
+            currentState.g = currentState.rhs;
+            if (currentBlocked)
+                continue;
+
+            for (int i = 0; i < NeighborKernel::kSize; i++)
+            {
+                // Guard cells never get a value, so lookahead() is never asked about their outer neighbours.
+                const uint32_t neighbor = (uint32_t)(current + _kernel.offset[i]);
+                if (neighbor == _goalIndex || !map.inBounds (x + _kernel.dx[i], y + _kernel.dy[i]))
+                    continue;
+                State& neighborState = state (neighbor);
+                const float cost = _kernel.cost[i] + currentState.g;
+                if (cost < neighborState.rhs)
+                {
+                    neighborState.rhs = cost;
+                    updateVertex (neighbor);
+                }
+            }
+        }
+        else
+        {
+            const float oldG = currentState.g;
+            currentState.g = kInfinity;
+            if (current != _goalIndex)
+                currentState.rhs = lookahead (current);
+            updateVertex (current);
+
+            if (currentBlocked)
+                continue;
+
+            for (int i = 0; i < NeighborKernel::kSize; i++)
+            {
+                const uint32_t neighbor = (uint32_t)(current + _kernel.offset[i]);
+                if (neighbor == _goalIndex || !map.inBounds (x + _kernel.dx[i], y + _kernel.dy[i]))
+                    continue;
+                State& neighborState = state (neighbor);
+                if (neighborState.rhs == _kernel.cost[i] + oldG)
+                {
+                    neighborState.rhs = lookahead (neighbor);
+                    updateVertex (neighbor);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool DStarLite::findPath (std::vector<GridPoint>& path, const CancelFlag* cancel)
+{
+    assert(isInitialized());
+    path.clear();
+    _stats = SearchStats();
+    _pathCost = 0.f;
+
+    if (!computeShortestPath (cancel))
+        return false;
+
+    const float startCost = g (_startIndex);
+    if (startCost == kInfinity)
+        return false;
+    _pathCost = startCost;
+
+    // Descend the cost-to-goal field, taking the first best neighbour like AStar would.
+    const Grid<unsigned char>& map = *_map;
+    uint32_t current = _startIndex;
+    path.push_back (_start);
+    while (current != _goalIndex)
+    {
+        uint32_t next = current;
+        float best = kInfinity;
+        for (int i = 0; i < NeighborKernel::kSize; i++)
+        {
+            const uint32_t neighbor = (uint32_t)(current + _kernel.offset[i]);
+            if (isBlocked (map[neighbor]))
+                continue;
+            const float cost = _kernel.cost[i] + g (neighbor);
+            if (cost < best)
+            {
+                best = cost;
+                next = neighbor;
+            }
+        }
+
+        // Rounding can only create plateaus, never dead ends; the length guard catches anything else.
+        if (next == current || path.size() > map.capacity())
+        {
+            path.clear();
+            return false;
+        }
+
+        current = next;
+        GridPoint p;
+        map.coords (current, p.x, p.y);
+        path.push_back (p);
+    }
+    return true;
+}
+
+} // BE namespace
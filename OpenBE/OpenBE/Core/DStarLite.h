@@ -0,0 +1,110 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+
+namespace BE {
+
+/**
+ * Incremental 8-connected planner (D* Lite, Koenig & Likhachev) over an
+ * occupancy grid.
+ *
+ * The search runs backwards from the goal and keeps its cost-to-goal values
+ * between queries. When the robot moves, or when cells of the map switch
+ * between free and blocked, only the part of the search tree affected by the
+ * change is repaired, instead of planning again from scratch.
+ *
+ * Moving into a blocked cell is not allowed, leaving one is; this matches
+ * AStar. Path costs agree with AStar up to float rounding.
+ *
+ * The map must outlive the planner and keep a guard band of at least one
+ * blocked cell. One instance should be used by one thread at a time.
+ */
+class DStarLite
+{
+public:
+    /**
+     * Start planning towards a new goal, dropping all previous search state.
+     */
+    void initialize (const Grid<unsigned char>& map, GridPoint start, GridPoint goal);
+
+    bool isInitialized () const { return _map != nullptr; }
+
+    /** Forget the map, e.g. before it is reallocated. */
+    void invalidate () { _map = nullptr; }
+
+    GridPoint start () const { return _start; }
+    GridPoint goal () const { return _goal; }
+
+    /** The robot is now at start; the goal is unchanged. */
+    void moveStart (GridPoint start);
+
+    /**
+     * Cell (x, y) of the map switched between free and blocked. Call once per
+     * changed cell after updating the map, before the next findPath().
+     */
+    void cellChanged (int x, int y);
+
+    /**
+     * Repair the search and extract the path from the current start to the
+     * goal. On success fills path with every cell from start to goal inclusive
+     * and returns true.
+     *
+     * Raising cancel stops the repair early and returns false; the search
+     * state stays consistent and the next call carries on from there.
+     */
+    bool findPath (std::vector<GridPoint>& path, const CancelFlag* cancel = nullptr);
+
+    /** Cost of the last path found. */
+    float pathCost () const { return _pathCost; }
+
+    /** Counters of the last repair; they are not reset by moveStart() or cellChanged(). */
+    const SearchStats& stats () const { return _stats; }
+
+private:
+    struct State
+    {
+        float g;
+        float rhs;
+        uint32_t generation;
+    };
+
+    State& state (uint32_t node);
+    float g (uint32_t node) const;
+    float heuristic (uint32_t node) const;
+
+    /** Best one-step lookahead cost from node to the goal. */
+    float lookahead (uint32_t node) const;
+
+    void updateVertex (uint32_t node);
+    /** False if cancelled before the start was settled. */
+    bool computeShortestPath (const CancelFlag* cancel);
+
+    const Grid<unsigned char>* _map = nullptr;
+    GridPoint _start = { 0, 0 };
+    GridPoint _goal = { 0, 0 };
+    uint32_t _startIndex = 0;
+    uint32_t _goalIndex = 0;
+    float _km = 0.f;
+
+    NeighborKernel _kernel;
+
+    std::vector<State> _states;
+    IndexedHeap _open;
+    uint32_t _generation = 0;
+    float _pathCost = 0.f;
+    SearchStats _stats;
+};
+
+} // BE namespace
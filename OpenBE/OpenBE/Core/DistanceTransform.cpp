@@ -0,0 +1,145 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "DistanceTransform.h"
+
+#include <algorithm>
+
+namespace BE {
+
+namespace {
+
+    // Floor division; the separator numerator may be negative.
+    inline int32_t floorDiv (int32_t a, int32_t b)
+    {
+        const int32_t q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+} // anonymous
+
+bool DistanceTransform::prepare (GridRect window)
+{
+    _window = window;
+    if (window.empty())
+    {
+        _distances.clear();
+        _features.clear();
+        return false;
+    }
+
+    const int width = window.x1 - window.x0;
+    const int height = window.y1 - window.y0;
+    _infinity = width + height;
+    _distances.resize ((size_t)width * height);
+    _features.resize ((size_t)width * height);
+    return true;
+}
+
+void DistanceTransform::solve ()
+{
+    const int width = _window.x1 - _window.x0;
+    const int height = _window.y1 - _window.y0;
+    const int32_t infinity = _infinity;
+
+    // Column pass: vertical distance to the nearest feature, top-down then bottom-up.
+    // _features holds the row of that feature for now.
+    for (int j = 0; j < height; j++)
+    {
+        int32_t* dist = _distances.data() + (size_t)j * width;
+        int32_t* feature = _features.data() + (size_t)j * width;
+        const int32_t* distAbove = dist - width;
+        const int32_t* featureAbove = feature - width;
+        for (int i = 0; i < width; i++)
+        {
+            if (dist[i] == 0)
+            {
+                feature[i] = j;
+            }
+            else if (j > 0 && distAbove[i] < infinity)
+            {
+                dist[i] = distAbove[i] + 1;
+                feature[i] = featureAbove[i];
+            }
+        }
+    }
+    for (int j = height - 2; j >= 0; j--)
+    {
+        int32_t* dist = _distances.data() + (size_t)j * width;
+        int32_t* feature = _features.data() + (size_t)j * width;
+        const int32_t* distBelow = dist + width;
+        const int32_t* featureBelow = feature + width;
+        for (int i = 0; i < width; i++)
+        {
+            if (distBelow[i] + 1 < dist[i])
+            {
+                dist[i] = distBelow[i] + 1;
+                feature[i] = featureBelow[i];
+            }
+        }
+    }
+
+    // Row pass: lower envelope of the parabolas (x - i)^2 + column(i)^2.
+    _column.resize (width);
+    _columnFeature.resize (width);
+    _sites.resize (width);
+    _starts.resize (width);
+    for (int j = 0; j < height; j++)
+    {
+        int32_t* dist = _distances.data() + (size_t)j * width;
+        int32_t* feature = _features.data() + (size_t)j * width;
+        for (int i = 0; i < width; i++)
+        {
+            _column[i] = dist[i] * dist[i];
+            _columnFeature[i] = feature[i];
+        }
+
+        const int32_t* g2 = _column.data();
+        int q = 0;
+        _sites[0] = 0;
+        _starts[0] = 0;
+        for (int u = 1; u < width; u++)
+        {
+            while (q >= 0)
+            {
+                const int32_t s = _sites[q];
+                const int32_t t = _starts[q];
+                if ((t - s) * (t - s) + g2[s] <= (t - u) * (t - u) + g2[u])
+                    break;
+                q--;
+            }
+
+            if (q < 0)
+            {
+                q = 0;
+                _sites[0] = u;
+            }
+            else
+            {
+                const int32_t s = _sites[q];
+                const int32_t w = 1 + floorDiv (u*u - s*s + g2[u] - g2[s], 2 * (u - s));
+                if (w < width)
+                {
+                    q++;
+                    _sites[q] = u;
+                    _starts[q] = w;
+                }
+            }
+        }
+
+        for (int u = width - 1; u >= 0; u--)
+        {
+            const int32_t s = _sites[q];
+            dist[u] = (u - s) * (u - s) + g2[s];
+            feature[u] = _columnFeature[s] * width + s;
+            if (u == _starts[q])
+                q--;
+        }
+    }
+}
+
+} // BE namespace
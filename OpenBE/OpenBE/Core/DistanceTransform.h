@@ -0,0 +1,107 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+
+namespace BE {
+
+/**
+ * Exact squared Euclidean distance and feature transform (Meijster et al.)
+ * over a window of a grid.
+ *
+ * Runs in O(window area) whatever the distances involved: a column pass
+ * sweeping whole rows at a time (so the inner loop vectorizes), then a lower
+ * envelope of parabolas along each row. Distances are kept as exact integers,
+ * and each cell also records which feature cell is closest.
+ *
+ * The window may reach into the grid's guard band; cells outside the window
+ * are ignored, so a cell's result is only exact when its nearest feature
+ * lies inside the window.
+ */
+class DistanceTransform
+{
+public:
+    /**
+     * Compute, for every cell of window, the squared distance to the nearest
+     * cell of window whose value is at least threshold.
+     */
+    void compute (const Grid<unsigned char>& source, GridRect window, unsigned char threshold)
+    {
+        computeMatching (source, window, [threshold](unsigned char value) { return value >= threshold; });
+    }
+
+    /**
+     * Same, with features picked by isFeature(value).
+     */
+    template <typename T, typename IsFeature>
+    void computeMatching (const Grid<T>& source, GridRect window, IsFeature isFeature)
+    {
+        if (!prepare (window))
+            return;
+        const int width = window.x1 - window.x0;
+        for (int j = 0; j < window.y1 - window.y0; j++)
+        {
+            const T* src = source.row (window.y0 + j) + window.x0;
+            int32_t* dst = _distances.data() + (size_t)j * width;
+            for (int i = 0; i < width; i++)
+                dst[i] = isFeature (src[i]) ? 0 : _infinity;
+        }
+        solve();
+    }
+
+    const GridRect& window () const { return _window; }
+
+    /** Squared distance to the nearest feature; huge when the window holds none. */
+    int32_t squaredDistance (int x, int y) const { return row (y)[x]; }
+
+    /** Row y of the distances, indexed by grid x. */
+    const int32_t* row (int y) const
+    {
+        return _distances.data() + (size_t)(y - _window.y0) * (_window.x1 - _window.x0) - _window.x0;
+    }
+
+    /**
+     * Nearest feature cell to (x, y). Returns false if the window holds no
+     * feature at all.
+     */
+    bool nearest (int x, int y, GridPoint& feature) const
+    {
+        const size_t cell = (size_t)(y - _window.y0) * (_window.x1 - _window.x0) + (x - _window.x0);
+        if (_distances[cell] >= _infinity * _infinity)
+            return false;
+        const int32_t index = _features[cell];
+        const int width = _window.x1 - _window.x0;
+        feature.x = _window.x0 + index % width;
+        feature.y = _window.y0 + index / width;
+        return true;
+    }
+
+private:
+    /** Size the buffers for window; false if it is empty. */
+    bool prepare (GridRect window);
+
+    /** Column and row passes over the feature mask left in _distances. */
+    void solve ();
+
+    GridRect _window = { 0, 0, 0, 0 };
+    int32_t _infinity = 0;
+    std::vector<int32_t> _distances;
+    std::vector<int32_t> _features;  // nearest feature as an index into the window
+
+    // Row pass scratch.
+    std::vector<int32_t> _column;
+    std::vector<int32_t> _columnFeature;
+    std::vector<int32_t> _sites;
+    std::vector<int32_t> _starts;
+};
+
+} // BE namespace
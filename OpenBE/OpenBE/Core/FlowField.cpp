@@ -0,0 +1,179 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "FlowField.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace BE {
+
+namespace {
+
+    const float kInfinity = std::numeric_limits<float>::infinity();
+
+} // anonymous
+
+const int FlowField::kDefaultRepairMargin;
+const uint8_t FlowField::kAtGoal;
+const uint8_t FlowField::kUnreachable;
+
+// Opposite directions sit at i and 7 - i.
+const int FlowField::kStepDx[8] = { -1, -1, -1,  0, 0,  1, 1, 1 };
+const int FlowField::kStepDy[8] = { -1,  0,  1, -1, 1, -1, 0, 1 };
+
+float FlowField::edgeCost (uint32_t from, uint32_t to, int direction) const
+{
+    const float length = (kStepDx[direction] == 0 || kStepDy[direction] == 0) ? kStraightCost : kDiagonalCost;
+    const Grid<unsigned char>& costs = *_costs;
+    return length * (1.f + _costWeight * (float)(costs[from] + costs[to]) * (1.f / 510.f));
+}
+
+void FlowField::propagate (const GridRect& window)
+{
+    const Grid<unsigned char>& map = *_map;
+
+    while (!_open.empty())
+    {
+        const uint32_t current = _open.pop();
+        _stats.expanded++;
+
+        int cx, cy;
+        map.coords (current, cx, cy);
+        const float value = _values[current];
+
+        for (int i = 0; i < 8; i++)
+        {
+            const uint32_t neighbor = (uint32_t)(current + _offsets[i]);
+            if (isBlocked (map[neighbor]) || !window.contains (cx + kStepDx[i], cy + kStepDy[i]))
+                continue;
+
+            const float candidate = value + edgeCost (current, neighbor, i);
+            if (candidate < _values[neighbor])
+            {
+                _values[neighbor] = candidate;
+                _next[neighbor] = (uint8_t)(7 - i);
+                _open.push (neighbor, candidate);
+                _stats.pushed++;
+            }
+        }
+    }
+}
+
+void FlowField::build (const Grid<unsigned char>& map, const Grid<unsigned char>& costs, GridPoint goal, float costWeight)
+{
+    assert(map.border() >= 1);
+    assert(costs.width() == map.width() && costs.height() == map.height() && costs.border() == map.border());
+
+    _map = &map;
+    _costs = &costs;
+    _costWeight = costWeight;
+    _width = map.width();
+    _height = map.height();
+    _border = map.border();
+    _stride = map.stride();
+    for (int i = 0; i < 8; i++)
+        _offsets[i] = (ptrdiff_t)kStepDy[i] * map.stride() + kStepDx[i];
+
+    _goal = goal;
+    _offset = 0.f;
+    _slack = 0.f;
+    _values.assign (map.capacity(), kInfinity);
+    _next.assign (map.capacity(), kUnreachable);
+    _open.reset (map.capacity());
+    _stats = SearchStats();
+
+    if (!map.inBounds (goal.x, goal.y) || isBlocked (map(goal.x, goal.y)))
+        return;
+
+    const uint32_t goalIndex = (uint32_t)map.index (goal.x, goal.y);
+    _values[goalIndex] = 0.f;
+    _next[goalIndex] = kAtGoal;
+    _open.push (goalIndex, 0.f);
+    propagate (map.bounds());
+}
+
+bool FlowField::moveGoal (GridPoint goal, int margin)
+{
+    assert(isBuilt());
+    const Grid<unsigned char>& map = *_map;
+    if (goal == _goal)
+        return true;
+
+    const GridRect window = GridRect{ std::min (goal.x, _goal.x), std::min (goal.y, _goal.y),
+                                      std::max (goal.x, _goal.x) + 1, std::max (goal.y, _goal.y) + 1 }
+                                .expanded (margin).clipped (_width, _height);
+
+    // The field already holds a best route from the new goal back to the old one; reversed,
+    // it leads from the old goal to the new. It must stay inside the window to be repaired.
+    bool connected = map.inBounds (goal.x, goal.y) && _next[map.index (goal.x, goal.y)] < kAtGoal;
+    const uint32_t oldGoalIndex = (uint32_t)map.index (_goal.x, _goal.y);
+    uint32_t towardsNewGoal = oldGoalIndex;
+    for (uint32_t cell = connected ? (uint32_t)map.index (goal.x, goal.y) : oldGoalIndex; cell != oldGoalIndex; )
+    {
+        int x, y;
+        map.coords (cell, x, y);
+        if (!window.contains (x, y))
+        {
+            connected = false;
+            break;
+        }
+        towardsNewGoal = cell;
+        cell = (uint32_t)(cell + _offsets[_next[cell]]);
+    }
+    if (!connected)
+    {
+        build (map, *_costs, goal, _costWeight);
+        return false;
+    }
+
+    // Each repair can make routes from outside the window up to twice the goal distance
+    // longer than optimal; rebuild once that adds up to more than the margin.
+    const uint32_t goalIndex = (uint32_t)map.index (goal.x, goal.y);
+    const float goalDistance = _values[goalIndex] + _offset;
+    if (_slack + 2.f * goalDistance > margin)
+    {
+        build (map, *_costs, goal, _costWeight);
+        return false;
+    }
+
+    // Cells that are not reached below now cost their old value plus the old goal to new goal
+    // distance: shift them all at once, then sweep from the new goal only through cells that
+    // improve on that. Those cells' best routes only pass through improved cells, so the sweep
+    // finds all of them.
+    _offset += goalDistance;
+    _slack += 2.f * goalDistance;
+    _goal = goal;
+    _open.reset (map.capacity());
+    _stats = SearchStats();
+
+    _values[goalIndex] = -_offset;
+    _next[goalIndex] = kAtGoal;
+    _open.push (goalIndex, _values[goalIndex]);
+    propagate (window);
+
+    // The old goal keeps its cost, so the sweep may leave it without a direction.
+    if (_next[oldGoalIndex] == kAtGoal)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            if ((uint32_t)(oldGoalIndex + _offsets[i]) == towardsNewGoal)
+                _next[oldGoalIndex] = (uint8_t)i;
+        }
+    }
+    return true;
+}
+
+float FlowField::distance (int x, int y) const
+{
+    if (!_map || x < 0 || y < 0 || x >= _width || y >= _height)
+        return kInfinity;
+    return _values[(size_t)(y + _border) * _stride + (x + _border)] + _offset;
+}
+
+} // BE namespace
@@ -0,0 +1,119 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+
+namespace BE {
+
+/**
+ * Navigation field towards one goal, shared by any number of agents.
+ *
+ * A single Dijkstra sweep outwards from the goal records, for every reachable
+ * cell, its cost to the goal and which neighbour to step to next. Agents then
+ * follow the field with an O(1) lookup per cell instead of each running its
+ * own search.
+ *
+ * Steps are 8-connected like AStar's. Stepping between cells a and b costs the
+ * step length times 1 + weight * (costs(a) + costs(b)) / 510, so a topo map
+ * keeps agents away from walls; the cost is symmetric.
+ *
+ * When the goal moves a few cells, moveGoal() repairs the field instead of
+ * sweeping the whole map again. The maps must outlive the field and keep a
+ * guard band of at least one blocked cell; copies share them.
+ */
+class FlowField
+{
+public:
+    /** Margin around the old and new goal that moveGoal() repairs by default. */
+    static const int kDefaultRepairMargin = 48;
+
+    /**
+     * Sweep the whole map from goal. Cells of map at or above kBlockedThreshold
+     * are obstacles; costs must have the same size and border as map.
+     */
+    void build (const Grid<unsigned char>& map, const Grid<unsigned char>& costs, GridPoint goal, float costWeight = 1.f);
+
+    bool isBuilt () const { return _map != nullptr; }
+
+    GridPoint goal () const { return _goal; }
+
+    /**
+     * Move the goal, re-sweeping only cells within margin of the old and new
+     * goal that get strictly closer to it. Cells outside that window keep
+     * routing through the old goal, so their paths cost at most what going to
+     * the old goal and on to the new one would; with a margin covering the
+     * map the repaired field is exact.
+     *
+     * Successive repairs never leave a path more than margin longer than in
+     * an exact field: past that, or when the goals are not connected within
+     * the window, this falls back to a full build and returns false.
+     */
+    bool moveGoal (GridPoint goal, int margin = kDefaultRepairMargin);
+
+    /**
+     * Step (dx, dy) to take from cell (x, y) towards the goal. Returns false at
+     * the goal, off the map, or where the goal cannot be reached.
+     */
+    bool step (int x, int y, int& dx, int& dy) const
+    {
+        if (!_map || x < 0 || y < 0 || x >= _width || y >= _height)
+            return false;
+        const uint8_t next = _next[(size_t)(y + _border) * _stride + (x + _border)];
+        if (next >= 8)
+            return false;
+        dx = kStepDx[next];
+        dy = kStepDy[next];
+        return true;
+    }
+
+    /** Cost from cell (x, y) to the goal; infinite where it cannot be reached. */
+    float distance (int x, int y) const;
+
+    /** Counters of the last build or repair; `expanded` counts settled cells. */
+    const SearchStats& stats () const { return _stats; }
+
+private:
+    static const uint8_t kAtGoal = 8;
+    static const uint8_t kUnreachable = 255;
+    static const int kStepDx[8];
+    static const int kStepDy[8];
+
+    float edgeCost (uint32_t from, uint32_t to, int direction) const;
+
+    /** Dijkstra from the open set, only lowering cells inside window. */
+    void propagate (const GridRect& window);
+
+    const Grid<unsigned char>* _map = nullptr;
+    const Grid<unsigned char>* _costs = nullptr;
+    float _costWeight = 1.f;
+    int _width = 0;
+    int _height = 0;
+    int _border = 0;
+    size_t _stride = 0;
+    ptrdiff_t _offsets[8];
+
+    GridPoint _goal = { 0, 0 };
+
+    // Costs to the goal are stored relative to _offset, so a repair can shift
+    // every cell it does not touch at once.
+    std::vector<float> _values;
+    std::vector<uint8_t> _next;  // index into kStepDx/kStepDy, or kAtGoal / kUnreachable
+    float _offset = 0.f;
+    float _slack = 0.f;  // bound on the extra cost repairs have left outside their windows
+
+    IndexedHeap _open;
+    SearchStats _stats;
+};
+
+} // BE namespace
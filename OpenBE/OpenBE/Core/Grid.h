@@ -0,0 +1,243 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace BE {
+
+/**
+ * Minimal allocator handing out cache-line aligned blocks, so every grid row
+ * can start on a cache line boundary.
+ */
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    template <typename U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator () = default;
+    template <typename U> AlignedAllocator (const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate (size_t n)
+    {
+        void* p = nullptr;
+        if (posix_memalign (&p, Alignment, std::max<size_t>(n * sizeof(T), Alignment)) != 0)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    void deallocate (T* p, size_t) { free (p); }
+
+    template <typename U> bool operator== (const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U> bool operator!= (const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+/**
+ * Integer cell coordinate on a Grid.
+ */
+struct GridPoint
+{
+    int x, y;
+
+    bool operator== (const GridPoint& rhs) const { return x == rhs.x && y == rhs.y; }
+    bool operator!= (const GridPoint& rhs) const { return !(*this == rhs); }
+};
+
+/**
+ * Half-open cell rectangle [x0, x1) x [y0, y1).
+ */
+struct GridRect
+{
+    int x0, y0, x1, y1;
+
+    bool empty () const { return x1 <= x0 || y1 <= y0; }
+    bool contains (int x, int y) const { return x >= x0 && y >= y0 && x < x1 && y < y1; }
+
+    GridRect expanded (int margin) const { return GridRect{ x0 - margin, y0 - margin, x1 + margin, y1 + margin }; }
+
+    GridRect clipped (int width, int height) const
+    {
+        return GridRect{ std::max (x0, 0), std::max (y0, 0), std::min (x1, width), std::min (y1, height) };
+    }
+
+    GridRect intersected (const GridRect& other) const
+    {
+        return GridRect{ std::max (x0, other.x0), std::max (y0, other.y0), std::min (x1, other.x1), std::min (y1, other.y1) };
+    }
+
+    /** Smallest rectangle covering both; an empty rectangle is ignored. */
+    GridRect united (const GridRect& other) const
+    {
+        if (empty()) return other;
+        if (other.empty()) return *this;
+        return GridRect{ std::min (x0, other.x0), std::min (y0, other.y0), std::max (x1, other.x1), std::max (y1, other.y1) };
+    }
+};
+
+/**
+ * Packed world position, laid out like GLKVector3 so buffers of them can be
+ * handed to Objective-C and SceneKit without conversion.
+ */
+struct Float3
+{
+    float x, y, z;
+};
+
+static_assert(sizeof(Float3) == 3 * sizeof(float), "Float3 must stay packed");
+
+/**
+ * Mapping between grid cells and world coordinates: grid x runs along world
+ * x, grid y along world z, and y is up.
+ */
+struct GridTransform
+{
+    float originX = 0.f;    // world position of the centre of cell (0, 0)
+    float originZ = 0.f;
+    float cellSize = 1.f;   // meters per cell
+
+    GridPoint toGrid (float x, float z) const
+    {
+        return GridPoint{ (int)lroundf ((x - originX) / cellSize), (int)lroundf ((z - originZ) / cellSize) };
+    }
+
+    Float3 toWorld (float gx, float gy, float y = 0.f) const
+    {
+        return Float3{ originX + gx * cellSize, y, originZ + gy * cellSize };
+    }
+};
+
+/**
+ * Contiguous, row-major 2D grid used by the path planner.
+ *
+ * Cells are addressed as (x, y) with y selecting the row, so scanning y outer /
+ * x inner walks memory linearly. The grid is surrounded by `border` guard
+ * cells on every side; (x, y) is valid for -border <= x < width + border, which
+ * lets stencils and neighbour expansion skip bounds checks when the guard band
+ * is filled with a sentinel value. Each row is padded so allocated rows, guard
+ * cells included, start on a cache line; with a border, cell (0, y) sits
+ * `border` cells past that.
+ */
+template <typename T>
+class Grid
+{
+public:
+    Grid () = default;
+
+    Grid (int width, int height, int border = 0, T value = T())
+    {
+        resize (width, height, border, value);
+    }
+
+    /**
+     * Reallocate the grid, filling every cell (guards included) with value.
+     */
+    void resize (int width, int height, int border = 0, T value = T())
+    {
+        const int rowBytes = 64;
+        const int rowAlign = std::max<int> (1, rowBytes / (int)sizeof(T));
+
+        _width = width;
+        _height = height;
+        _border = border;
+        _stride = ((width + 2*border + rowAlign - 1) / rowAlign) * rowAlign;
+        _cells.assign ((size_t)_stride * (height + 2*border), value);
+        _origin = (size_t)border * _stride + border;
+    }
+
+    /**
+     * Copy dimensions and contents from another grid, possibly of a different
+     * cell type or guard width. Guard cells are set to borderValue.
+     */
+    template <typename U>
+    void copy (const Grid<U>& source, int border, T borderValue)
+    {
+        resize (source.width(), source.height(), border, borderValue);
+        for (int y = 0; y < _height; ++y)
+        {
+            const U* src = source.row (y);
+            T* dst = row (y);
+            for (int x = 0; x < _width; ++x)
+                dst[x] = (T)src[x];
+        }
+    }
+
+    void copy (const Grid<T>& source) { *this = source; }
+
+    /** Fill interior cells and guard cells alike. */
+    void fill (T value) { std::fill (_cells.begin(), _cells.end(), value); }
+
+    /** Overwrite only the guard band around the interior. */
+    void fillBorder (T value)
+    {
+        for (int y = -_border; y < _height + _border; ++y)
+        {
+            T* r = row (y);
+            if (y < 0 || y >= _height)
+            {
+                std::fill (r - _border, r + _width + _border, value);
+            }
+            else
+            {
+                std::fill (r - _border, r, value);
+                std::fill (r + _width, r + _width + _border, value);
+            }
+        }
+    }
+
+    bool inBounds (int x, int y) const { return x >= 0 && y >= 0 && x < _width && y < _height; }
+
+    GridRect bounds () const { return GridRect{ 0, 0, _width, _height }; }
+
+    T& operator() (int x, int y) { return _cells[index (x, y)]; }
+    const T& operator() (int x, int y) const { return _cells[index (x, y)]; }
+
+    /** Linear index of a cell, valid for guard cells too. */
+    size_t index (int x, int y) const { return _origin + (ptrdiff_t)y * _stride + x; }
+
+    /** Inverse of index(). */
+    void coords (size_t index, int& x, int& y) const
+    {
+        y = (int)(index / _stride) - _border;
+        x = (int)(index % _stride) - _border;
+    }
+
+    T& operator[] (size_t index) { return _cells[index]; }
+    const T& operator[] (size_t index) const { return _cells[index]; }
+
+    /** Pointer to cell (0, y); guard cells are reachable with negative offsets. */
+    T* row (int y) { return _cells.data() + index (0, y); }
+    const T* row (int y) const { return _cells.data() + index (0, y); }
+
+    int width () const { return _width; }
+    int height () const { return _height; }
+    int border () const { return _border; }
+    int stride () const { return _stride; }
+
+    /** Total number of allocated cells, guards and padding included. */
+    size_t capacity () const { return _cells.size(); }
+
+    bool empty () const { return _width == 0 || _height == 0; }
+
+private:
+    std::vector<T, AlignedAllocator<T>> _cells;
+    size_t _origin = 0;
+    int _width = 0;
+    int _height = 0;
+    int _border = 0;
+    int _stride = 0;
+};
+
+} // BE namespace
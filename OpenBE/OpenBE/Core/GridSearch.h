@@ -0,0 +1,146 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+
+#include "Grid.h"
+
+namespace BE {
+
+/**
+ * Cells with a value at or above this are obstacles for the planners.
+ */
+static const unsigned char kBlockedThreshold = 254;
+
+/**
+ * Step costs of the 8-connected grid.
+ */
+static const float kStraightCost = 1.f;
+static const float kDiagonalCost = 1.414213f;
+
+/**
+ * Counters filled in by the grid searches for logging and benchmarking.
+ */
+struct SearchStats
+{
+    size_t expanded = 0;   // nodes popped from the open set
+    size_t pushed = 0;     // open set insertions and key updates
+    size_t reopened = 0;   // closed nodes reached again at a lower cost
+    bool cancelled = false; // search gave up because its CancelFlag was raised
+};
+
+/**
+ * Raised by another thread to abandon a running search. Searches poll it every
+ * kCancelPollInterval expansions and then fail as if no path existed.
+ */
+typedef std::atomic<bool> CancelFlag;
+
+static const size_t kCancelPollInterval = 256;
+
+inline bool pollCancel (const CancelFlag* cancel, size_t expanded)
+{
+    return cancel && expanded % kCancelPollInterval == 0 && cancel->load (std::memory_order_relaxed);
+}
+
+inline bool isBlocked (unsigned char value) { return value >= kBlockedThreshold; }
+
+/**
+ * Whether a diagonal step may squeeze past obstacles on its two sides.
+ */
+enum CornerRule
+{
+    CutCorners = 0,     // a diagonal step only needs its target cell free
+    NoCornerCutting     // both cells beside a diagonal step must be free too
+};
+
+/**
+ * The eight steps from a cell to its neighbours on a map of a given row
+ * stride: flat index offsets with their dx, dy and cost, plus the two cells a
+ * diagonal passes between. Kept by value in the searches, so expanding a
+ * cell allocates nothing, and on a map with a guard band of one blocked cell
+ * needs no bounds checks. No step is (0, 0).
+ *
+ * The order is the one the searches have always used, so ties resolve
+ * identically: dx -1, 0, 1 in turn, dy -1, 0, 1 within each.
+ */
+struct NeighborKernel
+{
+    static const int kSize = 8;
+
+    int dx[kSize];
+    int dy[kSize];
+    float cost[kSize];
+    ptrdiff_t offset[kSize];
+    ptrdiff_t sideX[kSize];     // the cell passed horizontally, offset itself for straight steps
+    ptrdiff_t sideY[kSize];     // the cell passed vertically, offset itself for straight steps
+
+    NeighborKernel () { setStride (0); }
+
+    explicit NeighborKernel (ptrdiff_t stride) { setStride (stride); }
+
+    void setStride (ptrdiff_t stride)
+    {
+        int i = 0;
+        for (int x = -1; x <= 1; x++)
+        {
+            for (int y = -1; y <= 1; y++)
+            {
+                if (x == 0 && y == 0)
+                    continue;
+                dx[i] = x;
+                dy[i] = y;
+                cost[i] = (x == 0 || y == 0) ? kStraightCost : kDiagonalCost;
+                offset[i] = (ptrdiff_t)y * stride + x;
+                sideX[i] = x == 0 || y == 0 ? offset[i] : x;
+                sideY[i] = x == 0 || y == 0 ? offset[i] : (ptrdiff_t)y * stride;
+                i++;
+            }
+        }
+    }
+
+    bool isDiagonal (int i) const { return dx[i] != 0 && dy[i] != 0; }
+
+    /**
+     * Whether step i between the cell at index and its neighbour keeps clear of
+     * corners under rule. Symmetric, so backward searches may ask it from either
+     * end; whether the two cells themselves are free is left to the caller.
+     */
+    template <typename Map>
+    bool passes (const Map& map, size_t index, int i, CornerRule rule) const
+    {
+        return rule == CutCorners || !isDiagonal (i)
+            || (!isBlocked (map[index + sideX[i]]) && !isBlocked (map[index + sideY[i]]));
+    }
+};
+
+/**
+ * Octile distance used as the A* heuristic. The diagonal factor sits just
+ * below kDiagonalCost so the heuristic stays consistent under float rounding.
+ */
+inline float diagonalDist (int ax, int ay, int bx, int by)
+{
+    const int dx = abs(ax - bx);
+    const int dy = abs(ay - by);
+    return (dx + dy) + (1.41412f - 2.f) * std::min(dx, dy);
+}
+
+/**
+ * Exact octile length of a straight or 45 degree run of cells.
+ */
+inline float octileCost (int dx, int dy)
+{
+    dx = abs(dx);
+    dy = abs(dy);
+    return kDiagonalCost * std::min(dx, dy) + kStraightCost * (std::max(dx, dy) - std::min(dx, dy));
+}
+
+} // BE namespace
@@ -0,0 +1,200 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "HeightField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace BE {
+
+namespace {
+
+    const size_t kLanes = 8;
+    const size_t kRowAlignment = 64 / sizeof(float);
+
+    // Corners above this have no surface, as in NavigationComponent.
+    const float kHighestSurface = HeightField::kNoHeight - 1.f;
+
+    inline float lerp (float a, float b, float t) { return a + (b - a) * t; }
+
+} // anonymous
+
+constexpr float HeightField::kNoHeight;
+
+void HeightField::reset (int width, int height, float originX, float originZ, float resolution)
+{
+    _width = std::max (width, 0);
+    _height = std::max (height, 0);
+    _originX = originX;
+    _originZ = originZ;
+    _resolution = resolution;
+
+    // One border cell on every side; rows start on a cache line.
+    _stride = ((size_t)_width + 2 + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+    _cells.assign (_stride * ((size_t)_height + 2), kNoHeight);
+}
+
+void HeightField::assign (int width, int height, float originX, float originZ, float resolution, const float* heights)
+{
+    reset (width, height, originX, originZ, resolution);
+    for (int y = 0; y < _height; y++)
+        memcpy (row (y), heights + (size_t)y * _width, sizeof(float) * _width);
+}
+
+int HeightField::cell (float coordinate, float last, float& fraction)
+{
+    // Comparisons written so NaN lands on the border too.
+    float clamped = coordinate > -1.f ? coordinate : -1.f;
+    clamped = clamped < last ? clamped : last;
+
+    const float floored = std::floor (clamped);
+    fraction = clamped - floored;
+    return (int)floored;
+}
+
+float HeightField::interpolate (float x, float z) const
+{
+    if (isEmpty())
+        return kNoHeight;
+
+    float fx, fz;
+    const int cx = cell ((x - _originX) / _resolution, (float)(_width - 1), fx);
+    const int cz = cell ((z - _originZ) / _resolution, (float)(_height - 1), fz);
+
+    const float* corner = &_cells[(size_t)(cx + 1) + (size_t)(cz + 1) * _stride];
+    const float h00 = corner[0];
+    const float h10 = corner[1];
+    const float h01 = corner[_stride];
+    const float h11 = corner[_stride + 1];
+
+    if (h00 > kHighestSurface || h10 > kHighestSurface || h01 > kHighestSurface || h11 > kHighestSurface)
+        return kNoHeight;
+    return lerp (lerp (h00, h10, fx), lerp (h01, h11, fx), fz);
+}
+
+size_t HeightField::interpolate (const float* positionsXZ, size_t count, float* heights, uint32_t* valid) const
+{
+    if (valid)
+        memset (valid, 0, sizeof(uint32_t) * ((count + 31) / 32));
+    if (isEmpty())
+    {
+        std::fill (heights, heights + count, kNoHeight);
+        return 0;
+    }
+
+    const float* cells = _cells.data();
+    const float lastX = (float)(_width - 1);
+    const float lastZ = (float)(_height - 1);
+    size_t validCount = 0;
+    size_t base = 0;
+
+#if defined(__AVX2__)
+    const __m256 originX = _mm256_set1_ps (_originX);
+    const __m256 originZ = _mm256_set1_ps (_originZ);
+    const __m256 resolution = _mm256_set1_ps (_resolution);
+    const __m256 border = _mm256_set1_ps (-1.f);
+    const __m256 lastXs = _mm256_set1_ps (lastX);
+    const __m256 lastZs = _mm256_set1_ps (lastZ);
+    const __m256 highest = _mm256_set1_ps (kHighestSurface);
+    const __m256 noHeight = _mm256_set1_ps (kNoHeight);
+    const __m256i one = _mm256_set1_epi32 (1);
+    const __m256i stride = _mm256_set1_epi32 ((int)_stride);
+
+    for (; base + kLanes <= count; base += kLanes)
+    {
+        // Split eight interleaved (x, z) pairs into x and z vectors.
+        const __m256 a = _mm256_loadu_ps (positionsXZ + 2 * base);
+        const __m256 b = _mm256_loadu_ps (positionsXZ + 2 * base + kLanes);
+        const __m256 xs = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (_mm256_shuffle_ps (a, b, 0x88)), 0xd8));
+        const __m256 zs = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (_mm256_shuffle_ps (a, b, 0xdd)), 0xd8));
+
+        // max returns its second operand for NaN, which puts it on the border.
+        const __m256 gx = _mm256_min_ps (_mm256_max_ps (_mm256_div_ps (_mm256_sub_ps (xs, originX), resolution), border), lastXs);
+        const __m256 gz = _mm256_min_ps (_mm256_max_ps (_mm256_div_ps (_mm256_sub_ps (zs, originZ), resolution), border), lastZs);
+        const __m256 floorX = _mm256_floor_ps (gx);
+        const __m256 floorZ = _mm256_floor_ps (gz);
+        const __m256 fx = _mm256_sub_ps (gx, floorX);
+        const __m256 fz = _mm256_sub_ps (gz, floorZ);
+
+        const __m256i index = _mm256_add_epi32 (_mm256_add_epi32 (_mm256_cvttps_epi32 (floorX), one),
+                                                _mm256_mullo_epi32 (_mm256_add_epi32 (_mm256_cvttps_epi32 (floorZ), one), stride));
+        const __m256 h00 = _mm256_i32gather_ps (cells, index, 4);
+        const __m256 h10 = _mm256_i32gather_ps (cells + 1, index, 4);
+        const __m256 h01 = _mm256_i32gather_ps (cells + _stride, index, 4);
+        const __m256 h11 = _mm256_i32gather_ps (cells + _stride + 1, index, 4);
+
+        const __m256 surface = _mm256_and_ps (_mm256_and_ps (_mm256_cmp_ps (h00, highest, _CMP_LE_OQ), _mm256_cmp_ps (h10, highest, _CMP_LE_OQ)),
+                                              _mm256_and_ps (_mm256_cmp_ps (h01, highest, _CMP_LE_OQ), _mm256_cmp_ps (h11, highest, _CMP_LE_OQ)));
+
+        const __m256 top = _mm256_add_ps (h00, _mm256_mul_ps (_mm256_sub_ps (h10, h00), fx));
+        const __m256 bottom = _mm256_add_ps (h01, _mm256_mul_ps (_mm256_sub_ps (h11, h01), fx));
+        const __m256 result = _mm256_add_ps (top, _mm256_mul_ps (_mm256_sub_ps (bottom, top), fz));
+        _mm256_storeu_ps (heights + base, _mm256_blendv_ps (noHeight, result, surface));
+
+        const uint32_t mask = (uint32_t)_mm256_movemask_ps (surface);
+        if (valid)
+            valid[base / 32] |= mask << (base % 32);
+        validCount += (size_t)__builtin_popcount (mask);
+    }
+#else
+    for (; base + kLanes <= count; base += kLanes)
+    {
+        // Same steps lane by lane; the compiler vectorizes everything but the loads.
+        float fx[kLanes], fz[kLanes];
+        float h00[kLanes], h10[kLanes], h01[kLanes], h11[kLanes];
+        size_t index[kLanes];
+
+        for (size_t lane = 0; lane < kLanes; lane++)
+        {
+            const int cx = cell ((positionsXZ[2 * (base + lane)] - _originX) / _resolution, lastX, fx[lane]);
+            const int cz = cell ((positionsXZ[2 * (base + lane) + 1] - _originZ) / _resolution, lastZ, fz[lane]);
+            index[lane] = (size_t)(cx + 1) + (size_t)(cz + 1) * _stride;
+        }
+        for (size_t lane = 0; lane < kLanes; lane++)
+        {
+            h00[lane] = cells[index[lane]];
+            h10[lane] = cells[index[lane] + 1];
+            h01[lane] = cells[index[lane] + _stride];
+            h11[lane] = cells[index[lane] + _stride + 1];
+        }
+
+        uint32_t mask = 0;
+        for (size_t lane = 0; lane < kLanes; lane++)
+        {
+            const bool surface = h00[lane] <= kHighestSurface && h10[lane] <= kHighestSurface
+                && h01[lane] <= kHighestSurface && h11[lane] <= kHighestSurface;
+            const float result = lerp (lerp (h00[lane], h10[lane], fx[lane]), lerp (h01[lane], h11[lane], fx[lane]), fz[lane]);
+            heights[base + lane] = surface ? result : kNoHeight;
+            mask |= (uint32_t)surface << lane;
+        }
+
+        if (valid)
+            valid[base / 32] |= mask << (base % 32);
+        validCount += (size_t)__builtin_popcount (mask);
+    }
+#endif
+
+    for (; base < count; base++)
+    {
+        heights[base] = interpolate (positionsXZ[2 * base], positionsXZ[2 * base + 1]);
+        if (heights[base] < kNoHeight)
+        {
+            if (valid)
+                valid[base / 32] |= 1u << (base % 32);
+            validCount++;
+        }
+    }
+    return validCount;
+}
+
+} // BE namespace
@@ -0,0 +1,86 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+
+namespace BE {
+
+/**
+ * Finished navigation map laid out for bilinear height queries in bulk.
+ *
+ * The heights are copied into a grid with a border of kNoHeight cells and
+ * rows padded to a cache line. Query coordinates are clamped onto the
+ * border, so a position outside the map reads a border cell and comes out
+ * invalid without any bounds check. Positions are then handled eight at a
+ * time: the arithmetic vectorizes, and the four corner loads of each lane
+ * are gathers where the target has them (AVX2), plain loads elsewhere.
+ *
+ * The cells are 32-bit floats whatever the encoding of the cache the map was
+ * read from, as the gathers need them, so a map costs about 4 bytes a cell.
+ * NavigationComponent keeps this field as its only copy of a finished map
+ * and answers cell queries from it too.
+ */
+class HeightField
+{
+public:
+    static constexpr float kNoHeight = 999.f;
+
+    /** Size the grid for width x height cells starting at origin, all kNoHeight. */
+    void reset (int width, int height, float originX, float originZ, float resolution);
+
+    /** Copy width x height heights, row by row. */
+    void assign (int width, int height, float originX, float originZ, float resolution, const float* heights);
+
+    int width () const { return _width; }
+    int height () const { return _height; }
+    bool isEmpty () const { return _width == 0 || _height == 0; }
+
+    /** Height of cell (x, y); kNoHeight if it has no surface or is outside the map. */
+    float height (int x, int y) const
+    {
+        if (x < 0 || y < 0 || x >= _width || y >= _height)
+            return kNoHeight;
+        return _cells[(size_t)(y + 1) * _stride + (size_t)(x + 1)];
+    }
+
+    /** Writable row y of the map, width() cells, for filling after reset(). */
+    float* row (int y) { return &_cells[(size_t)(y + 1) * _stride + 1]; }
+
+    /** Distance in floats between rows returned by row(). */
+    size_t stride () const { return _stride; }
+
+    /**
+     * Bilinear height at count positions, given as interleaved world (x, z)
+     * pairs. A position whose four surrounding cells do not all have a
+     * surface gets kNoHeight and a clear bit i in valid, which holds
+     * (count + 31) / 32 words and may be null. Returns how many are valid.
+     */
+    size_t interpolate (const float* positionsXZ, size_t count, float* heights, uint32_t* valid = nullptr) const;
+
+    /** Bilinear height at one world position, kNoHeight if not valid. */
+    float interpolate (float x, float z) const;
+
+private:
+    /** Clamp a cell coordinate onto the border and return it with its fraction. */
+    static int cell (float coordinate, float last, float& fraction);
+
+    std::vector<float, AlignedAllocator<float>> _cells;
+    size_t _stride = 0;
+    int _width = 0;
+    int _height = 0;
+    float _originX = 0.f;
+    float _originZ = 0.f;
+    float _resolution = 1.f;
+};
+
+} // BE namespace
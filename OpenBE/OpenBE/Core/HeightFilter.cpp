@@ -0,0 +1,156 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "HeightFilter.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace BE {
+
+namespace {
+
+    // Plain comparisons rather than std::min / std::max, so the loops map to vector min / max.
+    struct MinOp
+    {
+        template <typename T>
+        T operator() (T a, T b) const { return b < a ? b : a; }
+    };
+
+    struct MaxOp
+    {
+        template <typename T>
+        T operator() (T a, T b) const { return a < b ? b : a; }
+    };
+
+    /**
+     * Running op down the columns of height rows of width samples, over
+     * windows of 2 radius + 1 rows; rows beyond the map hold pad.
+     */
+    template <typename T, typename Op>
+    void filterColumns (const T* src, T* dst, int width, int height, int radius, T pad, std::vector<T>& scratch, Op op)
+    {
+        const int window = 2 * radius + 1;
+        const int rows = (height + 2 * radius + window - 1) / window * window;    // padded to whole blocks
+        scratch.resize ((size_t)(rows + 2) * width);
+        T* padRow = scratch.data() + (size_t)rows * width;
+        T* prefix = padRow + width;
+        std::fill (padRow, padRow + width, pad);
+
+        // Padded row j is map row j - radius.
+        auto source = [&](int j) -> const T* {
+            const int y = j - radius;
+            return y >= 0 && y < height ? src + (size_t)y * width : padRow;
+        };
+
+        // Suffixes within each block, bottom-up.
+        for (int j = rows - 1; j >= 0; j--)
+        {
+            const T* in = source (j);
+            T* suffix = scratch.data() + (size_t)j * width;
+            if ((j + 1) % window == 0)
+            {
+                std::copy (in, in + width, suffix);
+                continue;
+            }
+            const T* below = suffix + width;
+            for (int i = 0; i < width; i++)
+                suffix[i] = op (in[i], below[i]);
+        }
+
+        // Prefixes within each block, top-down. The window of map row y spans padded rows
+        // y .. y + window - 1: the suffix of y's block and the prefix of the last one's.
+        for (int j = 0; j < height + window - 1; j++)
+        {
+            const T* in = source (j);
+            if (j % window == 0)
+            {
+                std::copy (in, in + width, prefix);
+            }
+            else
+            {
+                for (int i = 0; i < width; i++)
+                    prefix[i] = op (prefix[i], in[i]);
+            }
+
+            const int y = j - window + 1;
+            if (y < 0)
+                continue;
+            const T* suffix = scratch.data() + (size_t)y * width;
+            T* out = dst + (size_t)y * width;
+            for (int i = 0; i < width; i++)
+                out[i] = op (suffix[i], prefix[i]);
+        }
+    }
+
+    /** dst gets the width x height samples of src as height x width. */
+    template <typename T>
+    void transpose (const T* src, T* dst, int width, int height)
+    {
+        const int kTile = 16;
+        for (int y0 = 0; y0 < height; y0 += kTile)
+        {
+            const int y1 = std::min (height, y0 + kTile);
+            for (int x0 = 0; x0 < width; x0 += kTile)
+            {
+                const int x1 = std::min (width, x0 + kTile);
+                for (int y = y0; y < y1; y++)
+                {
+                    for (int x = x0; x < x1; x++)
+                        dst[(size_t)x * height + y] = src[(size_t)y * width + x];
+                }
+            }
+        }
+    }
+
+    /** Both passes; dst may be src. */
+    template <typename T, typename Op>
+    void filter (const T* src, T* dst, int width, int height, int radius, T pad, Op op,
+                 std::vector<T>& temp, std::vector<T>& transposed, std::vector<T>& scratch)
+    {
+        const size_t count = (size_t)width * height;
+        temp.resize (count);
+        transposed.resize (count);
+
+        filterColumns (src, temp.data(), width, height, radius, pad, scratch, op);
+        transpose (temp.data(), transposed.data(), width, height);
+        filterColumns (transposed.data(), temp.data(), height, width, radius, pad, scratch, op);
+        transpose (temp.data(), dst, height, width);
+    }
+
+} // anonymous
+
+void HeightFilter::apply (const float* heights, int width, int height, int radius, Mode mode, float noHeight)
+{
+    width = std::max (0, width);
+    height = std::max (0, height);
+    radius = std::max (0, radius);
+
+    const size_t count = (size_t)width * height;
+    _heights.resize (count);
+    _unreachable.resize (count);
+    if (count == 0)
+        return;
+
+    for (size_t i = 0; i < count; i++)
+        _unreachable[i] = heights[i] >= noHeight ? 1 : 0;
+    filter (_unreachable.data(), _unreachable.data(), width, height, radius, (uint8_t)1, MaxOp(),
+            _bytes, _transposedBytes, _suffixBytes);
+
+    if (mode == Minimum)
+    {
+        filter (heights, _heights.data(), width, height, radius, std::numeric_limits<float>::max(), MinOp(),
+                _floats, _transposedFloats, _suffixFloats);
+    }
+    else
+    {
+        filter (heights, _heights.data(), width, height, radius, std::numeric_limits<float>::lowest(), MaxOp(),
+                _floats, _transposedFloats, _suffixFloats);
+    }
+}
+
+} // BE namespace
@@ -0,0 +1,62 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace BE {
+
+/**
+ * Running minimum or maximum of a height map over square windows, used to
+ * erode the navigation map by the agent's radius.
+ *
+ * Van Herk / Gil-Werman: each pass splits the samples into blocks of one
+ * window and combines a suffix of one block with a prefix of the next, so it
+ * costs three comparisons per sample whatever the radius. The filter is
+ * separable; both passes sweep whole rows at a time so the inner loops
+ * vectorize, the second one on a transposed copy.
+ *
+ * The same passes dilate the samples at noHeight into an unreachable mask,
+ * with everything outside the map counting as noHeight.
+ */
+class HeightFilter
+{
+public:
+    enum Mode
+    {
+        Minimum = 0,
+        Maximum
+    };
+
+    /**
+     * Filter width x height samples, row by row, over the (2 radius + 1)^2
+     * window centred on each one.
+     */
+    void apply (const float* heights, int width, int height, int radius, Mode mode, float noHeight);
+
+    /** Extreme height in each sample's window, noHeight samples included. */
+    const std::vector<float>& heights () const { return _heights; }
+
+    /** 1 where the window holds a noHeight sample or reaches outside the map. */
+    const std::vector<uint8_t>& unreachable () const { return _unreachable; }
+
+private:
+    std::vector<float> _heights;
+    std::vector<uint8_t> _unreachable;
+
+    // Scratch reused across calls.
+    std::vector<float> _floats;
+    std::vector<float> _transposedFloats;
+    std::vector<float> _suffixFloats;
+    std::vector<uint8_t> _bytes;
+    std::vector<uint8_t> _transposedBytes;
+    std::vector<uint8_t> _suffixBytes;
+};
+
+} // BE namespace
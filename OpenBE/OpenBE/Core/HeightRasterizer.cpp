@@ -0,0 +1,194 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "HeightRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace BE {
+
+constexpr float HeightRasterizer::kNoHeight;
+
+namespace {
+
+    // A triangle clipped to a square has at most 7 vertices.
+    const int kMaxClipped = 8;
+
+    /** Twice the signed area of triangle (a, b, p) in the u/v plane. */
+    template <typename V>
+    inline float edge (const V& a, const V& b, float u, float v)
+    {
+        return (b.u - a.u) * (v - a.v) - (b.v - a.v) * (u - a.u);
+    }
+
+    /**
+     * Sutherland-Hodgman: keep the part of polygon in where coordinate axis
+     * (0 = u, 1 = v) is at least bound if keepAbove, else at most bound.
+     */
+    template <typename V>
+    int clip (const V* in, int count, V* out, int axis, float bound, bool keepAbove)
+    {
+        int outCount = 0;
+        for (int i = 0; i < count; i++)
+        {
+            const V& a = in[i];
+            const V& b = in[(i + 1) % count];
+            const float da = (axis == 0 ? a.u : a.v) - bound;
+            const float db = (axis == 0 ? b.u : b.v) - bound;
+            const bool insideA = keepAbove ? da >= 0.f : da <= 0.f;
+            const bool insideB = keepAbove ? db >= 0.f : db <= 0.f;
+
+            if (insideA)
+                out[outCount++] = a;
+            if (insideA != insideB)
+            {
+                const float t = da / (da - db);
+                out[outCount++] = V{ a.u + t * (b.u - a.u), a.v + t * (b.v - a.v), a.y + t * (b.y - a.y) };
+            }
+        }
+        return outCount;
+    }
+
+} // anonymous
+
+void HeightRasterizer::reset (const GridRect& window, const GridTransform& transform, float startY, float endY,
+                              Coverage coverage, bool cullBackFaces)
+{
+    _window = window;
+    _window.x1 = std::max (_window.x0, _window.x1);
+    _window.y1 = std::max (_window.y0, _window.y1);
+    _transform = transform;
+    _startY = startY;
+    _endY = endY;
+    _direction = endY < startY ? -1.f : 1.f;
+    _coverage = coverage;
+    _cullBackFaces = cullBackFaces;
+    _heights.assign ((size_t)width() * height(), kNoHeight);
+}
+
+void HeightRasterizer::addTriangles (const Float3* vertices, size_t vertexCount, const uint16_t* faces, size_t faceCount)
+{
+    for (size_t i = 0; i < faceCount; i++)
+    {
+        const uint16_t* face = faces + 3 * i;
+        if (face[0] >= vertexCount || face[1] >= vertexCount || face[2] >= vertexCount)
+            continue;
+        addTriangle (vertices[face[0]], vertices[face[1]], vertices[face[2]]);
+    }
+}
+
+void HeightRasterizer::addTriangle (const Float3& a, const Float3& b, const Float3& c)
+{
+    const float scale = 1.f / _transform.cellSize;
+    const Vertex triangle[3] = {
+        { (a.x - _transform.originX) * scale, (a.z - _transform.originZ) * scale, a.y },
+        { (b.x - _transform.originX) * scale, (b.z - _transform.originZ) * scale, b.y },
+        { (c.x - _transform.originX) * scale, (c.z - _transform.originZ) * scale, c.y },
+    };
+
+    // x cross z is -y, so a positive area in u/v means the face points down; it is hit
+    // from the front when that agrees with the direction of the segment.
+    const float area = edge (triangle[0], triangle[1], triangle[2].u, triangle[2].v);
+    if (_cullBackFaces && area * _direction < 0.f)
+        return;
+
+    if (_coverage == SampleCoverage)
+        addSampled (triangle);
+    else
+        addConservative (triangle);
+}
+
+void HeightRasterizer::addSampled (const Vertex (&t)[3])
+{
+    const float area = edge (t[0], t[1], t[2].u, t[2].v);
+    if (area == 0.f)
+        return;
+
+    const int x0 = std::max (_window.x0, (int)ceilf (std::min ({ t[0].u, t[1].u, t[2].u })));
+    const int x1 = std::min (_window.x1 - 1, (int)floorf (std::max ({ t[0].u, t[1].u, t[2].u })));
+    const int y0 = std::max (_window.y0, (int)ceilf (std::min ({ t[0].v, t[1].v, t[2].v })));
+    const int y1 = std::min (_window.y1 - 1, (int)floorf (std::max ({ t[0].v, t[1].v, t[2].v })));
+
+    const float lower = std::min (_startY, _endY);
+    const float upper = std::max (_startY, _endY);
+    const float inverseArea = 1.f / area;
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            // Barycentric weights, all of the area's sign inside the triangle or on its edges.
+            const float w0 = edge (t[1], t[2], (float)x, (float)y) * inverseArea;
+            const float w1 = edge (t[2], t[0], (float)x, (float)y) * inverseArea;
+            const float w2 = edge (t[0], t[1], (float)x, (float)y) * inverseArea;
+            if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+                continue;
+
+            const float height = w0 * t[0].y + w1 * t[1].y + w2 * t[2].y;
+            if (height >= lower && height <= upper)
+                hit (x, y, height);
+        }
+    }
+}
+
+void HeightRasterizer::addConservative (const Vertex (&t)[3])
+{
+    // Cell (x, y) spans [x - 0.5, x + 0.5] x [y - 0.5, y + 0.5].
+    const int x0 = std::max (_window.x0, (int)ceilf (std::min ({ t[0].u, t[1].u, t[2].u }) - 0.5f));
+    const int x1 = std::min (_window.x1 - 1, (int)floorf (std::max ({ t[0].u, t[1].u, t[2].u }) + 0.5f));
+    if (x0 > x1)
+        return;
+
+    const float lower = std::min (_startY, _endY);
+    const float upper = std::max (_startY, _endY);
+
+    Vertex column[kMaxClipped];
+    Vertex cell[kMaxClipped];
+    Vertex scratch[kMaxClipped];
+
+    for (int x = x0; x <= x1; x++)
+    {
+        // Clip to the column once, then each of its rows.
+        int count = clip (t, 3, scratch, 0, x - 0.5f, true);
+        count = clip (scratch, count, column, 0, x + 0.5f, false);
+        if (count == 0)
+            continue;
+
+        float minV = column[0].v;
+        float maxV = column[0].v;
+        for (int i = 1; i < count; i++)
+        {
+            minV = std::min (minV, column[i].v);
+            maxV = std::max (maxV, column[i].v);
+        }
+        const int y0 = std::max (_window.y0, (int)ceilf (minV - 0.5f));
+        const int y1 = std::min (_window.y1 - 1, (int)floorf (maxV + 0.5f));
+
+        for (int y = y0; y <= y1; y++)
+        {
+            int cellCount = clip (column, count, scratch, 1, y - 0.5f, true);
+            cellCount = clip (scratch, cellCount, cell, 1, y + 0.5f, false);
+            if (cellCount == 0)
+                continue;
+
+            // Heights are linear over the triangle, so their range over the overlap is spanned by its vertices.
+            float minY = cell[0].y;
+            float maxY = cell[0].y;
+            for (int i = 1; i < cellCount; i++)
+            {
+                minY = std::min (minY, cell[i].y);
+                maxY = std::max (maxY, cell[i].y);
+            }
+            if (maxY < lower || minY > upper)
+                continue;
+            hit (x, y, _direction > 0.f ? std::max (minY, lower) : std::min (maxY, upper));
+        }
+    }
+}
+
+} // BE namespace
@@ -0,0 +1,103 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+
+namespace BE {
+
+/**
+ * Height map of a triangle mesh, rasterized on the CPU in one pass over its
+ * triangles instead of one ray cast per sample.
+ *
+ * Sample (x, y) lies at transform.toWorld(x, y). Its height is the surface
+ * hit first by a vertical segment from startY to endY: the largest height
+ * between them when endY is below startY, else the smallest. Samples nothing
+ * covers keep kNoHeight.
+ *
+ * With SampleCoverage a triangle counts where it covers the sample point,
+ * edges included, which reproduces the ray casts. ConservativeCoverage counts
+ * it wherever it overlaps the sample's cell, the square of one cellSize
+ * centred on it, taking its nearest height over that overlap; thin walls and
+ * edges falling between samples are never missed, so obstacles only grow.
+ *
+ * Like SceneKit hit tests, triangles whose front (counter-clockwise) side does
+ * not face startY are skipped unless cullBackFaces is off. Edge-on
+ * triangles only show up with ConservativeCoverage.
+ */
+class HeightRasterizer
+{
+public:
+    enum Coverage
+    {
+        SampleCoverage = 0,
+        ConservativeCoverage
+    };
+
+    static constexpr float kNoHeight = 999.f;
+
+    /** Start over with width x height samples, all kNoHeight. */
+    void reset (int width, int height, const GridTransform& transform, float startY, float endY,
+                Coverage coverage = ConservativeCoverage, bool cullBackFaces = true)
+    {
+        reset (GridRect{ 0, 0, width, height }, transform, startY, endY, coverage, cullBackFaces);
+    }
+
+    /**
+     * Start over with only the samples of window, for instance one tile of a
+     * larger map. They get the same heights as in a rasterization of the
+     * whole map.
+     */
+    void reset (const GridRect& window, const GridTransform& transform, float startY, float endY,
+                Coverage coverage = ConservativeCoverage, bool cullBackFaces = true);
+
+    /** Rasterize faceCount triangles, each three indices into vertices. */
+    void addTriangles (const Float3* vertices, size_t vertexCount, const uint16_t* faces, size_t faceCount);
+
+    void addTriangle (const Float3& a, const Float3& b, const Float3& c);
+
+    const GridRect& window () const { return _window; }
+    int width () const { return _window.x1 - _window.x0; }
+    int height () const { return _window.y1 - _window.y0; }
+
+    /** Heights of the window, row by row: sample (x, y) is at (x - window.x0) + (y - window.y0) * width(). */
+    const std::vector<float>& heights () const { return _heights; }
+
+private:
+    /** A triangle vertex in sample units. */
+    struct Vertex
+    {
+        float u, v, y;
+    };
+
+    /** Lower the height of sample (x, y) to y if nearer startY and within the segment. */
+    void hit (int x, int y, float height)
+    {
+        float& current = _heights[(size_t)(x - _window.x0) + (size_t)(y - _window.y0) * width()];
+        if (current == kNoHeight || (height - current) * _direction < 0.f)
+            current = height;
+    }
+
+    void addSampled (const Vertex (&triangle)[3]);
+    void addConservative (const Vertex (&triangle)[3]);
+
+    GridRect _window = { 0, 0, 0, 0 };
+    GridTransform _transform;
+    float _startY = 0.f;
+    float _endY = 0.f;
+    float _direction = 1.f;     // sign of endY - startY
+    Coverage _coverage = ConservativeCoverage;
+    bool _cullBackFaces = true;
+    std::vector<float> _heights;
+};
+
+} // BE namespace
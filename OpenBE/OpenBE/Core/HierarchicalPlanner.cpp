@@ -0,0 +1,378 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "HierarchicalPlanner.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace BE {
+
+namespace {
+
+    // Border stretches at least this long get a transition at each end instead of one in the middle.
+    const int kLongEntrance = 6;
+
+} // anonymous
+
+//------------------------------------------------------------------------------
+// ClusterSearch
+
+void HierarchicalPlanner::ClusterSearch::run (const Grid<unsigned char>& map, const GridRect& rect, GridPoint source, const GridPoint* target)
+{
+    _rect = rect;
+    const size_t cellCount = (size_t)(rect.x1 - rect.x0) * (rect.y1 - rect.y0);
+    if (_states.size() < cellCount || ++_generation == 0)
+    {
+        _states.assign (std::max (cellCount, _states.size()), State{ 0.f, 0, 0 });
+        _generation = 1;
+    }
+    _open.reset (_states.size());
+
+    const uint32_t sourceIndex = local (source.x, source.y);
+    _states[sourceIndex] = State{ 0.f, sourceIndex, _generation };
+    _open.push (sourceIndex, 0.f);
+
+    const uint32_t targetIndex = target ? local (target->x, target->y) : 0;
+    const int width = rect.x1 - rect.x0;
+    const NeighborKernel kernel (width);
+
+    while (!_open.empty())
+    {
+        const uint32_t current = _open.pop();
+        expanded++;
+        if (target && current == targetIndex)
+            return;
+
+        const int cx = rect.x0 + (int)(current % width);
+        const int cy = rect.y0 + (int)(current / width);
+        const float currentCost = _states[current].cost;
+
+        for (int i = 0; i < NeighborKernel::kSize; i++)
+        {
+            const int nx = cx + kernel.dx[i];
+            const int ny = cy + kernel.dy[i];
+            if (!rect.contains (nx, ny) || isBlocked (map(nx, ny)))
+                continue;
+
+            const uint32_t neighbor = local (nx, ny);
+            const float neighborCost = currentCost + kernel.cost[i];
+            State& state = _states[neighbor];
+            if (state.generation != _generation || neighborCost < state.cost)
+            {
+                state = State{ neighborCost, current, _generation };
+                const float heuristic = target ? diagonalDist (nx, ny, target->x, target->y) : 0.f;
+                _open.push (neighbor, neighborCost + heuristic);
+            }
+        }
+    }
+}
+
+float HierarchicalPlanner::ClusterSearch::cost (GridPoint cell) const
+{
+    if (!_rect.contains (cell.x, cell.y))
+        return -1.f;
+    const State& state = _states[local (cell.x, cell.y)];
+    return state.generation == _generation ? state.cost : -1.f;
+}
+
+void HierarchicalPlanner::ClusterSearch::appendPath (GridPoint cell, std::vector<GridPoint>& path) const
+{
+    const size_t first = path.size();
+    const int width = _rect.x1 - _rect.x0;
+    for (uint32_t index = local (cell.x, cell.y); ; index = _states[index].parent)
+    {
+        path.push_back (GridPoint{ _rect.x0 + (int)(index % width), _rect.y0 + (int)(index / width) });
+        if (_states[index].parent == index)
+            break;
+    }
+    std::reverse (path.begin() + first, path.end());
+}
+
+//------------------------------------------------------------------------------
+// Abstraction
+
+GridRect HierarchicalPlanner::clusterRect (uint32_t cluster) const
+{
+    const int cx = (int)cluster % _clustersX;
+    const int cy = (int)cluster / _clustersX;
+    GridRect rect;
+    rect.x0 = cx * _clusterSize;
+    rect.y0 = cy * _clusterSize;
+    rect.x1 = std::min (rect.x0 + _clusterSize, _map->width());
+    rect.y1 = std::min (rect.y0 + _clusterSize, _map->height());
+    return rect;
+}
+
+uint32_t HierarchicalPlanner::addNode (GridPoint cell)
+{
+    const uint32_t cluster = clusterOf (cell.x, cell.y);
+    for (uint32_t id : _clusterNodes[cluster])
+    {
+        if (_nodes[id].cell == cell)
+            return id;
+    }
+
+    const uint32_t id = (uint32_t)_nodes.size();
+    _nodes.push_back (Node{ cell, cluster, {} });
+    _clusterNodes[cluster].push_back (id);
+    return id;
+}
+
+void HierarchicalPlanner::addEntrances (int cluster, bool vertical)
+{
+    const Grid<unsigned char>& map = *_map;
+    const GridRect a = clusterRect (cluster);
+
+    // Walk the shared border; cellA is in the cluster, cellB its neighbour in the next one.
+    const int length = vertical ? (a.y1 - a.y0) : (a.x1 - a.x0);
+    auto cellA = [&](int i) { return vertical ? GridPoint{ a.x1 - 1, a.y0 + i } : GridPoint{ a.x0 + i, a.y1 - 1 }; };
+    auto cellB = [&](int i) { return vertical ? GridPoint{ a.x1, a.y0 + i } : GridPoint{ a.x0 + i, a.y1 }; };
+    auto open = [&](int i) {
+        const GridPoint pa = cellA (i), pb = cellB (i);
+        return !isBlocked (map(pa.x, pa.y)) && !isBlocked (map(pb.x, pb.y));
+    };
+
+    auto link = [&](int i) {
+        const uint32_t na = addNode (cellA (i));
+        const uint32_t nb = addNode (cellB (i));
+        _nodes[na].edges.push_back (Edge{ nb, kStraightCost });
+        _nodes[nb].edges.push_back (Edge{ na, kStraightCost });
+        _edgeCount += 2;
+    };
+
+    for (int i = 0; i < length; )
+    {
+        if (!open (i))
+        {
+            i++;
+            continue;
+        }
+
+        int end = i;
+        while (end < length && open (end))
+            end++;
+
+        if (end - i >= kLongEntrance)
+        {
+            link (i);
+            link (end - 1);
+        }
+        else
+        {
+            link ((i + end - 1) / 2);
+        }
+        i = end;
+    }
+}
+
+void HierarchicalPlanner::connectCluster (uint32_t cluster)
+{
+    const std::vector<uint32_t>& ids = _clusterNodes[cluster];
+    const GridRect rect = clusterRect (cluster);
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        _clusterSearch.run (*_map, rect, _nodes[ids[i]].cell, nullptr);
+        for (size_t j = 0; j < ids.size(); j++)
+        {
+            if (i == j)
+                continue;
+            const float cost = _clusterSearch.cost (_nodes[ids[j]].cell);
+            if (cost >= 0.f)
+            {
+                _nodes[ids[i]].edges.push_back (Edge{ ids[j], cost });
+                _edgeCount++;
+            }
+        }
+    }
+}
+
+void HierarchicalPlanner::build (const Grid<unsigned char>& map, int clusterSize)
+{
+    assert(map.border() >= 1);
+
+    _map = &map;
+    _clusterSize = std::max (2, clusterSize);
+    _clustersX = (map.width() + _clusterSize - 1) / _clusterSize;
+    _clustersY = (map.height() + _clusterSize - 1) / _clusterSize;
+
+    _nodes.clear();
+    _clusterNodes.assign ((size_t)_clustersX * _clustersY, std::vector<uint32_t>());
+    _edgeCount = 0;
+
+    for (int cy = 0; cy < _clustersY; cy++)
+    {
+        for (int cx = 0; cx < _clustersX; cx++)
+        {
+            const int cluster = cy * _clustersX + cx;
+            if (cx + 1 < _clustersX)
+                addEntrances (cluster, true);
+            if (cy + 1 < _clustersY)
+                addEntrances (cluster, false);
+        }
+    }
+
+    for (uint32_t cluster = 0; cluster < _clusterNodes.size(); cluster++)
+        connectCluster (cluster);
+
+    _abstract.assign (_nodes.size() + 2, AbstractState{ 0.f, 0, 0 });
+    _goalLinks.assign (_nodes.size(), -1.f);
+    _generation = 0;
+}
+
+//------------------------------------------------------------------------------
+// Query
+
+bool HierarchicalPlanner::findPath (GridPoint start, GridPoint goal, std::vector<GridPoint>& path, const CancelFlag* cancel)
+{
+    path.clear();
+    _stats = SearchStats();
+    _pathCost = 0.f;
+
+    if (!_map)
+        return false;
+
+    const Grid<unsigned char>& map = *_map;
+    if (!map.inBounds (start.x, start.y) || !map.inBounds (goal.x, goal.y)
+        || isBlocked (map(start.x, start.y)) || isBlocked (map(goal.x, goal.y)))
+        return false;
+
+    const uint32_t startCluster = clusterOf (start.x, start.y);
+    const uint32_t goalCluster = clusterOf (goal.x, goal.y);
+    const uint32_t startId = (uint32_t)_nodes.size();
+    const uint32_t goalId = startId + 1;
+
+    // Link the goal to the entrances of its cluster.
+    _clusterSearch.expanded = 0;
+    _clusterSearch.run (map, clusterRect (goalCluster), goal, nullptr);
+    for (uint32_t id : _clusterNodes[goalCluster])
+        _goalLinks[id] = _clusterSearch.cost (_nodes[id].cell);
+
+    // Link the start to the entrances of its cluster, and to the goal if they share one.
+    std::vector<Edge> startLinks;
+    _clusterSearch.run (map, clusterRect (startCluster), start, nullptr);
+    for (uint32_t id : _clusterNodes[startCluster])
+    {
+        const float cost = _clusterSearch.cost (_nodes[id].cell);
+        if (cost >= 0.f)
+            startLinks.push_back (Edge{ id, cost });
+    }
+    if (startCluster == goalCluster)
+    {
+        const float cost = _clusterSearch.cost (goal);
+        if (cost >= 0.f)
+            startLinks.push_back (Edge{ goalId, cost });
+    }
+
+    // A* over the abstract graph.
+    if (++_generation == 0)
+    {
+        std::fill (_abstract.begin(), _abstract.end(), AbstractState{ 0.f, 0, 0 });
+        _generation = 1;
+    }
+    _open.reset (_abstract.size());
+    _abstract[startId] = AbstractState{ 0.f, startId, _generation };
+    _open.push (startId, 0.f);
+
+    auto cellOf = [&](uint32_t id) { return id == startId ? start : (id == goalId ? goal : _nodes[id].cell); };
+    auto relax = [&](uint32_t from, uint32_t to, float edgeCost) {
+        const float cost = _abstract[from].cost + edgeCost;
+        AbstractState& state = _abstract[to];
+        if (state.generation != _generation || cost < state.cost)
+        {
+            state = AbstractState{ cost, from, _generation };
+            const GridPoint cell = cellOf (to);
+            _open.push (to, cost + diagonalDist (cell.x, cell.y, goal.x, goal.y));
+            _stats.pushed++;
+        }
+    };
+
+    bool solutionFound = false;
+    while (!_open.empty())
+    {
+        const uint32_t current = _open.pop();
+        _stats.expanded++;
+
+        if (pollCancel (cancel, _stats.expanded))
+        {
+            _stats.cancelled = true;
+            break;
+        }
+
+        if (current == goalId)
+        {
+            solutionFound = true;
+            break;
+        }
+
+        if (current == startId)
+        {
+            for (const Edge& edge : startLinks)
+                relax (current, edge.target, edge.cost);
+            continue;
+        }
+
+        for (const Edge& edge : _nodes[current].edges)
+            relax (current, edge.target, edge.cost);
+        if (_goalLinks[current] >= 0.f)
+            relax (current, goalId, _goalLinks[current]);
+    }
+
+    for (uint32_t id : _clusterNodes[goalCluster])
+        _goalLinks[id] = -1.f;
+
+    if (!solutionFound)
+    {
+        _stats.expanded += _clusterSearch.expanded;
+        return false;
+    }
+
+    _pathCost = _abstract[goalId].cost;
+
+    std::vector<uint32_t> route;
+    for (uint32_t id = goalId; ; id = _abstract[id].parent)
+    {
+        route.push_back (id);
+        if (_abstract[id].parent == id)
+            break;
+    }
+    std::reverse (route.begin(), route.end());
+
+    // Refine: entrance pairs across a border are adjacent cells, everything else stays inside one cluster.
+    auto clusterOfId = [&](uint32_t id) { return id == startId ? startCluster : (id == goalId ? goalCluster : _nodes[id].cluster); };
+
+    path.push_back (start);
+    for (size_t i = 1; i < route.size(); i++)
+    {
+        const GridPoint from = cellOf (route[i - 1]);
+        const GridPoint to = cellOf (route[i]);
+        const uint32_t cluster = clusterOfId (route[i - 1]);
+
+        if (cluster != clusterOfId (route[i]))
+        {
+            path.push_back (to);
+            continue;
+        }
+
+        if (cancel && cancel->load (std::memory_order_relaxed))
+        {
+            _stats.cancelled = true;
+            _pathCost = 0.f;
+            path.clear();
+            return false;
+        }
+
+        _clusterSearch.run (map, clusterRect (cluster), from, &to);
+        path.pop_back();
+        _clusterSearch.appendPath (to, path);
+    }
+
+    _stats.expanded += _clusterSearch.expanded;
+    return true;
+}
+
+} // BE namespace
@@ -0,0 +1,140 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+
+namespace BE {
+
+/**
+ * Hierarchical path planner (HPA*, Botea et al.) over the occupancy grid.
+ *
+ * build() cuts the map into square clusters, places entrance nodes on every
+ * free stretch of a cluster border and precomputes the cost between every pair
+ * of entrances sharing a cluster. A query connects start and goal to the
+ * entrances of their own clusters, runs A* on that small abstract graph and
+ * then refines only the clusters the abstract route passes through.
+ *
+ * Paths are near-optimal (entrances pin where routes cross cluster borders).
+ * Crossings that only exist diagonally through a cluster corner are not
+ * entrances, so callers should fall back to a flat search when a query fails.
+ */
+class HierarchicalPlanner
+{
+public:
+    /**
+     * Build the cluster abstraction. The map must outlive the planner and keep
+     * a guard band of at least one blocked cell.
+     */
+    void build (const Grid<unsigned char>& map, int clusterSize = 16);
+
+    bool isBuilt () const { return _map != nullptr; }
+
+    /**
+     * Search from start to goal. On success fills path with every cell from
+     * start to goal inclusive and returns true. Gives up and returns false
+     * once cancel is raised.
+     */
+    bool findPath (GridPoint start, GridPoint goal, std::vector<GridPoint>& path, const CancelFlag* cancel = nullptr);
+
+    /** Cost of the last path found. */
+    float pathCost () const { return _pathCost; }
+
+    /** Counters of the last search; `expanded` sums abstract and in-cluster expansions. */
+    const SearchStats& stats () const { return _stats; }
+
+    size_t nodeCount () const { return _nodes.size(); }
+    size_t edgeCount () const { return _edgeCount; }
+
+private:
+    struct Edge
+    {
+        uint32_t target;
+        float cost;
+    };
+
+    struct Node
+    {
+        GridPoint cell;
+        uint32_t cluster;
+        std::vector<Edge> edges;
+    };
+
+    /**
+     * Dijkstra restricted to one cluster; with a target it stops as soon as the
+     * target is settled.
+     */
+    class ClusterSearch
+    {
+    public:
+        void run (const Grid<unsigned char>& map, const GridRect& rect, GridPoint source, const GridPoint* target);
+
+        /** Cost to reach a cell of the last searched cluster, or a negative value. */
+        float cost (GridPoint cell) const;
+
+        /** Cells from the source to cell inclusive, appended to path. */
+        void appendPath (GridPoint cell, std::vector<GridPoint>& path) const;
+
+        size_t expanded = 0;
+
+    private:
+        struct State
+        {
+            float cost;
+            uint32_t parent;
+            uint32_t generation;
+        };
+
+        uint32_t local (int x, int y) const { return (uint32_t)((y - _rect.y0) * (_rect.x1 - _rect.x0) + (x - _rect.x0)); }
+
+        GridRect _rect = { 0, 0, 0, 0 };
+        std::vector<State> _states;
+        IndexedHeap _open;
+        uint32_t _generation = 0;
+    };
+
+    uint32_t clusterOf (int x, int y) const { return (uint32_t)((y / _clusterSize) * _clustersX + (x / _clusterSize)); }
+    GridRect clusterRect (uint32_t cluster) const;
+
+    uint32_t addNode (GridPoint cell);
+    /** Entrances across the right border of cluster if vertical, else across its bottom border. */
+    void addEntrances (int cluster, bool vertical);
+    void connectCluster (uint32_t cluster);
+
+    const Grid<unsigned char>* _map = nullptr;
+    int _clusterSize = 16;
+    int _clustersX = 0;
+    int _clustersY = 0;
+
+    std::vector<Node> _nodes;
+    std::vector<std::vector<uint32_t>> _clusterNodes;
+    size_t _edgeCount = 0;
+
+    // Abstract search scratch, sized nodes + start + goal.
+    struct AbstractState
+    {
+        float cost;
+        uint32_t parent;
+        uint32_t generation;
+    };
+    std::vector<AbstractState> _abstract;
+    std::vector<float> _goalLinks;
+    IndexedHeap _open;
+    uint32_t _generation = 0;
+
+    ClusterSearch _clusterSearch;
+    float _pathCost = 0.f;
+    SearchStats _stats;
+};
+
+} // BE namespace
@@ -0,0 +1,198 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace BE {
+
+/**
+ * Binary min-heap of node ids with decrease-key, used as the open set of the
+ * grid searches.
+ *
+ * Each node is in the heap at most once. Positions are tracked in a dense
+ * array stamped with a generation counter, so reset() is O(1) regardless of
+ * how many nodes the previous search touched. Keys compare lexicographically
+ * on (key, secondary); equal keys pop in the order they were last set (FIFO),
+ * which keeps search results deterministic.
+ */
+class IndexedHeap
+{
+public:
+    /**
+     * Empty the heap and make room for node ids in [0, nodeCount).
+     */
+    void reset (size_t nodeCount)
+    {
+        _entries.clear();
+        _sequence = 0;
+
+        if (_slots.size() != nodeCount)
+        {
+            _slots.assign (nodeCount, Slot());
+            _generation = 1;
+        }
+        else if (++_generation == 0)
+        {
+            // Stamps wrapped around, start over.
+            _slots.assign (nodeCount, Slot());
+            _generation = 1;
+        }
+    }
+
+    bool empty () const { return _entries.empty(); }
+    size_t size () const { return _entries.size(); }
+
+    bool contains (uint32_t node) const
+    {
+        const Slot& slot = _slots[node];
+        return slot.generation == _generation && slot.position != kPopped;
+    }
+
+    /** True if the node was pushed since the last reset(), even if already popped. */
+    bool seen (uint32_t node) const { return _slots[node].generation == _generation; }
+
+    /**
+     * Insert a node, or move it to the new key if it is already queued.
+     */
+    void push (uint32_t node, float key, float secondary = 0.f)
+    {
+        Slot& slot = _slots[node];
+        if (slot.generation == _generation && slot.position != kPopped)
+        {
+            Entry& entry = _entries[slot.position];
+            if (key == entry.key && secondary == entry.secondary)
+                return; // unchanged keys keep their place in line
+
+            const Entry updated = { key, secondary, _sequence++, node };
+            const bool decrease = less (updated, entry);
+            entry = updated;
+            if (decrease)
+                siftUp (slot.position);
+            else
+                siftDown (slot.position);
+            return;
+        }
+
+        slot.generation = _generation;
+        slot.position = (uint32_t)_entries.size();
+        _entries.push_back (Entry{ key, secondary, _sequence++, node });
+        siftUp (slot.position);
+    }
+
+    uint32_t top () const { return _entries.front().node; }
+    float topKey () const { return _entries.front().key; }
+    float topSecondaryKey () const { return _entries.front().secondary; }
+
+    uint32_t pop ()
+    {
+        const uint32_t node = _entries.front().node;
+        _slots[node].position = kPopped;
+
+        const Entry last = _entries.back();
+        _entries.pop_back();
+        if (!_entries.empty())
+        {
+            _entries[0] = last;
+            _slots[last.node].position = 0;
+            siftDown (0);
+        }
+        return node;
+    }
+
+    /** Remove a queued node, wherever it sits in the heap. */
+    void erase (uint32_t node)
+    {
+        if (!contains (node))
+            return;
+
+        const uint32_t position = _slots[node].position;
+        _slots[node].position = kPopped;
+
+        const Entry last = _entries.back();
+        _entries.pop_back();
+        if (position < _entries.size())
+        {
+            _entries[position] = last;
+            _slots[last.node].position = position;
+            siftUp (position);
+            siftDown (_slots[last.node].position);
+        }
+    }
+
+private:
+    static const uint32_t kPopped = 0xffffffffu;
+
+    struct Entry
+    {
+        float key;
+        float secondary;
+        uint32_t sequence;
+        uint32_t node;
+    };
+
+    struct Slot
+    {
+        uint32_t generation = 0;
+        uint32_t position = kPopped;
+    };
+
+    static bool less (const Entry& a, const Entry& b)
+    {
+        if (a.key != b.key)
+            return a.key < b.key;
+        if (a.secondary != b.secondary)
+            return a.secondary < b.secondary;
+        return a.sequence < b.sequence;
+    }
+
+    void siftUp (uint32_t position)
+    {
+        const Entry entry = _entries[position];
+        while (position > 0)
+        {
+            const uint32_t parent = (position - 1) / 2;
+            if (!less (entry, _entries[parent]))
+                break;
+            _entries[position] = _entries[parent];
+            _slots[_entries[position].node].position = position;
+            position = parent;
+        }
+        _entries[position] = entry;
+        _slots[entry.node].position = position;
+    }
+
+    void siftDown (uint32_t position)
+    {
+        const uint32_t count = (uint32_t)_entries.size();
+        const Entry entry = _entries[position];
+        while (true)
+        {
+            uint32_t child = 2 * position + 1;
+            if (child >= count)
+                break;
+            if (child + 1 < count && less (_entries[child + 1], _entries[child]))
+                child++;
+            if (!less (_entries[child], entry))
+                break;
+            _entries[position] = _entries[child];
+            _slots[_entries[position].node].position = position;
+            position = child;
+        }
+        _entries[position] = entry;
+        _slots[entry.node].position = position;
+    }
+
+    std::vector<Entry> _entries;
+    std::vector<Slot> _slots;
+    uint32_t _generation = 0;
+    uint32_t _sequence = 0;
+};
+
+} // BE namespace
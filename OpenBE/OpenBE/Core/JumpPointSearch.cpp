@@ -0,0 +1,217 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "JumpPointSearch.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace BE {
+
+namespace {
+
+    inline int sign (int v) { return (v > 0) - (v < 0); }
+
+} // anonymous
+
+void JumpPointSearch::reset (size_t nodeCount)
+{
+    if (_nodes.size() != nodeCount || ++_generation == 0)
+    {
+        _nodes.assign (nodeCount, Node{ 0.f, 0, 0, 0 });
+        _generation = 1;
+    }
+    _open.reset (nodeCount);
+    _stats = SearchStats();
+    _pathCost = 0.f;
+}
+
+uint32_t JumpPointSearch::jump (const Grid<unsigned char>& map, uint32_t index, int dx, int dy, uint32_t goal) const
+{
+    const ptrdiff_t s = map.stride();
+    const ptrdiff_t step = dy * s + dx;
+    auto blocked = [&map](ptrdiff_t i) { return isBlocked (map[(size_t)i]); };
+
+    for (ptrdiff_t p = index; ; p += step)
+    {
+        if (blocked (p))
+            return kNoJump;
+        if (p == (ptrdiff_t)goal)
+            return (uint32_t)p;
+
+        if (dx != 0 && dy != 0)
+        {
+            // Forced neighbours: an obstacle beside the diagonal opens a cell behind it.
+            if ((!blocked (p - dx + dy*s) && blocked (p - dx)) ||
+                (!blocked (p + dx - dy*s) && blocked (p - dy*s)))
+                return (uint32_t)p;
+
+            // A diagonal cell is a jump point if either straight run from it finds one.
+            if (jump (map, (uint32_t)(p + dx), dx, 0, goal) != kNoJump ||
+                jump (map, (uint32_t)(p + dy*s), 0, dy, goal) != kNoJump)
+                return (uint32_t)p;
+        }
+        else if (dx != 0)
+        {
+            if ((!blocked (p + dx + s) && blocked (p + s)) ||
+                (!blocked (p + dx - s) && blocked (p - s)))
+                return (uint32_t)p;
+        }
+        else
+        {
+            if ((!blocked (p + 1 + dy*s) && blocked (p + 1)) ||
+                (!blocked (p - 1 + dy*s) && blocked (p - 1)))
+                return (uint32_t)p;
+        }
+    }
+}
+
+bool JumpPointSearch::findPath (const Grid<unsigned char>& map, GridPoint start, GridPoint goal, std::vector<GridPoint>& path,
+                                const CancelFlag* cancel)
+{
+    assert(map.border() >= 1);
+
+    path.clear();
+    if (!map.inBounds (start.x, start.y) || !map.inBounds (goal.x, goal.y))
+        return false;
+
+    reset (map.capacity());
+
+    const uint32_t startIndex = (uint32_t)map.index (start.x, start.y);
+    const uint32_t goalIndex = (uint32_t)map.index (goal.x, goal.y);
+
+    Node& startNode = _nodes[startIndex];
+    startNode.cost = 0.f;
+    startNode.parent = startIndex;
+    startNode.generation = _generation;
+    _open.push (startIndex, 0.f);
+
+    bool solutionFound = false;
+    while (!_open.empty())
+    {
+        const uint32_t current = _open.pop();
+        _stats.expanded++;
+
+        if (pollCancel (cancel, _stats.expanded))
+        {
+            _stats.cancelled = true;
+            return false;
+        }
+
+        if (current == goalIndex)
+        {
+            solutionFound = true;
+            break;
+        }
+
+        Node& currentNode = _nodes[current];
+        currentNode.closed = _generation;
+
+        int cx, cy;
+        map.coords (current, cx, cy);
+
+        // Pruned directions to explore from this node, at most five of them.
+        int directions[8][2];
+        int directionCount = 0;
+        auto addDirection = [&directions, &directionCount](int dx, int dy) {
+            directions[directionCount][0] = dx;
+            directions[directionCount][1] = dy;
+            directionCount++;
+        };
+        auto blockedAt = [&map, cx, cy](int dx, int dy) { return isBlocked (map(cx + dx, cy + dy)); };
+
+        if (currentNode.parent == current)
+        {
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if (dx != 0 || dy != 0)
+                        addDirection (dx, dy);
+        }
+        else
+        {
+            int px, py;
+            map.coords (currentNode.parent, px, py);
+            const int dx = sign (cx - px);
+            const int dy = sign (cy - py);
+
+            if (dx != 0 && dy != 0)
+            {
+                addDirection (0, dy);
+                addDirection (dx, 0);
+                addDirection (dx, dy);
+                if (blockedAt (-dx, 0)) addDirection (-dx, dy);
+                if (blockedAt (0, -dy)) addDirection (dx, -dy);
+            }
+            else if (dx != 0)
+            {
+                addDirection (dx, 0);
+                if (blockedAt (0, 1)) addDirection (dx, 1);
+                if (blockedAt (0, -1)) addDirection (dx, -1);
+            }
+            else
+            {
+                addDirection (0, dy);
+                if (blockedAt (1, 0)) addDirection (1, dy);
+                if (blockedAt (-1, 0)) addDirection (-1, dy);
+            }
+        }
+
+        for (int d = 0; d < directionCount; d++)
+        {
+            const int dx = directions[d][0];
+            const int dy = directions[d][1];
+            const uint32_t neighbor = jump (map, (uint32_t)map.index (cx + dx, cy + dy), dx, dy, goalIndex);
+            if (neighbor == kNoJump)
+                continue;
+
+            int nx, ny;
+            map.coords (neighbor, nx, ny);
+
+            Node& neighborNode = _nodes[neighbor];
+            const bool isNew = neighborNode.generation != _generation;
+            const float neighborCost = currentNode.cost + octileCost (nx - cx, ny - cy);
+
+            if (isNew || neighborCost < neighborNode.cost)
+            {
+                if (!isNew && neighborNode.closed == _generation)
+                    _stats.reopened++;
+                neighborNode.cost = neighborCost;
+                neighborNode.parent = current;
+                neighborNode.generation = _generation;
+                neighborNode.closed = 0;
+                _open.push (neighbor, neighborCost + diagonalDist (goal.x, goal.y, nx, ny));
+                _stats.pushed++;
+            }
+        }
+    }
+
+    if (!solutionFound)
+        return false;
+
+    _pathCost = _nodes[goalIndex].cost;
+
+    // Jump points are joined by straight or 45 degree runs; fill the cells back in.
+    for (uint32_t index = goalIndex; ; index = _nodes[index].parent)
+    {
+        int x, y;
+        map.coords (index, x, y);
+        path.push_back (GridPoint{ x, y });
+        if (_nodes[index].parent == index)
+            break;
+
+        int px, py;
+        map.coords (_nodes[index].parent, px, py);
+        const int dx = sign (px - x);
+        const int dy = sign (py - y);
+        for (x += dx, y += dy; x != px || y != py; x += dx, y += dy)
+            path.push_back (GridPoint{ x, y });
+    }
+    std::reverse (path.begin(), path.end());
+    return true;
+}
+
+} // BE namespace
@@ -0,0 +1,70 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+
+namespace BE {
+
+/**
+ * Jump Point Search (Harabor & Grastien) over the 8-connected occupancy grid.
+ *
+ * Returns paths of the same cost as AStar, since the grid has uniform step
+ * costs, but only pushes jump points onto the open set: straight and diagonal
+ * runs through open space are skipped without being queued. Diagonal moves
+ * may squeeze between two blocked cells exactly like AStar's, so both planners
+ * agree on which goals are reachable.
+ *
+ * Same map requirements as AStar: a guard band of at least one blocked cell.
+ */
+class JumpPointSearch
+{
+public:
+    /**
+     * Search from start to goal. On success fills path with every cell from
+     * start to goal inclusive (jump segments are filled back in) and returns
+     * true. Gives up and returns false once cancel is raised.
+     */
+    bool findPath (const Grid<unsigned char>& map, GridPoint start, GridPoint goal, std::vector<GridPoint>& path,
+                   const CancelFlag* cancel = nullptr);
+
+    /** Cost of the last path found. */
+    float pathCost () const { return _pathCost; }
+
+    /** Counters of the last search; `expanded` counts jump points. */
+    const SearchStats& stats () const { return _stats; }
+
+private:
+    static const uint32_t kNoJump = 0xffffffffu;
+
+    struct Node
+    {
+        float cost;
+        uint32_t parent;
+        uint32_t generation;
+        uint32_t closed;
+    };
+
+    void reset (size_t nodeCount);
+
+    /** Walk from index in direction (dx, dy) until a jump point, the goal or an obstacle. */
+    uint32_t jump (const Grid<unsigned char>& map, uint32_t index, int dx, int dy, uint32_t goal) const;
+
+    std::vector<Node> _nodes;
+    IndexedHeap _open;
+    uint32_t _generation = 0;
+    float _pathCost = 0.f;
+    SearchStats _stats;
+};
+
+} // BE namespace
@@ -0,0 +1,150 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "Landmarks.h"
+
+#include <cassert>
+#include <limits>
+
+namespace BE {
+
+namespace {
+
+    const float kInfinity = std::numeric_limits<float>::infinity();
+    const uint32_t kNoCell = std::numeric_limits<uint32_t>::max();
+
+} // anonymous
+
+const int Landmarks::kDefaultCount;
+const size_t Landmarks::kMinComponentCells;
+
+bool Landmarks::sweep (const Grid<unsigned char>& map, uint32_t source, const CancelFlag* cancel)
+{
+    for (uint32_t cell : _settled)
+        _sweep[cell] = kInfinity;
+    _settled.clear();
+    _open.reset (map.capacity());
+
+    _sweep[source] = 0.f;
+    _open.push (source, 0.f);
+    while (!_open.empty())
+    {
+        const uint32_t current = _open.pop();
+        _settled.push_back (current);
+        if (pollCancel (cancel, ++_expanded))
+            return false;
+
+        const float distance = _sweep[current];
+        for (int i = 0; i < NeighborKernel::kSize; i++)
+        {
+            const uint32_t neighbor = (uint32_t)(current + _kernel.offset[i]);
+            const float candidate = distance + _kernel.cost[i];
+            if (!isBlocked (map[neighbor]) && candidate < _sweep[neighbor])
+            {
+                _sweep[neighbor] = candidate;
+                _open.push (neighbor, candidate);
+            }
+        }
+    }
+    return true;
+}
+
+bool Landmarks::build (const Grid<unsigned char>& map, const Grid<uint32_t>& labels, int count, const CancelFlag* cancel)
+{
+    assert(map.border() >= 1);
+    assert(labels.width() == map.width() && labels.height() == map.height() && labels.border() == map.border());
+
+    clear();
+    if (count <= 0)
+        return true;
+
+    // Same moves as AStar, so the tables measure the costs it searches over.
+    _kernel.setStride (map.stride());
+
+    // First cell and size of every component.
+    std::vector<uint32_t> firstCell;
+    std::vector<size_t> sizes;
+    for (int y = 0; y < map.height(); y++)
+    {
+        const uint32_t* row = labels.row (y);
+        for (int x = 0; x < map.width(); x++)
+        {
+            const uint32_t label = row[x];
+            if (label == 0)
+                continue;
+            if (label >= firstCell.size())
+            {
+                firstCell.resize (label + 1, kNoCell);
+                sizes.resize (label + 1, 0);
+            }
+            if (firstCell[label] == kNoCell)
+                firstCell[label] = (uint32_t)map.index (x, y);
+            sizes[label]++;
+        }
+    }
+
+    std::vector<float> distances (map.capacity() * count, 0.f);
+    std::vector<float> closest (map.capacity(), kInfinity);  // distance to the nearest landmark picked so far
+    _sweep.assign (map.capacity(), kInfinity);
+    _settled.clear();
+    _expanded = 0;
+
+    for (size_t label = 1; label < firstCell.size(); label++)
+    {
+        if (sizes[label] < kMinComponentCells)
+            continue;
+
+        // Farthest-point selection, starting from the far end of the component.
+        if (!sweep (map, firstCell[label], cancel))
+        {
+            clear();
+            return false;
+        }
+        uint32_t landmark = _settled.back();
+
+        for (int k = 0; k < count; k++)
+        {
+            if (!sweep (map, landmark, cancel))
+            {
+                clear();
+                return false;
+            }
+
+            int x, y;
+            map.coords (landmark, x, y);
+            _cells.push_back (GridPoint{ x, y });
+
+            float farthest = -1.f;
+            for (uint32_t cell : _settled)
+            {
+                const float distance = _sweep[cell];
+                distances[(size_t)cell * count + k] = distance;
+                closest[cell] = std::min (closest[cell], distance);
+                if (closest[cell] > farthest)
+                {
+                    farthest = closest[cell];
+                    landmark = cell;
+                }
+            }
+        }
+    }
+
+    _distances.swap (distances);
+    _count = count;
+    _sweep = std::vector<float>();
+    _settled = std::vector<uint32_t>();
+    return true;
+}
+
+void Landmarks::clear ()
+{
+    _count = 0;
+    _distances.clear();
+    _cells.clear();
+}
+
+} // BE namespace
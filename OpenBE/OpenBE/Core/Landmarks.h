@@ -0,0 +1,101 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+
+namespace BE {
+
+/**
+ * Landmark distance tables for the ALT heuristic (A*, Landmarks, Triangle
+ * inequality; Goldberg & Harrelson).
+ *
+ * Every connected component of at least kMinComponentCells cells gets `count`
+ * landmarks, picked by farthest-point selection so they sit at the ends of the
+ * component. The exact path cost from each landmark to every cell of its
+ * component is stored, and for any two cells n and g of one component
+ * |d(L, g) - d(L, n)| never exceeds the path cost between them. Near walls and
+ * furniture that bound is far tighter than the octile distance.
+ *
+ * Distances are stored per cell, all landmarks of a cell side by side, so a
+ * lookup touches one cache line. Components share the table, so memory is
+ * count x 4 bytes per map cell whatever the number of components. Cells of
+ * smaller components hold zeros and fall back to the octile bound.
+ *
+ * The tables describe the map they were built from; rebuild after any edit.
+ */
+class Landmarks
+{
+public:
+    static const int kDefaultCount = 4;
+    static const size_t kMinComponentCells = 256;
+
+    /**
+     * Build the tables for map, whose components are given by labels (same
+     * size and border, 0 on obstacles). Gives up and returns false, leaving
+     * nothing built, once cancel is raised.
+     */
+    bool build (const Grid<unsigned char>& map, const Grid<uint32_t>& labels, int count = kDefaultCount,
+                const CancelFlag* cancel = nullptr);
+
+    void clear ();
+
+    bool isBuilt () const { return _count > 0; }
+
+    /** Landmarks per component. */
+    int count () const { return _count; }
+
+    /** Map cells the tables cover, guards included; equals the map's capacity(). */
+    size_t cellCount () const { return _count > 0 ? _distances.size() / _count : 0; }
+
+    /** Landmark cells, in the order they were picked. */
+    const std::vector<GridPoint>& cells () const { return _cells; }
+
+    size_t memoryBytes () const { return _distances.size() * sizeof(float); }
+
+    /**
+     * Admissible lower bound on the path cost between two cells of the same
+     * component, given by their map index.
+     */
+    float lowerBound (uint32_t node, uint32_t goal) const
+    {
+        const float* a = &_distances[(size_t)node * _count];
+        const float* b = &_distances[(size_t)goal * _count];
+        float bound = 0.f;
+        for (int k = 0; k < _count; k++)
+            bound = std::max (bound, std::abs (a[k] - b[k]));
+        return bound * kRoundingMargin;
+    }
+
+private:
+    // Sums of step costs round differently along the two routes the bound compares.
+    static constexpr float kRoundingMargin = 0.999f;
+
+    /** Dijkstra from source over its component into _sweep; settled cells are listed in _settled. */
+    bool sweep (const Grid<unsigned char>& map, uint32_t source, const CancelFlag* cancel);
+
+    int _count = 0;
+    std::vector<float> _distances;  // cell * _count + landmark
+    std::vector<GridPoint> _cells;
+
+    // Sweep scratch.
+    NeighborKernel _kernel;
+    std::vector<float> _sweep;
+    std::vector<uint32_t> _settled;
+    IndexedHeap _open;
+    size_t _expanded = 0;
+};
+
+} // BE namespace
@@ -0,0 +1,172 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "LazyThetaStar.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "PathSmoothing.h"
+
+namespace BE {
+
+namespace {
+
+    inline float distance (int ax, int ay, int bx, int by)
+    {
+        const float dx = (float)(ax - bx);
+        const float dy = (float)(ay - by);
+        return sqrtf (dx * dx + dy * dy);
+    }
+
+} // anonymous
+
+void LazyThetaStar::reset (size_t nodeCount)
+{
+    if (_nodes.size() != nodeCount || ++_generation == 0)
+    {
+        _nodes.assign (nodeCount, Node{ 0.f, 0, 0, 0 });
+        _generation = 1;
+    }
+    _open.reset (nodeCount);
+    _stats = SearchStats();
+    _pathCost = 0.f;
+    _lineOfSightChecks = 0;
+}
+
+void LazyThetaStar::setVertex (const Grid<unsigned char>& map, uint32_t current)
+{
+    Node& node = _nodes[current];
+    if (node.parent == current)
+        return;
+
+    int cx, cy, px, py;
+    map.coords (current, cx, cy);
+    map.coords (node.parent, px, py);
+
+    // Neighbours are always connected, like on the 8-connected grid.
+    if (std::max (abs(cx - px), abs(cy - py)) <= 1)
+        return;
+
+    _lineOfSightChecks++;
+    if (lineOfSight (map, GridPoint{ px, py }, GridPoint{ cx, cy }))
+        return;
+
+    // The cell was reached through one of its expanded neighbours, so there is always one to fall back to.
+    node.cost = INFINITY;
+    for (int i = 0; i < NeighborKernel::kSize; i++)
+    {
+        const uint32_t neighbor = (uint32_t)(current + _kernel.offset[i]);
+        const Node& neighborNode = _nodes[neighbor];
+        if (neighborNode.generation != _generation || neighborNode.closed != _generation)
+            continue;
+
+        if (neighborNode.cost + _kernel.cost[i] < node.cost)
+        {
+            node.cost = neighborNode.cost + _kernel.cost[i];
+            node.parent = neighbor;
+        }
+    }
+}
+
+bool LazyThetaStar::findPath (const Grid<unsigned char>& map, GridPoint start, GridPoint goal,
+                              std::vector<GridPoint>& path, const CancelFlag* cancel)
+{
+    assert(map.border() >= 1);
+
+    path.clear();
+    if (!map.inBounds (start.x, start.y) || !map.inBounds (goal.x, goal.y))
+        return false;
+
+    reset (map.capacity());
+
+    _kernel.setStride (map.stride());
+
+    const uint32_t startIndex = (uint32_t)map.index (start.x, start.y);
+    const uint32_t goalIndex = (uint32_t)map.index (goal.x, goal.y);
+
+    Node& startNode = _nodes[startIndex];
+    startNode.cost = 0.f;
+    startNode.parent = startIndex;
+    startNode.generation = _generation;
+    _open.push (startIndex, 0.f);
+
+    bool solutionFound = false;
+    while (!_open.empty())
+    {
+        const uint32_t current = _open.pop();
+        _stats.expanded++;
+
+        if (pollCancel (cancel, _stats.expanded))
+        {
+            _stats.cancelled = true;
+            return false;
+        }
+
+        setVertex (map, current);
+        Node& currentNode = _nodes[current];
+        currentNode.closed = _generation;
+
+        if (current == goalIndex)
+        {
+            solutionFound = true;
+            break;
+        }
+
+        // Path 2 of Theta*: take the parent's straight segment, assuming it sees the neighbour until expanded.
+        const uint32_t parent = currentNode.parent;
+        const float parentCost = _nodes[parent].cost;
+        int px, py;
+        map.coords (parent, px, py);
+        int cx, cy;
+        map.coords (current, cx, cy);
+
+        for (int i = 0; i < NeighborKernel::kSize; i++)
+        {
+            const uint32_t neighbor = (uint32_t)(current + _kernel.offset[i]);
+            if (isBlocked (map[neighbor]))
+                continue;
+
+            Node& neighborNode = _nodes[neighbor];
+            const bool isNew = neighborNode.generation != _generation;
+            if (!isNew && neighborNode.closed == _generation)
+                continue;
+
+            const int nx = cx + _kernel.dx[i];
+            const int ny = cy + _kernel.dy[i];
+            const float neighborCost = parentCost + distance (px, py, nx, ny);
+            if (isNew || neighborCost < neighborNode.cost)
+            {
+                neighborNode.cost = neighborCost;
+                neighborNode.parent = parent;
+                neighborNode.generation = _generation;
+                neighborNode.closed = 0;
+                _open.push (neighbor, neighborCost + distance (nx, ny, goal.x, goal.y));
+                _stats.pushed++;
+            }
+        }
+    }
+
+    if (!solutionFound)
+        return false;
+
+    _pathCost = _nodes[goalIndex].cost;
+
+    for (uint32_t index = goalIndex; ; index = _nodes[index].parent)
+    {
+        GridPoint p;
+        map.coords (index, p.x, p.y);
+        path.push_back (p);
+        if (_nodes[index].parent == index)
+            break;
+    }
+    std::reverse (path.begin(), path.end());
+    return true;
+}
+
+} // BE namespace
@@ -0,0 +1,81 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+#include "IndexedHeap.h"
+
+namespace BE {
+
+/**
+ * Any-angle planner: Lazy Theta* (Nash, Koenig & Tovey) over an occupancy
+ * grid.
+ *
+ * Like A* on the 8-connected grid, except that a cell reached from s takes
+ * s's parent as its own parent and is costed by the straight segment between
+ * them, so paths are chains of straight segments at any angle rather than
+ * staircases. Line of sight for that segment is only checked when the cell is
+ * expanded, at most once per expansion; if it fails, the cell falls back to
+ * its best expanded neighbour as parent. The result is near-taut: it bends at
+ * obstacle corners only and needs no smoothing pass.
+ *
+ * Line of sight is lineOfSight() from PathSmoothing.h on the same map, so a
+ * segment never crosses a blocked cell of the dilated grid nor squeezes
+ * diagonally between two.
+ *
+ * The map must carry a guard band of at least one blocked cell. One instance
+ * should be used by one thread at a time.
+ */
+class LazyThetaStar
+{
+public:
+    /**
+     * Search from start to goal. On success fills path with the vertices of
+     * the path, start and goal included; consecutive vertices see each other.
+     * Gives up and returns false once cancel is raised.
+     */
+    bool findPath (const Grid<unsigned char>& map, GridPoint start, GridPoint goal, std::vector<GridPoint>& path,
+                   const CancelFlag* cancel = nullptr);
+
+    /** Euclidean length of the last path found, in cells. */
+    float pathCost () const { return _pathCost; }
+
+    /** Counters of the last search. */
+    const SearchStats& stats () const { return _stats; }
+
+    /** Line of sight tests made by the last search. */
+    size_t lineOfSightChecks () const { return _lineOfSightChecks; }
+
+private:
+    struct Node
+    {
+        float cost;
+        uint32_t parent;
+        uint32_t generation;
+        uint32_t closed;
+    };
+
+    void reset (size_t nodeCount);
+
+    /** Make sure current can see its parent, or re-parent it to its cheapest closed neighbour. */
+    void setVertex (const Grid<unsigned char>& map, uint32_t current);
+
+    std::vector<Node> _nodes;
+    IndexedHeap _open;
+    NeighborKernel _kernel;
+    uint32_t _generation = 0;
+    float _pathCost = 0.f;
+    SearchStats _stats;
+    size_t _lineOfSightChecks = 0;
+};
+
+} // BE namespace
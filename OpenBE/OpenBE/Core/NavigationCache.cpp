@@ -0,0 +1,296 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "NavigationCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BE {
+
+namespace {
+
+    const char kMagic[8] = { 'B', 'E', 'N', 'A', 'V', 'M', 'A', 'P' };
+    const uint32_t kByteOrderMark = 0x01020304;
+    const size_t kBlockAlignment = 64;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;     // kByteOrderMark as written by the host
+        uint64_t sourceHash;
+        int32_t width;
+        int32_t height;
+        float originX;
+        float originZ;
+        float resolution;
+        float agentRadius;
+        float startY;
+        float endY;
+        uint32_t encoding;
+        float quantizedMin;     // Quantized16: height of value 0
+        float quantizedStep;    // Quantized16: meters per step
+        uint32_t reserved;
+        uint64_t heightsOffset;
+        uint64_t heightsSize;
+    };
+
+    static_assert(sizeof(Header) == 88, "cache header layout must not depend on the compiler");
+
+    const size_t kCellSizes[NavigationCache::EncodingCount] = { 4, 2, 2 };
+
+    inline size_t alignBlock (size_t offset) { return (offset + kBlockAlignment - 1) & ~(kBlockAlignment - 1); }
+
+    inline uint64_t fnv1a (uint64_t hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+} // anonymous
+
+const uint32_t NavigationCache::kVersion;
+constexpr float NavigationCache::kNoHeight;
+const uint16_t NavigationCache::kQuantizedNoHeight;
+
+bool NavigationCache::open (const char* path, uint64_t sourceHash)
+{
+    close();
+
+    const int fd = ::open (path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    void* mapping = MAP_FAILED;
+    if (fstat (fd, &status) == 0 && (size_t)status.st_size >= sizeof(Header))
+        mapping = mmap (nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);   // the mapping keeps the file alive
+    if (mapping == MAP_FAILED)
+        return false;
+
+    _data = (const unsigned char*)mapping;
+    _size = (size_t)status.st_size;
+
+    const Header& header = *(const Header*)_data;
+    const bool valid = memcmp (header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion
+        && header.byteOrder == kByteOrderMark && header.sourceHash == sourceHash
+        && header.width > 0 && header.height > 0 && header.encoding < EncodingCount
+        && header.heightsSize == (uint64_t)header.width * header.height * kCellSizes[header.encoding]
+        && header.heightsOffset % kBlockAlignment == 0 && header.heightsOffset >= sizeof(Header)
+        && header.heightsOffset <= _size && header.heightsSize <= _size - header.heightsOffset;
+
+    if (!valid)
+    {
+        close();
+        return false;
+    }
+
+    _heights = _data + header.heightsOffset;
+    _width = header.width;
+    _height = header.height;
+    _encoding = (Encoding)header.encoding;
+    _quantizedMin = header.quantizedMin;
+    _quantizedStep = header.quantizedStep;
+    return true;
+}
+
+void NavigationCache::close ()
+{
+    if (_data)
+        munmap ((void*)_data, _size);
+    _data = nullptr;
+    _size = 0;
+    _heights = nullptr;
+    _width = 0;
+    _height = 0;
+}
+
+NavigationCache::Info NavigationCache::info () const
+{
+    Info info;
+    if (_data)
+    {
+        const Header& header = *(const Header*)_data;
+        info.originX = header.originX;
+        info.originZ = header.originZ;
+        info.resolution = header.resolution;
+        info.agentRadius = header.agentRadius;
+        info.startY = header.startY;
+        info.endY = header.endY;
+        info.encoding = (Encoding)header.encoding;
+    }
+    return info;
+}
+
+void NavigationCache::read (float* heights, size_t stride) const
+{
+    if (stride == 0)
+        stride = _width;
+    for (int y = 0; y < _height; y++)
+    {
+        for (int x = 0; x < _width; x++)
+            heights[(size_t)x + (size_t)y * stride] = height (x, y);
+    }
+}
+
+bool NavigationCache::write (const char* path, uint64_t sourceHash, const Info& info, int width, int height, const float* heights)
+{
+    if (width <= 0 || height <= 0 || info.encoding < 0 || info.encoding >= EncodingCount)
+        return false;
+    const size_t count = (size_t)width * height;
+
+    Header header;
+    memset (&header, 0, sizeof(header));
+    memcpy (header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.sourceHash = sourceHash;
+    header.width = width;
+    header.height = height;
+    header.originX = info.originX;
+    header.originZ = info.originZ;
+    header.resolution = info.resolution;
+    header.agentRadius = info.agentRadius;
+    header.startY = info.startY;
+    header.endY = info.endY;
+    header.encoding = info.encoding;
+    header.heightsOffset = alignBlock (sizeof(Header));
+    header.heightsSize = count * kCellSizes[info.encoding];
+
+    std::vector<unsigned char> encoded (header.heightsSize);
+    switch (info.encoding)
+    {
+        case Float32:
+            memcpy (encoded.data(), heights, header.heightsSize);
+            break;
+
+        case Float16:
+            for (size_t i = 0; i < count; i++)
+            {
+                const uint16_t half = floatToHalf (heights[i]);
+                memcpy (&encoded[2 * i], &half, sizeof(half));
+            }
+            break;
+
+        default:
+        {
+            // Spread the steps over the heights actually present; kQuantizedNoHeight marks the rest.
+            float low = INFINITY;
+            float high = -INFINITY;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (heights[i] < kNoHeight)
+                {
+                    low = std::min (low, heights[i]);
+                    high = std::max (high, heights[i]);
+                }
+            }
+            header.quantizedMin = low <= high ? low : 0.f;
+            header.quantizedStep = low < high ? (high - low) / (kQuantizedNoHeight - 1) : 1.f;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                uint16_t value = kQuantizedNoHeight;
+                if (heights[i] < kNoHeight)
+                {
+                    const float steps = roundf ((heights[i] - header.quantizedMin) / header.quantizedStep);
+                    value = (uint16_t)std::min (std::max (steps, 0.f), (float)(kQuantizedNoHeight - 1));
+                }
+                memcpy (&encoded[2 * i], &value, sizeof(value));
+            }
+            break;
+        }
+    }
+
+    const std::string temporaryPath = std::string (path) + ".tmp";
+    FILE* file = fopen (temporaryPath.c_str(), "wb");
+    if (!file)
+        return false;
+
+    static const char zeros[kBlockAlignment] = {};
+    const size_t padding = header.heightsOffset - sizeof(Header);
+    bool ok = fwrite (&header, sizeof(header), 1, file) == 1
+        && (padding == 0 || fwrite (zeros, 1, padding, file) == padding)
+        && fwrite (encoded.data(), 1, encoded.size(), file) == encoded.size();
+
+    ok = fclose (file) == 0 && ok;
+    if (ok)
+        ok = rename (temporaryPath.c_str(), path) == 0;
+    if (!ok)
+        unlink (temporaryPath.c_str());
+    return ok;
+}
+
+uint16_t NavigationCache::floatToHalf (float value)
+{
+    uint32_t bits;
+    memcpy (&bits, &value, sizeof(bits));
+
+    const uint16_t sign = (bits >> 16) & 0x8000;
+    const int exponent = (int)((bits >> 23) & 0xff);
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (exponent == 0xff)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);     // infinity, or a quiet NaN
+
+    const int e = exponent - 127 + 15;
+    if (e >= 0x1f)
+        return sign | 0x7c00;
+
+    // Round to nearest even; a carry out of the mantissa correctly bumps the exponent.
+    if (e <= 0)
+    {
+        if (e < -10)
+            return sign;
+        mantissa |= 0x800000;
+        const int shift = 14 - e;
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return sign | (uint16_t)half;
+    }
+
+    uint32_t half = ((uint32_t)e << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+    return sign | (uint16_t)half;
+}
+
+uint64_t hashNavigationSource (const void* geometry, size_t geometrySize, int width, int height,
+                               const NavigationCache::Info& info)
+{
+    const uint64_t size = geometrySize;
+    const int32_t dimensions[2] = { width, height };
+    const float parameters[6] = { info.originX, info.originZ, info.resolution, info.agentRadius, info.startY, info.endY };
+
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a (hash, &size, sizeof(size));
+    hash = fnv1a (hash, geometry, geometrySize);
+    hash = fnv1a (hash, dimensions, sizeof(dimensions));
+    hash = fnv1a (hash, parameters, sizeof(parameters));
+    return hash;
+}
+
+} // BE namespace
@@ -0,0 +1,185 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace BE {
+
+/**
+ * Binary cache of NavigationComponent's navigation map, queried in place.
+ *
+ * The file is a fixed little-endian header (map geometry, build parameters
+ * and a hash of the source mesh) followed by width x height heights starting
+ * on a 64 byte boundary. It is mapped read-only and trusted only if its
+ * format version and source hash match what the caller expects, so a
+ * rescanned room or other build parameters simply miss the cache.
+ *
+ * Heights can be queried in place, decoded on every call, or decoded all at
+ * once with read(). NavigationComponent does the latter into a HeightField
+ * and unmaps the cache, trading clean pages the system could drop for a
+ * 32-bit heap copy its batched queries can gather from; the encoding then
+ * only sets the size of the file and how much is read to load it. Heights
+ * can be stored as 32-bit floats, as half floats (about 1 mm steps at 2 m),
+ * or quantized to 16 bits over the range of heights actually present, which
+ * for a room is finer than a half float at the same size.
+ */
+class NavigationCache
+{
+public:
+    /** Bump whenever the layout or the way the map is built changes. */
+    static const uint32_t kVersion = 1;
+
+    static constexpr float kNoHeight = 999.f;
+
+    enum Encoding
+    {
+        Float32 = 0,
+        Float16,
+        Quantized16,
+        EncodingCount
+    };
+
+    /** Map geometry and build parameters stored alongside the heights. */
+    struct Info
+    {
+        float originX = 0.f;        // world position of cell (0, 0)
+        float originZ = 0.f;
+        float resolution = 0.f;     // meters per cell
+        float agentRadius = 0.f;
+        float startY = 0.f;
+        float endY = 0.f;
+        Encoding encoding = Quantized16;
+    };
+
+    NavigationCache () = default;
+    ~NavigationCache () { close(); }
+
+    NavigationCache (const NavigationCache&) = delete;
+    NavigationCache& operator= (const NavigationCache&) = delete;
+
+    /**
+     * Map the cache at path. Fails, leaving the cache closed, if the file is
+     * missing, truncated, of another version or built from other sources.
+     */
+    bool open (const char* path, uint64_t sourceHash);
+
+    void close ();
+
+    bool isOpen () const { return _data != nullptr; }
+
+    int width () const { return _width; }
+    int height () const { return _height; }
+    Info info () const;
+
+    /** Height of cell (x, y); kNoHeight if unreachable or outside the map. */
+    float height (int x, int y) const
+    {
+        if (x < 0 || y < 0 || x >= _width || y >= _height)
+            return kNoHeight;
+
+        const size_t cell = (size_t)x + (size_t)y * _width;
+        switch (_encoding)
+        {
+            case Float32:
+            {
+                float value;
+                memcpy (&value, _heights + 4 * cell, sizeof(value));
+                return value;
+            }
+            case Float16:
+                return halfToFloat (sample16 (cell));
+            default:
+            {
+                const uint16_t value = sample16 (cell);
+                return value == kQuantizedNoHeight ? kNoHeight : _quantizedMin + value * _quantizedStep;
+            }
+        }
+    }
+
+    /** Decode every height, row by row, into heights; rows are stride floats apart, width() if 0. */
+    void read (float* heights, size_t stride = 0) const;
+
+    /**
+     * Write a cache of width x height heights, row by row, in the encoding of
+     * info. The file is written next to path and renamed over it, so readers
+     * never see a partial cache.
+     */
+    static bool write (const char* path, uint64_t sourceHash, const Info& info, int width, int height, const float* heights);
+
+    static uint16_t floatToHalf (float value);
+
+    static float halfToFloat (uint16_t half)
+    {
+        const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1f;
+        uint32_t mantissa = half & 0x3ff;
+
+        uint32_t bits;
+        if (exponent == 0x1f)
+        {
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        }
+        else if (exponent != 0)
+        {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+        else if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Subnormal: normalize into a float exponent.
+            uint32_t e = 113;
+            while (!(mantissa & 0x400))
+            {
+                mantissa <<= 1;
+                e--;
+            }
+            bits = sign | (e << 23) | ((mantissa & 0x3ff) << 13);
+        }
+
+        float value;
+        memcpy (&value, &bits, sizeof(value));
+        return value;
+    }
+
+private:
+    static const uint16_t kQuantizedNoHeight = 0xffff;
+
+    uint16_t sample16 (size_t cell) const
+    {
+        uint16_t value;
+        memcpy (&value, _heights + 2 * cell, sizeof(value));
+        return value;
+    }
+
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+
+    // Decoded from the header for the queries.
+    const unsigned char* _heights = nullptr;
+    int _width = 0;
+    int _height = 0;
+    Encoding _encoding = Float32;
+    float _quantizedMin = 0.f;
+    float _quantizedStep = 0.f;
+};
+
+/**
+ * 64-bit FNV-1a hash identifying the sources of a navigation map: the bytes
+ * of the geometry it was built from, its size and the build parameters of
+ * info other than the encoding.
+ */
+uint64_t hashNavigationSource (const void* geometry, size_t geometrySize, int width, int height,
+                               const NavigationCache::Info& info);
+
+} // BE namespace
@@ -0,0 +1,282 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "NavigationMapBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "HeightFilter.h"
+#include "HeightRasterizer.h"
+
+namespace BE {
+
+const int NavigationMapBuilder::kDefaultTileSize;
+constexpr float NavigationMapBuilder::kNoHeight;
+
+int NavigationMapBuilder::tileSize (const Settings& settings)
+{
+    return std::max ({ 1, settings.tileSize, 2 * settings.radius });
+}
+
+NavigationMapBuilder::NavigationMapBuilder (TaskPool& pool, TaskPool& heightPool, const Settings& settings)
+    : _pool (pool)
+    , _heightPool (heightPool)
+    , _settings (settings)
+{
+    _settings.width = std::max (0, _settings.width);
+    _settings.height = std::max (0, _settings.height);
+    _settings.radius = std::max (0, _settings.radius);
+    _tileSize = tileSize (_settings);
+    _tilesX = (_settings.width + _tileSize - 1) / _tileSize;
+    _tilesY = (_settings.height + _tileSize - 1) / _tileSize;
+
+    const size_t cells = (size_t)_settings.width * _settings.height;
+    _heights.assign (cells, kNoHeight);
+    _map.assign (cells, kNoHeight);
+
+    const int tiles = _tilesX * _tilesY;
+    _waiting.reset (new std::atomic<int>[tiles]);
+    _ready.reset (new std::atomic<bool>[tiles]);
+    for (int i = 0; i < tiles; i++)
+    {
+        const GridRect needed = tilesCovering (tileRect (i).expanded (_settings.radius));
+        _waiting[i].store ((needed.x1 - needed.x0) * (needed.y1 - needed.y0), std::memory_order_relaxed);
+        _ready[i].store (false, std::memory_order_relaxed);
+    }
+}
+
+std::shared_ptr<NavigationMapBuilder> NavigationMapBuilder::start (TaskPool& pool, const Settings& settings, HeightSource source,
+                                                                   ProgressHandler progress, CompletionHandler completion,
+                                                                   TaskPool* heightPool)
+{
+    std::shared_ptr<NavigationMapBuilder> builder (new NavigationMapBuilder (pool, heightPool ? *heightPool : pool, settings));
+    builder->_self = builder;
+    builder->_source = std::move (source);
+    builder->_progressHandler = std::move (progress);
+    builder->_completionHandler = std::move (completion);
+
+    const int tiles = builder->_tilesX * builder->_tilesY;
+    if (tiles == 0)
+    {
+        builder->finish();
+        return builder;
+    }
+
+    // Nearest the focus first; the pool starts tasks from other threads in order.
+    std::vector<std::pair<int64_t, int>> order;
+    order.reserve (tiles);
+    for (int i = 0; i < tiles; i++)
+    {
+        const GridRect rect = builder->tileRect (i);
+        const int64_t dx = std::max ({ rect.x0 - settings.focus.x, settings.focus.x - (rect.x1 - 1), 0 });
+        const int64_t dy = std::max ({ rect.y0 - settings.focus.y, settings.focus.y - (rect.y1 - 1), 0 });
+        order.emplace_back (dx * dx + dy * dy, i);
+    }
+    std::sort (order.begin(), order.end());
+
+    for (const auto& tile : order)
+    {
+        const int i = tile.second;
+        builder->_heightPool.submit ([builder, i] { builder->buildHeights (i); });
+    }
+    return builder;
+}
+
+GridRect NavigationMapBuilder::tileRect (int tile) const
+{
+    const int x0 = (tile % _tilesX) * _tileSize;
+    const int y0 = (tile / _tilesX) * _tileSize;
+    return GridRect{ x0, y0, std::min (x0 + _tileSize, _settings.width), std::min (y0 + _tileSize, _settings.height) };
+}
+
+GridRect NavigationMapBuilder::tilesCovering (const GridRect& rect) const
+{
+    const GridRect cells = rect.clipped (_settings.width, _settings.height);
+    if (cells.empty())
+        return GridRect{ 0, 0, 0, 0 };
+    return GridRect{ cells.x0 / _tileSize, cells.y0 / _tileSize, (cells.x1 - 1) / _tileSize + 1, (cells.y1 - 1) / _tileSize + 1 };
+}
+
+void NavigationMapBuilder::buildHeights (int tile)
+{
+    const GridRect rect = tileRect (tile);
+    if (!_cancelled.load (std::memory_order_relaxed) && _source)
+    {
+        const int width = rect.x1 - rect.x0;
+        std::vector<float> heights ((size_t)width * (rect.y1 - rect.y0), kNoHeight);
+        _source (rect, heights.data());
+        for (int y = rect.y0; y < rect.y1; y++)
+        {
+            const float* src = heights.data() + (size_t)(y - rect.y0) * width;
+            std::copy (src, src + width, _heights.data() + (size_t)y * _settings.width + rect.x0);
+        }
+    }
+
+    // Erode the tiles whose halo this completes; on this worker, while the heights are in cache,
+    // unless the heights come from a pool of their own.
+    const GridRect dependents = tilesCovering (rect.expanded (_settings.radius));
+    std::shared_ptr<NavigationMapBuilder> self = _self.lock();
+    for (int ty = dependents.y0; ty < dependents.y1; ty++)
+    {
+        for (int tx = dependents.x0; tx < dependents.x1; tx++)
+        {
+            const int dependent = ty * _tilesX + tx;
+            if (_waiting[dependent].fetch_sub (1, std::memory_order_acq_rel) == 1)
+                _pool.submit ([self, dependent] { self->erode (dependent); });
+        }
+    }
+    tileDone();
+}
+
+void NavigationMapBuilder::erode (int tile)
+{
+    const GridRect rect = tileRect (tile);
+    if (!_cancelled.load (std::memory_order_relaxed))
+    {
+        // The halo around the tile, cut by the map edge; HeightFilter treats everything
+        // beyond its input as unreachable, which is only right at the map edge.
+        const GridRect halo = rect.expanded (_settings.radius).clipped (_settings.width, _settings.height);
+        const int haloWidth = halo.x1 - halo.x0;
+        const int haloHeight = halo.y1 - halo.y0;
+
+        thread_local std::vector<float> heights;
+        thread_local HeightFilter filter;
+        heights.resize ((size_t)haloWidth * haloHeight);
+        for (int y = halo.y0; y < halo.y1; y++)
+        {
+            const float* src = _heights.data() + (size_t)y * _settings.width + halo.x0;
+            std::copy (src, src + haloWidth, heights.data() + (size_t)(y - halo.y0) * haloWidth);
+        }
+
+        const bool down = _settings.endY < _settings.startY;
+        filter.apply (heights.data(), haloWidth, haloHeight, _settings.radius,
+                      down ? HeightFilter::Maximum : HeightFilter::Minimum, kNoHeight);
+
+        const std::vector<float>& filtered = filter.heights();
+        const std::vector<uint8_t>& unreachable = filter.unreachable();
+        for (int y = rect.y0; y < rect.y1; y++)
+        {
+            const size_t src = (size_t)(y - halo.y0) * haloWidth + (rect.x0 - halo.x0);
+            float* dst = _map.data() + (size_t)y * _settings.width + rect.x0;
+            for (int i = 0; i < rect.x1 - rect.x0; i++)
+            {
+                const float height = down ? std::max (_settings.endY, filtered[src + i]) : std::min (_settings.endY, filtered[src + i]);
+                dst[i] = unreachable[src + i] ? kNoHeight : height;
+            }
+        }
+        _ready[tile].store (true, std::memory_order_release);
+    }
+    tileDone();
+}
+
+void NavigationMapBuilder::tileDone ()
+{
+    const int total = 2 * _tilesX * _tilesY;
+    const int done = _done.fetch_add (1, std::memory_order_acq_rel) + 1;
+    if (_progressHandler)
+        _progressHandler ((float)done / total);
+    if (done == total)
+        finish();
+}
+
+void NavigationMapBuilder::finish ()
+{
+    if (_completionHandler)
+        _completionHandler (!_cancelled.load (std::memory_order_relaxed), _map);
+
+    // Every task is past its use of the source by now, so free the mesh it may hold.
+    // Others may still be reporting progress, so that handler stays.
+    _completionHandler = nullptr;
+    _source = nullptr;
+    {
+        std::lock_guard<std::mutex> lock (_mutex);
+        _finished = true;
+    }
+    _finishedCondition.notify_all();
+}
+
+float NavigationMapBuilder::progress () const
+{
+    const int total = 2 * _tilesX * _tilesY;
+    return total > 0 ? std::min (1.f, (float)_done.load (std::memory_order_relaxed) / total) : 1.f;
+}
+
+bool NavigationMapBuilder::isFinished () const
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+    return _finished;
+}
+
+void NavigationMapBuilder::wait ()
+{
+    std::unique_lock<std::mutex> lock (_mutex);
+    _finishedCondition.wait (lock, [this] { return _finished; });
+}
+
+//------------------------------------------------------------------------------
+
+NavigationMapBuilder::HeightSource NavigationMapBuilder::rasterize (std::vector<Float3> triangles, const GridTransform& transform,
+                                                                    const Settings& settings)
+{
+    struct Mesh
+    {
+        std::vector<Float3> triangles;
+        std::vector<std::vector<uint32_t>> bins;    // triangles per tile
+        int tileSize;
+        int tilesX;
+    };
+
+    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+    mesh->triangles = std::move (triangles);
+    mesh->tileSize = tileSize (settings);
+    mesh->tilesX = (std::max (0, settings.width) + mesh->tileSize - 1) / mesh->tileSize;
+    const int tilesY = (std::max (0, settings.height) + mesh->tileSize - 1) / mesh->tileSize;
+    mesh->bins.resize ((size_t)mesh->tilesX * tilesY);
+
+    // Cells a triangle may overlap, with a cell of slack on each side against rounding.
+    const float scale = 1.f / transform.cellSize;
+    const size_t count = mesh->triangles.size() / 3;
+    for (size_t i = 0; i < count; i++)
+    {
+        const Float3* t = &mesh->triangles[3 * i];
+        const float u0 = (std::min ({ t[0].x, t[1].x, t[2].x }) - transform.originX) * scale;
+        const float u1 = (std::max ({ t[0].x, t[1].x, t[2].x }) - transform.originX) * scale;
+        const float v0 = (std::min ({ t[0].z, t[1].z, t[2].z }) - transform.originZ) * scale;
+        const float v1 = (std::max ({ t[0].z, t[1].z, t[2].z }) - transform.originZ) * scale;
+        if (!(u1 >= -1.5f && v1 >= -1.5f && u0 <= settings.width + 0.5f && v0 <= settings.height + 0.5f))
+            continue;
+
+        const int x0 = (int)floorf (std::max (0.f, u0 - 1.5f)) / mesh->tileSize;
+        const int x1 = std::min (mesh->tilesX - 1, (int)ceilf (std::min ((float)settings.width, u1 + 1.5f)) / mesh->tileSize);
+        const int y0 = (int)floorf (std::max (0.f, v0 - 1.5f)) / mesh->tileSize;
+        const int y1 = std::min (tilesY - 1, (int)ceilf (std::min ((float)settings.height, v1 + 1.5f)) / mesh->tileSize);
+        for (int ty = y0; ty <= y1; ty++)
+        {
+            for (int tx = x0; tx <= x1; tx++)
+                mesh->bins[(size_t)ty * mesh->tilesX + tx].push_back ((uint32_t)i);
+        }
+    }
+
+    const float startY = settings.startY;
+    const float endY = settings.endY;
+    return [mesh, transform, startY, endY](const GridRect& tile, float* heights)
+    {
+        thread_local HeightRasterizer rasterizer;
+        rasterizer.reset (tile, transform, startY, endY, HeightRasterizer::ConservativeCoverage);
+
+        const std::vector<uint32_t>& bin = mesh->bins[(size_t)(tile.y0 / mesh->tileSize) * mesh->tilesX + tile.x0 / mesh->tileSize];
+        for (uint32_t i : bin)
+        {
+            const Float3* t = &mesh->triangles[3 * (size_t)i];
+            rasterizer.addTriangle (t[0], t[1], t[2]);
+        }
+        std::copy (rasterizer.heights().begin(), rasterizer.heights().end(), heights);
+    };
+}
+
+} // BE namespace
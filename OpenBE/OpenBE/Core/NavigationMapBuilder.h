@@ -0,0 +1,145 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Grid.h"
+#include "TaskPool.h"
+
+namespace BE {
+
+/**
+ * Builds NavigationComponent's navigation map in tiles on a TaskPool: the
+ * height map of every tile, then the erosion of every tile by the agent
+ * radius as soon as the tiles around it have their heights.
+ *
+ * Tiles are started nearest the focus cell first, and each becomes readable
+ * once eroded, so agents near the focus can query heights long before the
+ * whole map is done. Cells of unfinished tiles read as kNoHeight.
+ *
+ * Erosion takes, for every cell, the highest surface within radius cells
+ * (the lowest when endY is above startY), and kNoHeight when that window
+ * holds a cell with no surface or leaves the map. The result is the same
+ * whatever the tiling.
+ */
+class NavigationMapBuilder
+{
+public:
+    static const int kDefaultTileSize = 64;
+    static constexpr float kNoHeight = 999.f;
+
+    /** Fill heights, row by row, with those of the cells of tile; kNoHeight where there is no surface. */
+    typedef std::function<void (const GridRect& tile, float* heights)> HeightSource;
+
+    /** Fraction of the tiles done, up to 1. Called from several workers at once, so calls may overtake each other. */
+    typedef std::function<void (float progress)> ProgressHandler;
+
+    /** Called once from a worker at the end; finished is false if the build was cancelled. */
+    typedef std::function<void (bool finished, const std::vector<float>& map)> CompletionHandler;
+
+    struct Settings
+    {
+        int width = 0;
+        int height = 0;
+        float startY = 0.f;
+        float endY = 0.f;
+        int radius = 1;                     // erosion radius, in cells
+        int tileSize = kDefaultTileSize;    // raised to twice the radius, so halos stay small
+        GridPoint focus = { 0, 0 };         // cell whose tiles are built first
+    };
+
+    /**
+     * Start a build; its tasks keep the builder alive until they are done.
+     * The height source runs on heightPool if given, say a one-thread pool for
+     * a source that must not run concurrently with itself, and erosion on pool.
+     */
+    static std::shared_ptr<NavigationMapBuilder> start (TaskPool& pool, const Settings& settings, HeightSource source,
+                                                        ProgressHandler progress = nullptr,
+                                                        CompletionHandler completion = nullptr,
+                                                        TaskPool* heightPool = nullptr);
+
+    /**
+     * Height source rasterizing a triangle soup, three world-space vertices per
+     * triangle, with conservative coverage. Triangles are binned per tile up
+     * front, so each tile only walks those that may touch it.
+     */
+    static HeightSource rasterize (std::vector<Float3> triangles, const GridTransform& transform, const Settings& settings);
+
+    int width () const { return _settings.width; }
+    int height () const { return _settings.height; }
+
+    /** Height of cell (x, y), or kNoHeight if it is outside the map or its tile is not done. */
+    float height (int x, int y) const
+    {
+        if (x < 0 || y < 0 || x >= _settings.width || y >= _settings.height)
+            return kNoHeight;
+        if (!_ready[(y / _tileSize) * _tilesX + x / _tileSize].load (std::memory_order_acquire))
+            return kNoHeight;
+        return _map[(size_t)x + (size_t)y * _settings.width];
+    }
+
+    float progress () const;
+
+    /** The completion handler has run. */
+    bool isFinished () const;
+
+    /** The whole map, row by row; complete once isFinished() unless cancelled. */
+    const std::vector<float>& map () const { return _map; }
+
+    /** Skip the work still to do; the completion handler still runs. */
+    void cancel () { _cancelled.store (true, std::memory_order_relaxed); }
+
+    /** Block until the completion handler has run. Must not be called from a task of the pool. */
+    void wait ();
+
+private:
+    static int tileSize (const Settings& settings);
+
+    NavigationMapBuilder (TaskPool& pool, TaskPool& heightPool, const Settings& settings);
+
+    GridRect tileRect (int tile) const;
+
+    /** Tiles overlapping rect, as a rectangle of tile coordinates. */
+    GridRect tilesCovering (const GridRect& rect) const;
+
+    void buildHeights (int tile);
+    void erode (int tile);
+    void tileDone ();
+    void finish ();
+
+    TaskPool& _pool;
+    TaskPool& _heightPool;
+    Settings _settings;
+    HeightSource _source;
+    ProgressHandler _progressHandler;
+    CompletionHandler _completionHandler;
+
+    int _tileSize = kDefaultTileSize;
+    int _tilesX = 0;
+    int _tilesY = 0;
+    std::vector<float> _heights;                    // before erosion
+    std::vector<float> _map;
+    std::unique_ptr<std::atomic<int>[]> _waiting;   // per tile, height tiles its erosion still needs
+    std::unique_ptr<std::atomic<bool>[]> _ready;    // per tile, eroded and readable
+    std::atomic<int> _done { 0 };                   // height and erosion passes finished
+    std::atomic<bool> _cancelled { false };
+
+    mutable std::mutex _mutex;
+    std::condition_variable _finishedCondition;
+    bool _finished = false;
+
+    std::weak_ptr<NavigationMapBuilder> _self;
+};
+
+} // BE namespace
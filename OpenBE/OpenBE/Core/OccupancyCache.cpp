@@ -0,0 +1,264 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "OccupancyCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BE {
+
+namespace {
+
+    const char kMagic[8] = { 'B', 'E', 'O', 'C', 'C', 'M', 'A', 'P' };
+    const uint32_t kByteOrderMark = 0x01020304;
+    const size_t kBlockAlignment = 64;
+
+    struct LayerBlock
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;     // kByteOrderMark as written by the host
+        uint64_t sourceHash;
+        int32_t width;
+        int32_t height;
+        float originX;
+        float originZ;
+        float metersPerPixel;
+        int32_t robotRadius;
+        LayerBlock layers[OccupancyCache::LayerCount];
+    };
+
+    static_assert(sizeof(Header) == 112, "cache header layout must not depend on the compiler");
+
+    const size_t kCellSizes[OccupancyCache::LayerCount] = { 1, 1, 1, sizeof(uint32_t) };
+
+    inline size_t alignBlock (size_t offset) { return (offset + kBlockAlignment - 1) & ~(kBlockAlignment - 1); }
+
+    inline uint64_t fnv1a (uint64_t hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    bool writeRows (FILE* file, const Grid<T>& grid)
+    {
+        for (int y = 0; y < grid.height(); y++)
+        {
+            if (fwrite (grid.row (y), sizeof(T), grid.width(), file) != (size_t)grid.width())
+                return false;
+        }
+        return true;
+    }
+
+    bool writePadding (FILE* file, size_t from, size_t to)
+    {
+        static const char zeros[kBlockAlignment] = {};
+        return to == from || fwrite (zeros, 1, to - from, file) == to - from;
+    }
+
+    template <typename T>
+    void readRows (const unsigned char* data, Grid<T>& grid)
+    {
+        const size_t rowBytes = (size_t)grid.width() * sizeof(T);
+        for (int y = 0; y < grid.height(); y++)
+            memcpy (grid.row (y), data + y * rowBytes, rowBytes);
+    }
+
+} // anonymous
+
+const uint32_t OccupancyCache::kVersion;
+
+bool OccupancyCache::open (const char* path, uint64_t sourceHash)
+{
+    close();
+
+    const int fd = ::open (path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    void* mapping = MAP_FAILED;
+    if (fstat (fd, &status) == 0 && (size_t)status.st_size >= sizeof(Header))
+        mapping = mmap (nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);   // the mapping keeps the file alive
+    if (mapping == MAP_FAILED)
+        return false;
+
+    _data = (const unsigned char*)mapping;
+    _size = (size_t)status.st_size;
+
+    const Header& header = *(const Header*)_data;
+    bool valid = memcmp (header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion
+        && header.byteOrder == kByteOrderMark && header.sourceHash == sourceHash
+        && header.width > 0 && header.height > 0;
+
+    for (int layer = 0; valid && layer < LayerCount; layer++)
+    {
+        const LayerBlock& block = header.layers[layer];
+        valid = block.size == (uint64_t)header.width * header.height * kCellSizes[layer]
+            && block.offset % kBlockAlignment == 0 && block.offset >= sizeof(Header)
+            && block.offset <= _size && block.size <= _size - block.offset;
+    }
+
+    if (!valid)
+        close();
+    return valid;
+}
+
+void OccupancyCache::close ()
+{
+    if (_data)
+        munmap ((void*)_data, _size);
+    _data = nullptr;
+    _size = 0;
+}
+
+int OccupancyCache::width () const
+{
+    return _data ? ((const Header*)_data)->width : 0;
+}
+
+int OccupancyCache::height () const
+{
+    return _data ? ((const Header*)_data)->height : 0;
+}
+
+OccupancyCache::Info OccupancyCache::info () const
+{
+    Info info;
+    if (_data)
+    {
+        const Header& header = *(const Header*)_data;
+        info.originX = header.originX;
+        info.originZ = header.originZ;
+        info.metersPerPixel = header.metersPerPixel;
+        info.robotRadius = header.robotRadius;
+    }
+    return info;
+}
+
+const unsigned char* OccupancyCache::layerData (Layer layer, size_t cellSize) const
+{
+    if (!_data || layer < 0 || layer >= LayerCount || kCellSizes[layer] != cellSize)
+        return nullptr;
+    return _data + ((const Header*)_data)->layers[layer].offset;
+}
+
+bool OccupancyCache::read (Layer layer, Grid<unsigned char>& grid) const
+{
+    const unsigned char* data = layerData (layer, sizeof(unsigned char));
+    if (!data || grid.width() != width() || grid.height() != height())
+        return false;
+    readRows (data, grid);
+    return true;
+}
+
+bool OccupancyCache::read (Layer layer, Grid<uint32_t>& grid) const
+{
+    const unsigned char* data = layerData (layer, sizeof(uint32_t));
+    if (!data || grid.width() != width() || grid.height() != height())
+        return false;
+    readRows (data, grid);
+    return true;
+}
+
+bool OccupancyCache::write (const char* path, uint64_t sourceHash, const Info& info,
+                            const Grid<unsigned char>& raw, const Grid<unsigned char>& dilated,
+                            const Grid<unsigned char>& topo, const Grid<uint32_t>& labels)
+{
+    const int width = raw.width();
+    const int height = raw.height();
+    if (raw.empty() || dilated.width() != width || dilated.height() != height || topo.width() != width
+        || topo.height() != height || labels.width() != width || labels.height() != height)
+        return false;
+
+    Header header;
+    memset (&header, 0, sizeof(header));
+    memcpy (header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.sourceHash = sourceHash;
+    header.width = width;
+    header.height = height;
+    header.originX = info.originX;
+    header.originZ = info.originZ;
+    header.metersPerPixel = info.metersPerPixel;
+    header.robotRadius = info.robotRadius;
+
+    size_t offset = sizeof(Header);
+    for (int layer = 0; layer < LayerCount; layer++)
+    {
+        offset = alignBlock (offset);
+        header.layers[layer].offset = offset;
+        header.layers[layer].size = (uint64_t)width * height * kCellSizes[layer];
+        offset += header.layers[layer].size;
+    }
+
+    const std::string temporaryPath = std::string (path) + ".tmp";
+    FILE* file = fopen (temporaryPath.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool ok = fwrite (&header, sizeof(header), 1, file) == 1;
+    size_t written = sizeof(Header);
+    for (int layer = 0; ok && layer < LayerCount; layer++)
+    {
+        const size_t start = header.layers[layer].offset;
+        ok = writePadding (file, written, start);
+        switch (layer)
+        {
+            case RawLayer:     ok = ok && writeRows (file, raw); break;
+            case DilatedLayer: ok = ok && writeRows (file, dilated); break;
+            case TopoLayer:    ok = ok && writeRows (file, topo); break;
+            case LabelLayer:   ok = ok && writeRows (file, labels); break;
+        }
+        written = start + header.layers[layer].size;
+    }
+
+    ok = fclose (file) == 0 && ok;
+    if (ok)
+        ok = rename (temporaryPath.c_str(), path) == 0;
+    if (!ok)
+        unlink (temporaryPath.c_str());
+    return ok;
+}
+
+uint64_t hashOccupancySource (const void* image, size_t imageSize, const void* metadata, size_t metadataSize,
+                              int robotRadius)
+{
+    // Sizes go in first so bytes cannot move between the two sources without changing the hash.
+    const uint64_t sizes[2] = { imageSize, metadataSize };
+    const int32_t radius = robotRadius;
+
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a (hash, sizes, sizeof(sizes));
+    hash = fnv1a (hash, image, imageSize);
+    hash = fnv1a (hash, metadata, metadataSize);
+    hash = fnv1a (hash, &radius, sizeof(radius));
+    return hash;
+}
+
+} // BE namespace
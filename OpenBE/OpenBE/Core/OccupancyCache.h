@@ -0,0 +1,102 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Grid.h"
+
+namespace BE {
+
+/**
+ * Binary cache of an occupancy map and the layers derived from it, so the
+ * planner can start without decoding the image or recomputing anything.
+ *
+ * The file is a fixed little-endian header followed by one block per layer,
+ * each block holding width x height packed cells and starting on a 64 byte
+ * boundary. It is mapped read-only and trusted only if its format version and
+ * source hash match what the caller expects, so a changed image, metadata or
+ * robot radius simply misses the cache. Layers are copied out of the mapping
+ * because the planner edits its maps at runtime.
+ */
+class OccupancyCache
+{
+public:
+    /** Bump whenever the layout or the way any layer is derived changes. */
+    static const uint32_t kVersion = 1;
+
+    enum Layer
+    {
+        RawLayer = 0,   // occupancy read from the image, 255 = obstacle
+        DilatedLayer,   // obstacles grown by the robot radius
+        TopoLayer,      // clearance cost
+        LabelLayer,     // connected component labels, 4 bytes per cell
+        LayerCount
+    };
+
+    /** Map geometry stored alongside the layers. */
+    struct Info
+    {
+        float originX = 0.f;
+        float originZ = 0.f;
+        float metersPerPixel = 0.f;
+        int robotRadius = 0;
+    };
+
+    OccupancyCache () = default;
+    ~OccupancyCache () { close(); }
+
+    OccupancyCache (const OccupancyCache&) = delete;
+    OccupancyCache& operator= (const OccupancyCache&) = delete;
+
+    /**
+     * Map the cache at path. Fails, leaving the cache closed, if the file is
+     * missing, truncated, of another version or built from other sources.
+     */
+    bool open (const char* path, uint64_t sourceHash);
+
+    void close ();
+
+    bool isOpen () const { return _data != nullptr; }
+
+    int width () const;
+    int height () const;
+    Info info () const;
+
+    /**
+     * Copy a layer into grid, which must already be sized to width() x
+     * height(); its guard band is left alone.
+     */
+    bool read (Layer layer, Grid<unsigned char>& grid) const;
+    bool read (Layer layer, Grid<uint32_t>& grid) const;
+
+    /**
+     * Write a cache for the given layers, which must all have the size of raw.
+     * The file is written next to path and renamed over it, so readers never
+     * see a partial cache.
+     */
+    static bool write (const char* path, uint64_t sourceHash, const Info& info,
+                       const Grid<unsigned char>& raw, const Grid<unsigned char>& dilated,
+                       const Grid<unsigned char>& topo, const Grid<uint32_t>& labels);
+
+private:
+    const unsigned char* layerData (Layer layer, size_t cellSize) const;
+
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+};
+
+/**
+ * 64-bit FNV-1a hash identifying the sources of a cache: the encoded map
+ * image, its metadata and the robot radius the layers were built with.
+ */
+uint64_t hashOccupancySource (const void* image, size_t imageSize, const void* metadata, size_t metadataSize,
+                              int robotRadius);
+
+} // BE namespace
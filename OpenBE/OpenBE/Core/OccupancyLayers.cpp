@@ -0,0 +1,70 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "OccupancyLayers.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "DistanceTransform.h"
+#include "GridSearch.h"
+
+namespace BE {
+
+void dilateObstacles (const Grid<unsigned char>& raw, Grid<unsigned char>& dilated, int radius, GridRect region)
+{
+    region = region.clipped (raw.width(), raw.height());
+
+    // Only obstacles within radius matter; pixels outside the image never dilate into the map.
+    DistanceTransform distances;
+    distances.compute (raw, region.expanded (radius).clipped (raw.width(), raw.height()), 255);
+
+    const int32_t radiusSq = radius * radius;
+    for (int y = region.y0; y < region.y1; ++y)
+    {
+        const unsigned char* src = raw.row (y);
+        const int32_t* dist = distances.row (y);
+        unsigned char* dst = dilated.row (y);
+        for (int x = region.x0; x < region.x1; ++x)
+            dst[x] = dist[x] <= radiusSq ? 255 : src[x];
+    }
+}
+
+void buildTopoMap (const Grid<unsigned char>& dilated, Grid<unsigned char>& topo, int radius, GridRect region)
+{
+    assert(dilated.border() >= 1);
+    region = region.clipped (dilated.width(), dilated.height());
+
+    // Guard cells hold 255, so leaving the map counts as running into an obstacle.
+    const int reach = std::max (1, radius * 2);
+    const GridRect extent = dilated.bounds().expanded (dilated.border());
+    DistanceTransform distances;
+    distances.compute (dilated, region.expanded (reach).intersected (extent), kBlockedThreshold);
+
+    // 1/r^2 falloff from the closest obstacle, scaled like a single cell of the old summed stencil.
+    const float scale = 255.f * 1.414f / reach;
+    const int32_t reachSq = reach * reach;
+    for (int y = region.y0; y < region.y1; y++)
+    {
+        const unsigned char* src = dilated.row (y);
+        const int32_t* dist = distances.row (y);
+        unsigned char* dst = topo.row (y);
+        for (int x = region.x0; x < region.x1; x++)
+        {
+            float accumulator = src[x];
+            if (dist[x] == 0)
+                accumulator = 255;
+            else if (dist[x] <= reachSq)
+                accumulator += scale / dist[x];
+
+            if (accumulator > 254) accumulator = 255;
+            dst[x] = (unsigned char)accumulator;
+        }
+    }
+}
+
+} // BE namespace
@@ -0,0 +1,38 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include "Grid.h"
+
+namespace BE {
+
+/**
+ * Layers the path planner derives from the raw occupancy image.
+ *
+ * Each builder works on a sub-rectangle so the same code serves the initial
+ * full-map build and local repairs after cells change at runtime. A change
+ * to raw cells in rect R affects dilated cells in R.expanded(radius) and topo
+ * cells in R.expanded(radius + max(1, 2 * radius)). Both are driven by an exact Euclidean
+ * distance transform, so their cost does not grow with the radius.
+ */
+
+/**
+ * Grow obstacles (raw value 255) by a disc of the given radius into dilated,
+ * for the cells of region. Pixels outside raw count as free space.
+ */
+void dilateObstacles (const Grid<unsigned char>& raw, Grid<unsigned char>& dilated, int radius, GridRect region);
+
+/**
+ * Build the clearance cost ("topological map") for the cells of region: the
+ * dilated value plus a 1/d^2 penalty for the distance d to the closest
+ * blocked cell, up to 2 * radius away. dilated must carry a guard band of at
+ * least one cell filled with 255.
+ */
+void buildTopoMap (const Grid<unsigned char>& dilated, Grid<unsigned char>& topo, int radius, GridRect region);
+
+} // BE namespace
@@ -0,0 +1,109 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "OccupancyPyramid.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace BE {
+
+const int OccupancyPyramid::kDefaultLevels;
+
+void OccupancyPyramid::build (const Grid<unsigned char>& map, int levels)
+{
+    assert(map.border() >= 1);
+
+    _levels.clear();
+    _levels.resize (std::max (0, levels));
+
+    int width = map.width();
+    int height = map.height();
+    for (int level = 1; level <= (int)_levels.size(); level++)
+    {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        _levels[level - 1].minimum.resize (width, height, 1, 255);
+        _levels[level - 1].maximum.resize (width, height, 1, 255);
+        reduce (map, level, _levels[level - 1].minimum.bounds());
+    }
+}
+
+void OccupancyPyramid::update (const Grid<unsigned char>& map, const GridRect& rect)
+{
+    GridRect cells = rect.clipped (map.width(), map.height());
+    for (int level = 1; level <= (int)_levels.size() && !cells.empty(); level++)
+    {
+        cells = GridRect{ cells.x0 >> 1, cells.y0 >> 1, ((cells.x1 - 1) >> 1) + 1, ((cells.y1 - 1) >> 1) + 1 };
+        reduce (map, level, cells);
+    }
+}
+
+size_t OccupancyPyramid::memoryBytes () const
+{
+    size_t bytes = 0;
+    for (const Level& level : _levels)
+        bytes += level.minimum.capacity() + level.maximum.capacity();
+    return bytes;
+}
+
+void OccupancyPyramid::reduce (const Grid<unsigned char>& map, int level, const GridRect& rect)
+{
+    // The finer level's guard band stands in for the children of odd-sized edges.
+    const Grid<unsigned char>& finerMinimum = level > 1 ? _levels[level - 2].minimum : map;
+    const Grid<unsigned char>& finerMaximum = level > 1 ? _levels[level - 2].maximum : map;
+    Level& coarse = _levels[level - 1];
+
+    for (int y = rect.y0; y < rect.y1; y++)
+    {
+        const unsigned char* min0 = finerMinimum.row (2 * y);
+        const unsigned char* min1 = finerMinimum.row (2 * y + 1);
+        const unsigned char* max0 = finerMaximum.row (2 * y);
+        const unsigned char* max1 = finerMaximum.row (2 * y + 1);
+        unsigned char* minimum = coarse.minimum.row (y);
+        unsigned char* maximum = coarse.maximum.row (y);
+
+        for (int x = rect.x0; x < rect.x1; x++)
+        {
+            minimum[x] = std::min (std::min (min0[2 * x], min0[2 * x + 1]), std::min (min1[2 * x], min1[2 * x + 1]));
+            maximum[x] = std::max (std::max (max0[2 * x], max0[2 * x + 1]), std::max (max1[2 * x], max1[2 * x + 1]));
+        }
+    }
+}
+
+void Corridor::reset (int width, int height, int shift)
+{
+    const size_t count = (size_t)width * height;
+    if (_stamps.size() != count || ++_generation == 0)
+    {
+        _stamps.assign (count, 0);
+        _generation = 1;
+    }
+    _width = width;
+    _height = height;
+    _shift = shift;
+    _cells = 0;
+}
+
+void Corridor::add (int x, int y, int radius)
+{
+    const GridRect rect = GridRect{ x - radius, y - radius, x + radius + 1, y + radius + 1 }.clipped (_width, _height);
+    for (int cy = rect.y0; cy < rect.y1; cy++)
+    {
+        uint32_t* stamps = &_stamps[(size_t)cy * _width];
+        for (int cx = rect.x0; cx < rect.x1; cx++)
+        {
+            if (stamps[cx] != _generation)
+            {
+                stamps[cx] = _generation;
+                _cells++;
+            }
+        }
+    }
+}
+
+} // BE namespace
@@ -0,0 +1,121 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+
+namespace BE {
+
+/**
+ * Min/max pyramid over the dilated occupancy map, for planning on coarser
+ * grids first.
+ *
+ * Level 0 is the map itself and is not copied; every cell of level k covers
+ * 2^k x 2^k map cells and stores the smallest and largest map value under
+ * it. A coarse cell is blocked only if every map cell under it is blocked (its
+ * minimum is), and mixed, i.e. may or may not be crossable, if any is (its
+ * maximum is). So every free route on the map maps onto a route through
+ * unblocked coarse cells, never the other way round.
+ *
+ * Levels keep a blocked guard band of one cell, like the map.
+ */
+class OccupancyPyramid
+{
+public:
+    static const int kDefaultLevels = 4;
+
+    enum CellState
+    {
+        FreeCell = 0,
+        MixedCell,
+        BlockedCell
+    };
+
+    /**
+     * Build levels 1 up to levels over map, which must have a blocked guard
+     * band of at least one cell.
+     */
+    void build (const Grid<unsigned char>& map, int levels = kDefaultLevels);
+
+    /** Recompute the coarse cells covering rect after those map cells changed. */
+    void update (const Grid<unsigned char>& map, const GridRect& rect);
+
+    void clear () { _levels.clear(); }
+
+    bool isBuilt () const { return !_levels.empty(); }
+
+    /** Levels including the map itself. */
+    int levelCount () const { return (int)_levels.size() + 1; }
+
+    /** Per level from 1: smallest and largest map value under each cell. */
+    const Grid<unsigned char>& minimum (int level) const { return _levels[level - 1].minimum; }
+    const Grid<unsigned char>& maximum (int level) const { return _levels[level - 1].maximum; }
+
+    CellState state (int level, int x, int y) const
+    {
+        const Level& coarse = _levels[level - 1];
+        if (isBlocked (coarse.minimum(x, y)))
+            return BlockedCell;
+        return isBlocked (coarse.maximum(x, y)) ? MixedCell : FreeCell;
+    }
+
+    size_t memoryBytes () const;
+
+private:
+    struct Level
+    {
+        Grid<unsigned char> minimum;
+        Grid<unsigned char> maximum;
+    };
+
+    /** Reduce the 2 x 2 blocks of the finer level under rect of level (1-based). */
+    void reduce (const Grid<unsigned char>& map, int level, const GridRect& rect);
+
+    std::vector<Level> _levels;
+};
+
+/**
+ * Cells of a coarse grid, e.g. one pyramid level, that a search on a finer
+ * grid may enter. Membership is stamped with a generation counter, so reset()
+ * does not clear anything.
+ */
+class Corridor
+{
+public:
+    /**
+     * Empty the corridor and size it for a coarse grid of width x height
+     * cells, each covering 2^shift x 2^shift cells of the searched grid.
+     */
+    void reset (int width, int height, int shift);
+
+    /** Add the coarse cells within radius of (x, y), clipped to the coarse grid. */
+    void add (int x, int y, int radius = 0);
+
+    /** True if cell (x, y) of the searched grid, which must lie on that grid, is inside the corridor. */
+    bool contains (int x, int y) const
+    {
+        return _stamps[(size_t)(y >> _shift) * _width + (x >> _shift)] == _generation;
+    }
+
+    /** Coarse cells in the corridor. */
+    size_t cellCount () const { return _cells; }
+
+private:
+    std::vector<uint32_t> _stamps;
+    int _width = 0;
+    int _height = 0;
+    int _shift = 0;
+    uint32_t _generation = 0;
+    size_t _cells = 0;
+};
+
+} // BE namespace
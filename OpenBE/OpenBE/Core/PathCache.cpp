@@ -0,0 +1,214 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "PathCache.h"
+
+#include <algorithm>
+
+namespace BE {
+
+const size_t PathCache::kDefaultCapacity;
+
+void PathCache::setCapacity (size_t capacity)
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+    _capacity = capacity;
+    evictDownTo (capacity);
+}
+
+size_t PathCache::capacity () const
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+    return _capacity;
+}
+
+void PathCache::evictDownTo (size_t capacity)
+{
+    if (_entries.size() <= capacity)
+        return;
+
+    // Most recently used first, free slots last.
+    std::sort (_entries.begin(), _entries.end(),
+               [](const Entry& a, const Entry& b) { return a.lastUsed > b.lastUsed; });
+    for (size_t i = capacity; i < _entries.size(); i++)
+    {
+        if (_entries[i].lastUsed != 0)
+            _stats.evictions++;
+    }
+    _entries.resize (capacity);
+}
+
+bool PathCache::find (const Key& key, bool subPaths, std::vector<GridPoint>& path, float& cost, GridPoint& goal)
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    for (Entry& entry : _entries)
+    {
+        if (entry.lastUsed == 0 || !(entry.key == key))
+            continue;
+        entry.lastUsed = ++_clock;
+        path.assign (entry.path.begin(), entry.path.end());
+        cost = entry.cost;
+        goal = entry.goal;
+        _stats.hits++;
+        return true;
+    }
+
+    if (subPaths)
+    {
+        for (Entry& entry : _entries)
+        {
+            if (entry.lastUsed == 0 || !entry.key.sharesGoal (key))
+                continue;
+
+            const auto first = std::find (entry.path.begin(), entry.path.end(), key.start);
+            if (first == entry.path.end())
+                continue;
+
+            entry.lastUsed = ++_clock;
+            path.assign (first, entry.path.end());
+            cost = 0.f;
+            for (size_t i = 1; i < path.size(); i++)
+                cost += octileCost (path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+            goal = entry.goal;
+            _stats.hits++;
+            _stats.subPathHits++;
+            return true;
+        }
+    }
+
+    _stats.misses++;
+    return false;
+}
+
+void PathCache::insert (const Key& key, const std::vector<GridPoint>& path, float cost, GridPoint goal, bool everyCell)
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+    if (_capacity == 0)
+        return;
+
+    // The entry for the same key, else a free slot, else a new one while below capacity,
+    // else the least recently used entry.
+    Entry* slot = nullptr;
+    Entry* oldest = nullptr;
+    for (Entry& entry : _entries)
+    {
+        if (entry.lastUsed != 0 && entry.key == key)
+        {
+            slot = &entry;
+            break;
+        }
+        if (!oldest || entry.lastUsed < oldest->lastUsed)
+            oldest = &entry;
+    }
+    if (!slot)
+    {
+        if ((!oldest || oldest->lastUsed != 0) && _entries.size() < _capacity)
+        {
+            _entries.emplace_back();
+            slot = &_entries.back();
+        }
+        else
+        {
+            slot = oldest;
+            if (slot->lastUsed != 0)
+                _stats.evictions++;
+        }
+    }
+
+    slot->key = key;
+    slot->path.assign (path.begin(), path.end());
+    slot->cost = cost;
+    slot->goal = goal;
+    slot->everyCell = everyCell;
+    slot->lastUsed = ++_clock;
+}
+
+void PathCache::invalidate ()
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    // Keep the slots and their storage for the next paths.
+    for (Entry& entry : _entries)
+    {
+        if (entry.lastUsed != 0)
+            _stats.invalidated++;
+        entry.lastUsed = 0;
+    }
+}
+
+bool PathCache::crosses (const Entry& entry, const Grid<unsigned char>& map, const GridRect& rect)
+{
+    if (entry.everyCell)
+    {
+        const auto blockedIn = [&map, &rect] (int x, int y) { return rect.contains (x, y) && isBlocked (map(x, y)); };
+        for (size_t i = 0; i < entry.path.size(); i++)
+        {
+            const GridPoint cell = entry.path[i];
+            if (blockedIn (cell.x, cell.y))
+                return true;
+
+            // Without corner cutting a diagonal step also needs both cells beside it free.
+            if (i > 0 && entry.key.cornerRule == NoCornerCutting)
+            {
+                const GridPoint previous = entry.path[i - 1];
+                if (previous.x != cell.x && previous.y != cell.y
+                    && (blockedIn (cell.x, previous.y) || blockedIn (previous.x, cell.y)))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Cells between vertices are not listed, so any segment near the change counts.
+    for (size_t i = 1; i < entry.path.size(); i++)
+    {
+        const GridPoint a = entry.path[i - 1];
+        const GridPoint b = entry.path[i];
+        const GridRect bounds{ std::min (a.x, b.x), std::min (a.y, b.y), std::max (a.x, b.x) + 1, std::max (a.y, b.y) + 1 };
+        if (!bounds.intersected (rect).empty())
+            return true;
+    }
+    return false;
+}
+
+void PathCache::invalidate (const Grid<unsigned char>& map, const GridRect& rect)
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+
+    for (Entry& entry : _entries)
+    {
+        if (entry.lastUsed != 0 && crosses (entry, map, rect))
+        {
+            entry.lastUsed = 0;
+            _stats.invalidated++;
+        }
+    }
+}
+
+void PathCache::recordLatency (bool hit, double seconds)
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+    if (hit)
+        _stats.hitSeconds += seconds;
+    else
+        _stats.missSeconds += seconds;
+}
+
+PathCache::Stats PathCache::stats () const
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+    return _stats;
+}
+
+void PathCache::resetStats ()
+{
+    std::lock_guard<std::mutex> lock (_mutex);
+    _stats = Stats();
+}
+
+} // BE namespace
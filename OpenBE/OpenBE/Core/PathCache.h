@@ -0,0 +1,135 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+
+namespace BE {
+
+/**
+ * Least recently used cache of planned cell paths, for robots shuttling
+ * between the same few points (spawn, markup nodes, the user).
+ *
+ * Paths are keyed by start cell, goal cell and the options that shape them;
+ * waypoints are not stored, so every smoothing shares one entry. Instead of a
+ * map version in the key, the owner invalidates entries as the map changes:
+ * all of them when cells are freed, since any path may have become longer
+ * than needed, and only those crossing newly blocked cells otherwise, since
+ * blocking can only make the others' alternatives longer.
+ *
+ * Every part of a shortest path is itself a shortest path, so for searches
+ * flagged optimal a query starting anywhere on a cached path to the same
+ * goal is served from its suffix.
+ *
+ * Entries live in a fixed array scanned linearly; with tens of entries that
+ * is cheaper than hashing, and storage of evicted paths is reused. All
+ * methods lock, so workers may share one cache.
+ */
+class PathCache
+{
+public:
+    static const size_t kDefaultCapacity = 32;
+
+    struct Key
+    {
+        GridPoint start = { 0, 0 };
+        GridPoint goal = { 0, 0 };
+        int algorithm = 0;
+        int cornerRule = CutCorners;
+        bool closest = false;
+
+        /** Everything but the start matches, so a path of other may hold a suffix for this. */
+        bool sharesGoal (const Key& other) const
+        {
+            return goal == other.goal && algorithm == other.algorithm && cornerRule == other.cornerRule
+                && closest == other.closest;
+        }
+
+        bool operator== (const Key& other) const { return start == other.start && sharesGoal (other); }
+    };
+
+    struct Stats
+    {
+        size_t hits = 0;            // queries served from the cache, sub-path ones included
+        size_t subPathHits = 0;     // served from the suffix of a longer path
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t invalidated = 0;     // entries dropped because the map changed
+        double hitSeconds = 0.0;    // total latency of queries served from the cache
+        double missSeconds = 0.0;   // total latency of queries that searched
+
+        double hitRate () const { return hits + misses > 0 ? (double)hits / (hits + misses) : 0.0; }
+        double meanHitSeconds () const { return hits > 0 ? hitSeconds / hits : 0.0; }
+        double meanMissSeconds () const { return misses > 0 ? missSeconds / misses : 0.0; }
+    };
+
+    explicit PathCache (size_t capacity = kDefaultCapacity) : _capacity (capacity) {}
+
+    /** Number of paths kept, 0 to turn the cache off. Shrinking drops the least recently used ones. */
+    void setCapacity (size_t capacity);
+    size_t capacity () const;
+
+    /**
+     * Look up a path for key. On a hit fills path with every cell from
+     * key.start to the goal actually planned to, sets cost and goal and
+     * returns true. With subPaths, also searches the cached paths to the same
+     * goal for key.start. Counts a miss otherwise.
+     */
+    bool find (const Key& key, bool subPaths, std::vector<GridPoint>& path, float& cost, GridPoint& goal);
+
+    /**
+     * Remember a path found for key, evicting the least recently used entry if
+     * full. Without everyCell the path is a list of vertices joined by straight
+     * segments.
+     */
+    void insert (const Key& key, const std::vector<GridPoint>& path, float cost, GridPoint goal, bool everyCell = true);
+
+    /** Drop every entry. */
+    void invalidate ();
+
+    /**
+     * Drop the entries whose path crosses a cell of rect that is blocked in
+     * map, or, without corner cutting, passes one on a diagonal step.
+     */
+    void invalidate (const Grid<unsigned char>& map, const GridRect& rect);
+
+    /** Add the latency of one query to the totals of hits or misses. */
+    void recordLatency (bool hit, double seconds);
+
+    Stats stats () const;
+    void resetStats ();
+
+private:
+    struct Entry
+    {
+        Key key;
+        std::vector<GridPoint> path;
+        float cost = 0.f;
+        GridPoint goal = { 0, 0 };
+        bool everyCell = true;
+        uint64_t lastUsed = 0;      // 0 for a free slot
+    };
+
+    void evictDownTo (size_t capacity);
+
+    static bool crosses (const Entry& entry, const Grid<unsigned char>& map, const GridRect& rect);
+
+    std::vector<Entry> _entries;
+    size_t _capacity;
+    uint64_t _clock = 0;
+    Stats _stats;
+    mutable std::mutex _mutex;
+};
+
+} // BE namespace
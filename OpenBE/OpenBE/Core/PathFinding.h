@@ -10,10 +10,49 @@
 
 @class PathFinding;
 
+/**
+ * Search used to plan a path. A*, Jump Point and Bidirectional return paths of the same (optimal) cost.
+ */
+typedef NS_ENUM(NSInteger, PathFindingAlgorithm) {
+    PathFindingAlgorithmAStar = 0,  // Plain 8-connected A*, expands every free neighbour.
+    PathFindingAlgorithmJumpPoint,  // Jump Point Search, far fewer expansions in open areas.
+    PathFindingAlgorithmHierarchical, // HPA* over clusters precomputed at load, near-optimal but scales to multi-room maps.
+    PathFindingAlgorithmIncremental,  // D* Lite, repairs the previous search after the robot moves or the map changes; optimal.
+    PathFindingAlgorithmCoarseToFine, // Routes on a 16x coarser occupancy pyramid level, then refines inside a corridor; near-optimal, for long paths.
+    PathFindingAlgorithmAnyAngle,     // Lazy Theta*, straight segments at any angle checked for line of sight while searching; near-taut
+                                      // with PathFindingSmoothingNone, string pulling only drops the odd extra vertex.
+    PathFindingAlgorithmBidirectional, // A* from both ends until the frontiers meet; optimal, deterministic, fewer expansions across walls.
+};
+
+/**
+ * Post-processing of the planned cell path into waypoints.
+ */
+typedef NS_ENUM(NSInteger, PathFindingSmoothing) {
+    PathFindingSmoothingNone = 0,   // Drop cells by spacing and direction change; waypoints may cut past obstacle corners.
+    PathFindingSmoothingStringPull, // Keep only corners, joined by straight segments with line of sight on the dilated map.
+    PathFindingSmoothingSpline,     // String pull, then round the corners with a Catmull-Rom spline kept clear of obstacles.
+};
+
+/**
+ * Counters of the path cache since it was created or last reset.
+ */
+typedef struct {
+    NSUInteger hits;                // requests served from the cache, sub-path ones included
+    NSUInteger subPathHits;         // served from the end of a cached path their start lies on
+    NSUInteger misses;              // requests that searched
+    NSUInteger evictions;
+    NSUInteger invalidated;         // paths dropped because the map changed
+    double hitRate;                 // hits / (hits + misses)
+    NSTimeInterval meanHitLatency;  // planning time per request, waypoints included
+    NSTimeInterval meanMissLatency;
+} PathFindingCacheStats;
+
 @interface PathFindingOperation : NSOperation
 @property(nonatomic) GLKVector3 from;
 @property(nonatomic) GLKVector3 to;
 @property(nonatomic) BOOL closest;
+@property(nonatomic) PathFindingAlgorithm algorithm;
+@property(nonatomic) PathFindingSmoothing smoothing;
 
 @property(nonatomic, strong) NSMutableArray * waypoints;
 
@@ -25,6 +64,13 @@
  * Default initializer: Reads occupancy map from default location
  */
 - (instancetype) init;
+/**
+ * Initializer reading the occupancy image at imagePath and the .metadata file
+ * beside it. The derived layers are cached in a .cache file next to them and
+ * reused on later launches as long as neither source nor the robot radius
+ * changed.
+ */
+- (instancetype) initWithImageFile:(NSString*) imagePath;
 /**
  * Initializer accepts user provided occupancy map
  */
@@ -45,6 +91,98 @@
 
 - (PathFindingOperation*) findNearestPath:(GLKVector3)from to:(GLKVector3)to completion:(void (^)(void))completionBlock;
 
+/**
+ * Same as above, planning with the given search algorithm instead of A*.
+ */
+- (PathFindingOperation*) findPath:(GLKVector3)from to:(GLKVector3)to algorithm:(PathFindingAlgorithm)algorithm completion:(void (^)(void))completionBlock;
+
+- (PathFindingOperation*) findNearestPath:(GLKVector3)from to:(GLKVector3)to algorithm:(PathFindingAlgorithm)algorithm completion:(void (^)(void))completionBlock;
+
+/**
+ * Same as above, coalescing requests per agent: a new request cancels the agent's previous one if it
+ * has not finished yet. A cancelled request still completes, with nil waypoints. Pass a nil agent
+ * to never coalesce.
+ *
+ * Requests are planned concurrently on a pool of worker threads; cancelling an operation stops its
+ * search while it runs.
+ */
+- (PathFindingOperation*) findPath:(GLKVector3)from to:(GLKVector3)to algorithm:(PathFindingAlgorithm)algorithm agent:(id)agent completion:(void (^)(void))completionBlock;
+
+- (PathFindingOperation*) findNearestPath:(GLKVector3)from to:(GLKVector3)to algorithm:(PathFindingAlgorithm)algorithm agent:(id)agent completion:(void (^)(void))completionBlock;
+
+/**
+ * Plan a path from from[i] to to[i] for each of count pairs, as one request on a planning thread.
+ * The waypoints of every path are packed into a single buffer of GLKVector3 (y = 0), and path i spans
+ * entries offsets[i] up to offsets[i + 1] of the uint32_t offsets buffer, count + 1 entries in all.
+ * A path that was not found is empty. Each planning thread fills a batch it keeps between requests,
+ * and the buffers are copied out of it whole, never point by point or boxed. Requests are coalesced
+ * per agent like single ones; a cancelled batch completes with nil buffers. completionBlock runs on a
+ * planning thread.
+ */
+- (void) findPaths:(const GLKVector3*)from to:(const GLKVector3*)to count:(NSUInteger)count algorithm:(PathFindingAlgorithm)algorithm agent:(id)agent completion:(void (^)(NSData *waypoints, NSData *offsets))completionBlock;
+
+/**
+ * How paths are turned into waypoints; applies to requests made after setting it. Defaults to PathFindingSmoothingNone.
+ */
+@property(nonatomic) PathFindingSmoothing smoothing;
+
+/**
+ * Landmarks per connected component used to guide A* (the ALT heuristic), 0 to turn them off; defaults to 0.
+ * Their distance tables take 4 bytes per map cell per landmark and are built on a planning thread after
+ * setting this and again after every map edit; A* uses the plain octile heuristic until they are ready.
+ * Paths stay optimal; with 4 to 8 landmarks A* expands 1.4 to 3.5 times fewer cells on maps with walls and furniture.
+ */
+@property(nonatomic) NSUInteger landmarkCount;
+
+/**
+ * Number of recent paths kept to answer repeated requests without searching, 0 to turn the cache off; defaults to 32.
+ * Paths are keyed by start and goal cell, algorithm and the closest flag. A request starting on a cached optimal path
+ * (A*, Jump Point, Incremental, Bidirectional) to the same goal is served from the rest of it. Freeing map cells drops
+ * every cached path, occupying them only the paths through them. Takes effect immediately.
+ */
+@property(nonatomic) NSUInteger pathCacheCapacity;
+
+/**
+ * Hit rate and latency of the path cache.
+ */
+- (PathFindingCacheStats) pathCacheStats;
+
+- (void) resetPathCacheStats;
+
+/**
+ * Radius of the robot in meters; obstacles are grown by it. Setting it dilates the loaded map again
+ * and rebuilds the derived maps without reloading the image. Applied in order with queued path requests.
+ */
+@property(nonatomic) float robotRadius;
+
+/**
+ * Mark a disc of the map as occupied or free, e.g. for a spawned physics object or a moved chair.
+ * The dilated, topological and connected component maps are repaired around the change,
+ * and the next PathFindingAlgorithmIncremental query repairs its previous path instead of replanning.
+ * Applied in order with queued path requests.
+ */
+- (void) setOccupied:(BOOL)occupied at:(GLKVector3)point radius:(float)radius;
+
+/**
+ * Build a flow field towards goal, shared by every agent heading there: each agent then looks up its next
+ * direction in constant time with flowFieldDirectionAt:direction: instead of planning a path of its own.
+ * Moving the goal by a few cells repairs the field around it rather than sweeping the whole map again.
+ * Built on the path planning threads, in order with map edits; a newer goal supersedes one still pending.
+ * completionBlock runs on a planning thread once the field is in use, or once it has been superseded.
+ */
+- (void) setFlowFieldGoal:(GLKVector3)goal completion:(void (^)(void))completionBlock;
+
+/**
+ * Unit direction in the x/z plane to move from point towards the flow field goal.
+ * @return NO without a flow field, at the goal, or where the goal cannot be reached.
+ */
+- (BOOL) flowFieldDirectionAt:(GLKVector3)point direction:(GLKVector3*)direction;
+
+/**
+ * Drop the flow field, and cancel goal updates still pending or running so none of them brings it back.
+ */
+- (void) clearFlowField;
+
 /**
  * Get the physical size of each occupied grid pixel.
  */
@@ -69,20 +207,31 @@
  */
 - (NSMutableArray<NSValue*> *) connectedComponentPoints;
 
+/**
+ * Same as occupiedPoints, packed into one buffer of GLKVector3 with nothing allocated per point.
+ */
+- (NSData*) occupiedPointData;
+
+/**
+ * Same as connectedComponentPoints, packed into one buffer of GLKVector3 with nothing allocated per point.
+ */
+- (NSData*) connectedComponentPointData;
+
 /**
  * Search through the connected components, finding the largest slab of it.
  * @return the component id.
  */
-- (unsigned char) largestConnectedComponent;
+- (uint32_t) largestConnectedComponent;
 
 /**
  * Searchs the connectedComponentMap for nearest reachable goal point in component.
+ * The first query for a component builds a lookup table over the map; later ones take constant time.
  * @param goalPoint goal we're trying to get to
  * @param targetComponent component that is being searched
  * @param result If successfull result is stored here
  * @return Success if a valid nearest point is found.
  */ 
-- (BOOL) closestAccessiblePointTo:(GLKVector3)goalPoint inComponent:(unsigned char)targetComponent result:(GLKVector3*)result;
+- (BOOL) closestAccessiblePointTo:(GLKVector3)goalPoint inComponent:(uint32_t)targetComponent result:(GLKVector3*)result;
 
 /**
  * Searchs the connectedComponentMap for nearest reachable goal point to a source point.
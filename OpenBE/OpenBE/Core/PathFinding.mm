@@ -10,40 +10,57 @@
 #import <SceneKit/SceneKit.h>
 #import <GLKit/GLKit.h>
 
-#include <queue>
-#include <stack>
-#include <functional>
-#include <unordered_map>
-#include <map>
+#include <atomic>
+#include <memory>
 #include <vector>
 
+#include <pthread.h>
+
+#include "OccupancyCache.h"
+#include "PathPlanner.h"
+#include "PathService.h"
+
 namespace {
 
-    class matrix {
+    /**
+     * Readers-writer lock on pthread_rwlock_t; std::shared_timed_mutex needs iOS 10 and OpenBE
+     * still deploys to 9.3. Held through MapReadLock and MapWriteLock.
+     */
+    class MapLock
+    {
     public:
-        std::vector< std::vector< unsigned char > > data;
-        int width;
-        int height;
-        
-        void resize( int w, int h ) {
-            data.resize(w);
-            for( int x=0; x<w; x++ ) {
-                data[x].resize(h);
-            }
-            width = w;
-            height = h;
-        }
-        
-        void copy( matrix &source ) {
-            resize( source.width, source.height );
-            for( int x=0; x<width; x++) {
-                for( int y=0; y<height; y++) {
-                    data[x][y] = source.data[x][y];
-                }
-            }
-        }
+        MapLock() { pthread_rwlock_init(&_lock, nullptr); }
+        ~MapLock() { pthread_rwlock_destroy(&_lock); }
+
+        MapLock(const MapLock&) = delete;
+        MapLock& operator=(const MapLock&) = delete;
+
+    private:
+        friend class MapReadLock;
+        friend class MapWriteLock;
+        pthread_rwlock_t _lock;
     };
-    
+
+    class MapReadLock
+    {
+    public:
+        explicit MapReadLock(MapLock& lock) : _lock(lock) { pthread_rwlock_rdlock(&_lock._lock); }
+        ~MapReadLock() { pthread_rwlock_unlock(&_lock._lock); }
+
+    private:
+        MapLock& _lock;
+    };
+
+    class MapWriteLock
+    {
+    public:
+        explicit MapWriteLock(MapLock& lock) : _lock(lock) { pthread_rwlock_wrlock(&_lock._lock); }
+        ~MapWriteLock() { pthread_rwlock_unlock(&_lock._lock); }
+
+    private:
+        MapLock& _lock;
+    };
+
 } // anonymous
 
 /**
@@ -51,29 +68,39 @@ namespace {
  */
 @interface PathFindingOperation ()
 @property(nonatomic, weak)  PathFinding *pathDaemon;
+@property(nonatomic) size_t worker;                      // path service worker running the search
+@property(nonatomic) const BE::CancelFlag *cancelFlag;   // raised by cancel, or by a newer request of the same agent
 
 - (instancetype) initWithFrom:(GLKVector3)from
                            to:(GLKVector3)to
                    getClosest:(BOOL)closest
+                    algorithm:(PathFindingAlgorithm)algorithm
                        daemon:(PathFinding*)daemon;
+
+- (void) setTicket:(std::shared_ptr<BE::PathService::Ticket>)ticket;
 @end
 
 
 @interface PathFinding ()
 {
-    matrix map;
-    matrix topoMap;
-    float** scores;
-    matrix connectedComponentMap;
+    // All planning happens in grid space; this class converts to and from world coordinates around it.
+    BE::PathPlanner planner;
     
-    int robotRadiusInPixels;
     float pixelSizeInMeters;
     
     // THESE ARE OFFSETS FROM PIXEL 0,0 top left
     float worldCenterX;
     float worldCenterY;
     
-    NSOperationQueue *pathQueue;
+    // Edits run as exclusive jobs on the path service, so searches never see them; queries answered
+    // on the caller's thread hold this shared, and the edit jobs hold it exclusively.
+    MapLock mapLock;
+    
+    // One per path service worker, reused by every findPaths: job that runs on it.
+    std::vector<BE::PathPlanner::Batch> batches;
+    
+    // Declared last so its workers are drained before the planner goes away.
+    BE::PathService pathService;
 }
 
 - (NSMutableArray*) runPathPlanningWithOperation:(PathFindingOperation*)pathOp;
@@ -82,24 +109,71 @@ namespace {
 
 @implementation PathFinding
 
-struct DijkstraNode
-{
-    int x,y;
-    float accumulatedScore;
-    float distanceTravelled;
-    float heuristic;
-    DijkstraNode* last;
-    bool operator<(const DijkstraNode& rhs) const // <3 C++11
+namespace {
+
+    const int kDefaultRobotRadiusInPixels = 2; // 7.0;
+
+    // Agent keys for background jobs: a newer job of the same kind supersedes a pending one.
+    // Agents are keyed by object address, which is never this small, and 0 is kNoAgent.
+    enum : uint64_t {
+        kFlowFieldAgent = 1,
+        kLandmarksAgent = 2
+    };
+
+    BE::PathPlanner::Algorithm plannerAlgorithm(PathFindingAlgorithm algorithm)
+    {
+        switch (algorithm) {
+            case PathFindingAlgorithmJumpPoint:    return BE::PathPlanner::JumpPointAlgorithm;
+            case PathFindingAlgorithmHierarchical: return BE::PathPlanner::HierarchicalAlgorithm;
+            case PathFindingAlgorithmIncremental:  return BE::PathPlanner::IncrementalAlgorithm;
+            case PathFindingAlgorithmCoarseToFine: return BE::PathPlanner::CoarseToFineAlgorithm;
+            case PathFindingAlgorithmAnyAngle:     return BE::PathPlanner::AnyAngleAlgorithm;
+            case PathFindingAlgorithmBidirectional: return BE::PathPlanner::BidirectionalAlgorithm;
+            case PathFindingAlgorithmAStar:
+            default:                               return BE::PathPlanner::AStarAlgorithm;
+        }
+    }
+
+    BE::PathPlanner::Smoothing plannerSmoothing(PathFindingSmoothing smoothing)
     {
-        return heuristic >= rhs.heuristic;  // we want the priority queue to put smaller elements on top
+        switch (smoothing) {
+            case PathFindingSmoothingStringPull: return BE::PathPlanner::StringPullSmoothing;
+            case PathFindingSmoothingSpline:     return BE::PathPlanner::SplineSmoothing;
+            case PathFindingSmoothingNone:
+            default:                             return BE::PathPlanner::NoSmoothing;
+        }
     }
-};
 
--(void) pixCoordToWorldXYWithPx:(int)px Py:(int)py Wxp:(float*)wx Wyp:(float*)wy
+    static_assert(sizeof(GLKVector3) == sizeof(BE::Float3), "packed buffers are read back as GLKVector3");
+
+    /**
+     * Wrap the storage of a buffer owned by holder in an NSData without copying it;
+     * the NSData keeps holder alive.
+     */
+    template <typename T, typename Holder>
+    NSData* dataWithBuffer(const std::vector<T>& buffer, std::shared_ptr<Holder> holder)
+    {
+        return [[NSData alloc] initWithBytesNoCopy:(void*)buffer.data()
+                                            length:buffer.size() * sizeof(T)
+                                       deallocator:^(void*, NSUInteger) { (void)holder; }];
+    }
+
+} // anonymous
+
+-(void) pixCoordToWorldXYWithPx:(float)px Py:(float)py Wxp:(float*)wx Wyp:(float*)wy
 {
     
-    *wx = ((float)px) * pixelSizeInMeters + worldCenterX;
-    *wy = ((float)py) * pixelSizeInMeters + worldCenterY;
+    *wx = px * pixelSizeInMeters + worldCenterX;
+    *wy = py * pixelSizeInMeters + worldCenterY;
+}
+
+- (BE::GridTransform) gridTransform
+{
+    BE::GridTransform transform;
+    transform.originX = worldCenterX;
+    transform.originZ = worldCenterY;
+    transform.cellSize = pixelSizeInMeters;
+    return transform;
 }
 
 -(void) worldCoordToPixCoordWithWx:(float)wx Wy:(float)wy Pxp:(int*)px Pyp:(int*)py
@@ -118,56 +192,28 @@ struct DijkstraNode
     return [[UIImage alloc] initWithContentsOfFile:path];
 }
 
-struct setNode
-{
-    setNode* parent;
-    unsigned char label;
-};
-
-- (setNode*) find:(setNode*)x
-{
-    if(x->parent != x)
-    {
-        x->parent = [self find:x->parent];
-        x->label = x->parent->label;
-    }
-    return x->parent;
-}
-
-- (setNode*) unionOf:(setNode*)x andSet:(setNode*) y
-{
-    setNode* xRoot = [self find:x];
-    setNode* yRoot = [self find:y];
-    
-    if(xRoot->label < yRoot->label)
-    {
-        yRoot->parent = xRoot;
-        return xRoot;
-    } else{
-        xRoot->parent = yRoot;
-        return yRoot;
-    }
-}
-
 /**
  * Check pathing from starting point to goal point.
  */
 - (bool) canPathFromStartPointX:(int)sx startPointY:(int)sy goalPointX:(int)gx goalPointY:(int) gy
 {
+    MapReadLock lock(mapLock);
+    const BE::Grid<uint32_t>& connectedComponentMap = planner.componentMap();
+    
     // Bail if requested point is out of bounds
-    if(sx < 0 || sx >= connectedComponentMap.width || sy < 0 || sy >= connectedComponentMap.height)
+    if(sx < 0 || sx >= connectedComponentMap.width() || sy < 0 || sy >= connectedComponentMap.height())
     {
         NSLog(@"Bad source point (%d, %d)", sx, sy);
         return false;
     }
     
-    if(gx < 0 || gx >= connectedComponentMap.width || gy < 0 || gy >= connectedComponentMap.height)
+    if(gx < 0 || gx >= connectedComponentMap.width() || gy < 0 || gy >= connectedComponentMap.height())
     {
         NSLog(@"Bad goal point (%d, %d)", gx, gy);
         return false;
     }
     
-    return connectedComponentMap.data[sx][sy] == connectedComponentMap.data[gx][gy] && connectedComponentMap.data[sx][sy] != 0;
+    return planner.canPath(BE::GridPoint{ sx, sy }, BE::GridPoint{ gx, gy });
 }
 
 - (instancetype) init
@@ -178,23 +224,76 @@ struct setNode
     NSString *scenePath = [documentsDirectory stringByAppendingPathComponent:@"BridgeEngineScene"];
     NSString *occupancyImagePath = [scenePath stringByAppendingPathComponent:@"OccupancyMap.png"];
 
-    UIImage * mapImage = [[UIImage alloc] initWithContentsOfFile:occupancyImagePath];
-    if( mapImage == nil ) {
-        NSLog(@"Failed to load the OccupancyMap.png from %@", occupancyImagePath);
-        return nil;
+    return [self initWithImageFile:occupancyImagePath];
+}
+
+- (instancetype) initWithImageFile:(NSString*) imagePath
+{
+    self = [super init];
+    if (self) {
+        NSString *basePath = [imagePath stringByDeletingPathExtension];
+        NSString *occupancyMetadata = [basePath stringByAppendingPathExtension:@"metadata"];
+        NSString *occupancyCache = [basePath stringByAppendingPathExtension:@"cache"];
+        
+#if defined(DEBUG)
+        NSDate* loadStartTime = [NSDate date];
+#endif
+        // Mapped, so hashing the sources reads them once without copying.
+        NSData *imageData = [NSData dataWithContentsOfFile:imagePath options:NSDataReadingMappedIfSafe error:nil];
+        if( imageData == nil ) {
+            NSLog(@"Failed to load the OccupancyMap.png from %@", imagePath);
+            return nil;
+        }
+        NSData *metadataData = [NSData dataWithContentsOfFile:occupancyMetadata options:NSDataReadingMappedIfSafe error:nil];
+        if( metadataData == nil ) {
+            NSLog(@"Failed to load the OccupancyMap.metadata from %@", occupancyMetadata);
+            return nil;
+        }
+        
+        planner.setWorkerCount(pathService.threadCount());
+        batches.resize(pathService.threadCount());
+        
+        const uint64_t sourceHash = BE::hashOccupancySource(imageData.bytes, imageData.length,
+                                                            metadataData.bytes, metadataData.length,
+                                                            kDefaultRobotRadiusInPixels);
+        BE::OccupancyCache cache;
+        if( cache.open(occupancyCache.fileSystemRepresentation, sourceHash) && planner.load(cache) ) {
+            const BE::OccupancyCache::Info info = cache.info();
+            worldCenterX = info.originX;
+            worldCenterY = info.originZ;
+            pixelSizeInMeters = info.metersPerPixel;
+            be_NSDbg(@"Loaded occupancy cache in %fs", [[NSDate date] timeIntervalSinceDate:loadStartTime]);
+        } else {
+            UIImage *mapImage = [UIImage imageWithData:imageData];
+            if( mapImage == nil ) {
+                NSLog(@"Failed to decode the OccupancyMap.png from %@", imagePath);
+                return nil;
+            }
+            if( ![self loadMetadata:metadataData] ) {
+                NSLog(@"Failed to load the OccupancyMap.metadata from %@", occupancyMetadata);
+                return nil;
+            }
+            BE::Grid<unsigned char> rawMap;
+            [self loadRawMap:mapImage into:rawMap];
+            planner.load(rawMap, kDefaultRobotRadiusInPixels);
+            
+            BE::OccupancyCache::Info info;
+            info.originX = worldCenterX;
+            info.originZ = worldCenterY;
+            info.metersPerPixel = pixelSizeInMeters;
+            if( !planner.save(occupancyCache.fileSystemRepresentation, sourceHash, info) ) {
+                NSLog(@"Failed to write the occupancy cache to %@", occupancyCache);
+            }
+            be_NSDbg(@"Built occupancy layers in %fs", [[NSDate date] timeIntervalSinceDate:loadStartTime]);
+        }
     }
-    return [self initWithImage:mapImage];
+    return self;
 }
 
 - (instancetype) initWithImage:(UIImage*) mapImage
 {
     self = [super init];
     if (self) {
-        robotRadiusInPixels = 2; // 7.0;
-        pixelSizeInMeters = 0.04; // 0.04;
-        worldCenterX = -2.89995;
-        worldCenterY= -2.90582;
-        
         //Load occupancy map
         
         NSArray *paths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory,
@@ -202,287 +301,318 @@ struct setNode
         NSString *documentsDirectory = [paths objectAtIndex:0];
         NSString *scenePath = [documentsDirectory stringByAppendingPathComponent:@"BridgeEngineScene"];
         NSString *occupancyMetadata = [scenePath stringByAppendingPathComponent:@"OccupancyMap.metadata"];
-
-        // Parse the metadata file for three values, OriginX, OriginZ, PixelSize.
-        // Example:
-        // { "OriginX" :-3.5293,
-        //   "OriginZ": -1.42487,
-        //   "MetersPerPixel" : 0.04 }
-        NSString *metadata = [[NSString alloc] initWithContentsOfFile:occupancyMetadata encoding:NSUTF8StringEncoding error:nil];
-        if( metadata != nil && [metadata length] > 0 ) {
-            NSError *error;
-            NSData *data = [metadata dataUsingEncoding:NSUTF8StringEncoding];
-            NSDictionary *jsonDictionary = [NSJSONSerialization JSONObjectWithData:data
-                                             options:kNilOptions
-                                             error:&error];
-            NSAssert(error == nil, @"Error decoding occupancy map : %@", error.localizedDescription);
-            
-            worldCenterX = [jsonDictionary[@"OriginX"] doubleValue];
-            worldCenterY = [jsonDictionary[@"OriginZ"] doubleValue];
-            pixelSizeInMeters = [jsonDictionary[@"MetersPerPixel"] doubleValue];
-        } else {
+        
+        if( ![self loadMetadata:[NSData dataWithContentsOfFile:occupancyMetadata]] ) {
             NSLog(@"Failed to load the OccupancyMap.metadata from %@", occupancyMetadata);
             return nil;
         }
         
         //do initialization
-        map.resize(mapImage.size.width, mapImage.size.height);
-        
-        CGImageRef image = [mapImage CGImage];
-        NSUInteger width = CGImageGetWidth(image);
-        NSUInteger height = CGImageGetHeight(image);
-        CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-        unsigned char *rawData = (unsigned char *)malloc(height * width * 4);
-        NSUInteger bytesPerPixel = 4;
-        NSUInteger bytesPerRow = bytesPerPixel * width;
-        NSUInteger bitsPerComponent = 8;
-        CGContextRef context = CGBitmapContextCreate(rawData, width, height, bitsPerComponent, bytesPerRow, colorSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
-        CGColorSpaceRelease(colorSpace);
-        
-        CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
-        CGContextRelease(context);
-        
-        for(int y = 0; y < mapImage.size.height; y++)
-        {
-            for(int x = 0; x < mapImage.size.width; x++)
-            {
-                map.data[x][y] = rawData[(bytesPerRow * y) + x * bytesPerPixel];  //map images should be B&W; use red channel.
-            }
-        }
-        
-        free(rawData);
-
-
-        matrix mapCopy;
-        mapCopy.resize(map.width, map.height);
-        mapCopy.copy(map);
-
-        // Dialate the occupied regions by the radius
-        for (int y = 0; y < map.height; ++y)
-        for (int x = 0; x < map.width; ++x)
-        {
-            for (int dy = -robotRadiusInPixels; dy <= robotRadiusInPixels; dy++)
-            for (int dx = -robotRadiusInPixels; dx <= robotRadiusInPixels; dx++)
-            {
-                const int py = y + dy;
-                const int px = x + dx;
-
-                if(dy*dy + dx*dx > robotRadiusInPixels*robotRadiusInPixels)
-                    continue;
-
-                if(py < 0 || py >= map.height || px < 0 || px >= map.width) continue;
-
-
-                if (mapCopy.data[px][py] == 255)
-                    map.data[x][y] = 255;
-            }
-        }
-        
-        // ------------ Create 1/r^2 topological map ------------
-        
-        topoMap.resize(map.width, map.height);
-        topoMap.copy(map);
-        
-        int accumulateSize = robotRadiusInPixels*2;
-        
-        for(int y = 0; y < topoMap.height; y++)
-        {
-            for(int x = 0; x < topoMap.width; x++)
-            {
-                float accumulator = 0;
-                for(int dy = -1*accumulateSize; dy <= accumulateSize; dy++)
-                {
-                    for(int dx = -1*accumulateSize; dx <= accumulateSize; dx++)
-                    {
-                        int py = y + dy;
-                        int px = x + dx;
-                        
-                        if(dx == 0 && dy == 0) continue;
-                        
-                        if(py < 0 || py >= map.height || px < 0 || px >= map.width)
-                        {
-                            accumulator += 255.0f / (dx*dx + dy*dy);
-                            continue;
-                        }
-                        
-                        if(map.data[px][py] >= 254)
-                        {
-                            accumulator += ((float)map.data[px][py]) / (dx*dx + dy*dy);
-                        }
-                    }
-                }
-                
-                accumulator = accumulator / (accumulateSize/1.414);
-                accumulator += map.data[x][y];
-                if(accumulator > 254) accumulator = 255;
-                topoMap.data[x][y] = (unsigned char) accumulator;
-            }
-        }
-        
-        // Create a scores map.
-        scores = new float*[topoMap.height];
-        for(int y = 0; y < topoMap.height; y++)
-        {
-            scores[y] = new float[topoMap.width];
-            for(int x = 0; x < topoMap.width; x++)
-            {
-                //oc_dbg("%i %i", y, x);
-                scores[y][x] = -1;
-            }
-        }
+#if defined(DEBUG)
+        NSDate* loadStartTime = [NSDate date];
+#endif
+        planner.setWorkerCount(pathService.threadCount());
+        batches.resize(pathService.threadCount());
         
-        // Creat a queue for background processing.
-        pathQueue = [[NSOperationQueue alloc] init];
-        pathQueue.qualityOfService = NSQualityOfServiceBackground;
-        pathQueue.maxConcurrentOperationCount = 1;
-        pathQueue.name = @"PathFinding Queue";
+        BE::Grid<unsigned char> rawMap;
+        [self loadRawMap:mapImage into:rawMap];
+        planner.load(rawMap, kDefaultRobotRadiusInPixels);
+        be_NSDbg(@"Built occupancy layers in %fs", [[NSDate date] timeIntervalSinceDate:loadStartTime]);
     }
+    return self;
+}
+
+/**
+ * Parse the metadata file for three values, OriginX, OriginZ, PixelSize.
+ * Example:
+ * { "OriginX" :-3.5293,
+ *   "OriginZ": -1.42487,
+ *   "MetersPerPixel" : 0.04 }
+ */
+- (BOOL) loadMetadata:(NSData*) data
+{
+    pixelSizeInMeters = 0.04; // 0.04;
+    worldCenterX = -2.89995;
+    worldCenterY= -2.90582;
     
-    // ------------ Connected component labelling -----------
-    
-    connectedComponentMap.resize(topoMap.width, topoMap.height);
-    
-    // Two-pass connected component algorithm.
-    // Areas are considered "connected" if they are not separated by an impassible obstacle.
-    
-    struct point
-    {
-        int x,y;
-        unsigned char label;
-    };
-    
-    setNode*** disjointSet = new setNode**[connectedComponentMap.height];
-    for(int i = 0; i < connectedComponentMap.height; i++)
-    {
-        disjointSet[i] = new setNode*[connectedComponentMap.width];
-        for(int j = 0; j < connectedComponentMap.width; j++)
-        {
-            disjointSet[i][j] = nullptr;
-        }
+    if( data == nil || [data length] == 0 ) {
+        return NO;
     }
     
-    std::vector<setNode*> linked;  // Indexed by label, this should hold the root node of each linked set.
-    linked.push_back(nullptr); // Because the first valid label is 1, we need to offset this a little.
-    unsigned char nextLabel = 1;
-    
-    //Pass 1: Generate labels
-    for(int y = 0; y < map.height; y++)
-    {
-        for(int x = 0; x < map.width; x++)
-        {
-//            NSLog(@"Labeling at: (%d, %d)\n", x, y);
-            if (map.data[x][y] == 255)
-                continue;
-
-            //find neighbors that are not obstacles
-            std::vector<point> neighbors;
-            for(int dy=-1; dy <= 0; dy++)
-            {
-                for(int dx=-1; dx <=1; dx++)
-                {
-                    if(dy >= 0 && dx >= 0) continue; // only concern yourself with points that could have been previously labelled
-                                                     // This looks NW, N, NE, W of the current point
-                    
-                    int px = x+dx;
-                    int py = y+dy;
-                    
-                    if(px < 0 || px >= map.width || py < 0 || py >= map.height) continue;
-                    
-                    if(map.data[px][py] <= 254)
-                    {
-                        point p;
-                        p.x = px;
-                        p.y = py;
-                        p.label = disjointSet[py][px]->label;
-                        
-                        neighbors.push_back(p);
-                    }
-                }
-            }
-            
-            if(neighbors.size() == 0)
-            {
-                // If this point has no neighbors it's deserving of a new label.
-                // This label might eventually be found to be equivalent to an older label, but we'll get to that.
-
-                disjointSet[y][x] = new setNode;
-                disjointSet[y][x]->label = nextLabel;
-                disjointSet[y][x]->parent = disjointSet[y][x];
-                
-                linked.push_back(disjointSet[y][x]);
-                nextLabel++;
-            } else{
-                // If there are a few neighbors, we should include them all in the smallest label's set.
-                int smallestLabel = INT_MAX;
-                for(int i = 0; i < neighbors.size(); i++)
-                {
-                    if(neighbors[i].label < smallestLabel)
-                        smallestLabel = neighbors[i].label;
-                }
-                
-//                    NSLog(@"\t Has %lu neighbors - smallest label: %d\n", neighbors.size(), smallestLabel);
-                
-                // Add the current point to the smallest label set.
-                disjointSet[y][x] = linked[smallestLabel];
-                
-                for(int i=0; i < neighbors.size(); i++)
-                {
-                    linked[smallestLabel] = [self unionOf:linked[smallestLabel] andSet:disjointSet[neighbors[i].y][neighbors[i].x]];
-                }
-            }
-        }
-    }
+    NSError *error;
+    NSDictionary *jsonDictionary = [NSJSONSerialization JSONObjectWithData:data
+                                     options:kNilOptions
+                                     error:&error];
+    NSAssert(error == nil, @"Error decoding occupancy map : %@", error.localizedDescription);
     
-    // Pass 2 - find and fix equivalent labels
-    for(int y = 0; y < topoMap.height; y++)
+    worldCenterX = [jsonDictionary[@"OriginX"] doubleValue];
+    worldCenterY = [jsonDictionary[@"OriginZ"] doubleValue];
+    pixelSizeInMeters = [jsonDictionary[@"MetersPerPixel"] doubleValue];
+    return YES;
+}
+
+/**
+ * Copy the red channel of the occupancy image into rawMap.
+ */
+- (void) loadRawMap:(UIImage*) mapImage into:(BE::Grid<unsigned char>&) rawMap
+{
+    rawMap.resize(mapImage.size.width, mapImage.size.height, 0, 0);
+    
+    CGImageRef image = [mapImage CGImage];
+    NSUInteger width = CGImageGetWidth(image);
+    NSUInteger height = CGImageGetHeight(image);
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    unsigned char *rawData = (unsigned char *)malloc(height * width * 4);
+    NSUInteger bytesPerPixel = 4;
+    NSUInteger bytesPerRow = bytesPerPixel * width;
+    NSUInteger bitsPerComponent = 8;
+    CGContextRef context = CGBitmapContextCreate(rawData, width, height, bitsPerComponent, bytesPerRow, colorSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+    CGColorSpaceRelease(colorSpace);
+    
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGContextRelease(context);
+    
+    for(int y = 0; y < rawMap.height(); y++)
     {
-        for(int x = 0; x < topoMap.width; x++)
+        const unsigned char *src = rawData + bytesPerRow * y;
+        unsigned char *dst = rawMap.row(y);
+        for(int x = 0; x < rawMap.width(); x++)
         {
-            if(disjointSet[y][x] == nullptr)
-                connectedComponentMap.data[x][y] = 0;
-            else
-                connectedComponentMap.data[x][y] = [self find:disjointSet[y][x]]->label;
+            dst[x] = src[x * bytesPerPixel];  //map images should be B&W; use red channel.
         }
     }
     
-    // Clean up
-    for(int i = 0; i < connectedComponentMap.height; i++)
-    {
-        delete[] disjointSet[i];
-    }
-    delete[] disjointSet;
-    
-    return self;
+    free(rawData);
 }
 
 - (BOOL) occupied:(GLKVector3)target {
+    MapReadLock lock(mapLock);
     int posx, posy;
     [self worldCoordToPixCoordWithWx:target.x Wy:target.z Pxp:&posx Pyp:&posy];
     
-    if( posx < 0 || posx >= map.width
-        || posy < 0 || posy >= map.height )
-    {
-        // Outer world is always occupied.
-         return YES;
-    } else {
-        return map.data[posx][posy] >= 254;
-    }
+    // Outer world is always occupied.
+    return planner.isOccupied(posx, posy);
 }
 
 - (PathFindingOperation*) findPath:(GLKVector3)from to:(GLKVector3)to completion:(void (^)(void))completionBlock {
-    PathFindingOperation *op = [[PathFindingOperation alloc] initWithFrom:from to:to getClosest:NO daemon:self];
+    return [self findPath:from to:to algorithm:PathFindingAlgorithmAStar completion:completionBlock];
+}
+
+- (PathFindingOperation*) findNearestPath:(GLKVector3)from to:(GLKVector3)to completion:(void (^)(void))completionBlock {
+    return [self findNearestPath:from to:to algorithm:PathFindingAlgorithmAStar completion:completionBlock];
+}
+
+- (PathFindingOperation*) findPath:(GLKVector3)from to:(GLKVector3)to algorithm:(PathFindingAlgorithm)algorithm completion:(void (^)(void))completionBlock {
+    return [self findPath:from to:to algorithm:algorithm agent:nil completion:completionBlock];
+}
+
+- (PathFindingOperation*) findNearestPath:(GLKVector3)from to:(GLKVector3)to algorithm:(PathFindingAlgorithm)algorithm completion:(void (^)(void))completionBlock {
+    return [self findNearestPath:from to:to algorithm:algorithm agent:nil completion:completionBlock];
+}
+
+- (PathFindingOperation*) findPath:(GLKVector3)from to:(GLKVector3)to algorithm:(PathFindingAlgorithm)algorithm agent:(id)agent completion:(void (^)(void))completionBlock {
+    PathFindingOperation *op = [[PathFindingOperation alloc] initWithFrom:from to:to getClosest:NO algorithm:algorithm daemon:self];
+    op.smoothing = self.smoothing;
     op.completionBlock = completionBlock;
-    [pathQueue addOperation:op];
+    [self submitOperation:op agent:agent];
     return op;
 }
 
-- (PathFindingOperation*) findNearestPath:(GLKVector3)from to:(GLKVector3)to completion:(void (^)(void))completionBlock {
-    PathFindingOperation *op = [[PathFindingOperation alloc] initWithFrom:from to:to getClosest:YES daemon:self];
+- (PathFindingOperation*) findNearestPath:(GLKVector3)from to:(GLKVector3)to algorithm:(PathFindingAlgorithm)algorithm agent:(id)agent completion:(void (^)(void))completionBlock {
+    PathFindingOperation *op = [[PathFindingOperation alloc] initWithFrom:from to:to getClosest:YES algorithm:algorithm daemon:self];
+    op.smoothing = self.smoothing;
     op.completionBlock = completionBlock;
-    [pathQueue addOperation:op];
+    [self submitOperation:op agent:agent];
     return op;
 }
 
+- (void) submitOperation:(PathFindingOperation*)op agent:(id)agent {
+    // Requests are coalesced per agent object, compared by identity.
+    const uint64_t agentKey = agent ? (uint64_t)(uintptr_t)(__bridge void*)agent : BE::PathService::kNoAgent;
+    
+    // The operation is started by hand on a worker: NSOperation still drives `finished` and the completion block.
+    [op setTicket:pathService.submit(agentKey, [op](size_t worker, const BE::CancelFlag& cancelled) {
+        op.worker = worker;
+        op.cancelFlag = &cancelled;
+        [op start];
+    })];
+}
+
+- (void) findPaths:(const GLKVector3*)from to:(const GLKVector3*)to count:(NSUInteger)count algorithm:(PathFindingAlgorithm)algorithm agent:(id)agent completion:(void (^)(NSData *waypoints, NSData *offsets))completionBlock {
+    // Copied now, the caller's arrays need not outlive the call.
+    std::vector<BE::PathPlanner::Endpoints> endpoints(count);
+    for (NSUInteger i = 0; i < count; i++) {
+        endpoints[i].from = BE::Float3{ from[i].x, from[i].y, from[i].z };
+        endpoints[i].to = BE::Float3{ to[i].x, to[i].y, to[i].z };
+    }
+    
+    BE::PathPlanner::Query options;
+    options.algorithm = plannerAlgorithm(algorithm);
+    options.smoothing = plannerSmoothing(self.smoothing);
+    
+    const uint64_t agentKey = agent ? (uint64_t)(uintptr_t)(__bridge void*)agent : BE::PathService::kNoAgent;
+    pathService.submit(agentKey, [self, endpoints, options, completionBlock](size_t worker, const BE::CancelFlag& cancelled) {
+        BE::PathPlanner::Query query = options;
+        query.worker = worker;
+        query.cancel = &cancelled;
+        
+#if defined(DEBUG)
+        NSDate* startTime = [NSDate date];
+#endif
+        BE::PathPlanner::Batch& batch = batches[worker];
+        if (!planner.findPaths(endpoints.data(), endpoints.size(), [self gridTransform], query, batch)) {
+            be_NSDbg(@"Batch of %zu paths cancelled", endpoints.size());
+            if (completionBlock)
+                completionBlock(nil, nil);
+            return;
+        }
+        be_NSDbg(@"Planned %zu paths into %zu waypoints in %fs", batch.size(), batch.points.size(),
+                 [[NSDate date] timeIntervalSinceDate:startTime]);
+        
+        // Copied out, the batch is overwritten by the next job on this worker.
+        if (completionBlock)
+            completionBlock([NSData dataWithBytes:batch.points.data() length:batch.points.size() * sizeof(BE::Float3)],
+                            [NSData dataWithBytes:batch.offsets.data() length:batch.offsets.size() * sizeof(uint32_t)]);
+    });
+}
+
+- (void) submitExclusive:(void (^)(void))block {
+    pathService.submitExclusive([self, block] {
+        MapWriteLock lock(mapLock);
+        block();
+    });
+}
+
+- (float) robotRadius {
+    MapReadLock lock(mapLock);
+    return planner.robotRadius() * pixelSizeInMeters;
+}
+
+- (void) setRobotRadius:(float)robotRadius {
+    const int radiusInPixels = std::max(0, (int)roundf(robotRadius / pixelSizeInMeters));
+    
+    [self submitExclusive:^{
+        planner.setRobotRadius(radiusInPixels);
+        be_NSDbg(@"Robot radius set to %d pixels", radiusInPixels);
+    }];
+    [self updateLandmarks];
+}
+
+- (void) setOccupied:(BOOL)occupied at:(GLKVector3)point radius:(float)radius {
+    int cx, cy;
+    [self worldCoordToPixCoordWithWx:point.x Wy:point.z Pxp:&cx Pyp:&cy];
+    const float radiusInPixels = radius / pixelSizeInMeters;
+    
+    // Runs exclusively on the path service so edits never race a search.
+    [self submitExclusive:^{
+        planner.setOccupied(cx, cy, radiusInPixels, occupied);
+        be_NSDbg(@"Map cells around (%d, %d) marked %@", cx, cy, occupied ? @"occupied" : @"free");
+    }];
+    [self updateLandmarks];
+}
+
+- (NSUInteger) landmarkCount {
+    MapReadLock lock(mapLock);
+    return planner.landmarkCount();
+}
+
+- (void) setLandmarkCount:(NSUInteger)landmarkCount {
+    [self submitExclusive:^{
+        planner.setLandmarkCount((int)landmarkCount);
+    }];
+    [self updateLandmarks];
+}
+
+- (NSUInteger) pathCacheCapacity {
+    return planner.pathCache().capacity();
+}
+
+- (void) setPathCacheCapacity:(NSUInteger)pathCacheCapacity {
+    planner.pathCache().setCapacity(pathCacheCapacity);
+}
+
+- (PathFindingCacheStats) pathCacheStats {
+    const BE::PathCache::Stats stats = planner.pathCache().stats();
+    PathFindingCacheStats result;
+    result.hits = stats.hits;
+    result.subPathHits = stats.subPathHits;
+    result.misses = stats.misses;
+    result.evictions = stats.evictions;
+    result.invalidated = stats.invalidated;
+    result.hitRate = stats.hitRate();
+    result.meanHitLatency = stats.meanHitSeconds();
+    result.meanMissLatency = stats.meanMissSeconds();
+    return result;
+}
+
+- (void) resetPathCacheStats {
+    planner.pathCache().resetStats();
+}
+
+/**
+ * Rebuild the landmark tables after the map changed, alongside path requests.
+ */
+- (void) updateLandmarks {
+    pathService.submit(kLandmarksAgent, [self](size_t, const BE::CancelFlag& cancelled) {
+#if defined(DEBUG)
+        NSDate* startTime = [NSDate date];
+#endif
+        if (planner.updateLandmarks(&cancelled)) {
+            be_NSDbg(@"Built %zu landmarks using %zu bytes in %fs", planner.landmarks()->cells().size(),
+                     planner.landmarks()->memoryBytes(), [[NSDate date] timeIntervalSinceDate:startTime]);
+        }
+    });
+}
+
+- (void) setFlowFieldGoal:(GLKVector3)goal completion:(void (^)(void))completionBlock {
+    int gx, gy;
+    [self worldCoordToPixCoordWithWx:goal.x Wy:goal.z Pxp:&gx Pyp:&gy];
+    const BE::GridPoint goalLoc = { gx, gy };
+    
+    // Goal updates coalesce with each other: only the newest pending one is built.
+    pathService.submit(kFlowFieldAgent, [self, goalLoc, completionBlock](size_t, const BE::CancelFlag& cancelled) {
+        if (!cancelled.load())
+            [self updateFlowFieldTowards:goalLoc cancel:&cancelled];
+        if (completionBlock)
+            completionBlock();
+    });
+}
+
+- (void) updateFlowFieldTowards:(BE::GridPoint)goal cancel:(const BE::CancelFlag*)cancel {
+#if defined(DEBUG)
+    NSDate* startTime = [NSDate date];
+#endif
+    const bool repaired = planner.setFlowFieldGoal(goal, cancel);
+    if (cancel->load()) {
+        be_NSDbg(@"Flow field towards (%d, %d) superseded", goal.x, goal.y);
+        return;
+    }
+    
+    // clearFlowField may have run since.
+    std::shared_ptr<const BE::FlowField> field = planner.flowField();
+    be_NSDbg(@"Flow field towards (%d, %d) %@ in %fs, settled %zu cells", goal.x, goal.y,
+             repaired ? @"repaired" : @"built", [[NSDate date] timeIntervalSinceDate:startTime],
+             field ? field->stats().expanded : (size_t)0);
+}
+
+- (BOOL) flowFieldDirectionAt:(GLKVector3)point direction:(GLKVector3*)direction {
+    std::shared_ptr<const BE::FlowField> field = planner.flowField();
+    
+    int px, py, dx, dy;
+    [self worldCoordToPixCoordWithWx:point.x Wy:point.z Pxp:&px Pyp:&py];
+    if (!field || !field->step(px, py, dx, dy))
+        return NO;
+    
+    *direction = GLKVector3Normalize(GLKVector3Make((float)dx, 0.f, (float)dy));
+    return YES;
+}
+
+- (void) clearFlowField {
+    // An empty job under the goal updates' key cancels the pending ones; the running one sees the clear.
+    pathService.submit(kFlowFieldAgent, [](size_t, const BE::CancelFlag&) {});
+    planner.clearFlowField();
+}
+
 /**
  * Get the physical size of each occupied grid pixel.
  */
@@ -505,19 +635,16 @@ struct setNode
  * Generate an array of occupied points in world coordinate.
  */
 - (NSMutableArray<NSValue*> *) occupiedPoints {
-    NSMutableArray<NSValue*> *points = [NSMutableArray arrayWithCapacity:1024];
-   
-    for(int y = 0; y < map.height; y++)
+    std::vector<BE::Float3> cells;
     {
-        for(int x = 0; x < map.width; x++)
-        {
-            if( map.data[x][y] >= 254 ) {
-                float wx, wy;
-                [self pixCoordToWorldXYWithPx:x Py:y Wxp:&wx Wyp:&wy];
-                GLKVector3 p = GLKVector3Make( wx, 0.f,  wy);
-                [points addObject:[NSValue valueWithBytes:&p objCType:@encode(GLKVector3)]];
-            }
-        }
+        MapReadLock lock(mapLock);
+        planner.occupiedCells([self gridTransform], cells);
+    }
+    NSMutableArray<NSValue*> *points = [NSMutableArray arrayWithCapacity:cells.size()];
+   
+    for (const BE::Float3& cell : cells) {
+        GLKVector3 p = GLKVector3Make(cell.x, cell.y, cell.z);
+        [points addObject:[NSValue valueWithBytes:&p objCType:@encode(GLKVector3)]];
     }
 
     return points;
@@ -529,55 +656,46 @@ struct setNode
  *     Coordinates x&z in world coordinates, and y being the comonent value.
  */
 - (NSMutableArray<NSValue*> *) connectedComponentPoints {
-    NSMutableArray<NSValue*> *points = [NSMutableArray arrayWithCapacity:connectedComponentMap.width * connectedComponentMap.height];
-   
-    for(int y = 0; y < connectedComponentMap.height; y++)
+    std::vector<BE::Float3> cells;
     {
-        for(int x = 0; x < connectedComponentMap.width; x++)
-        {
-            float componentValue = connectedComponentMap.data[x][y];
-            
-            if (componentValue == 0) {
-                continue;
-            }
-            float wx, wy;
-            [self pixCoordToWorldXYWithPx:x Py:y Wxp:&wx Wyp:&wy];
-            GLKVector3 p = GLKVector3Make( wx, componentValue, wy);
-            [points addObject:[NSValue valueWithBytes:&p objCType:@encode(GLKVector3)]];
-        }
+        MapReadLock lock(mapLock);
+        planner.componentCells([self gridTransform], cells);
+    }
+    NSMutableArray<NSValue*> *points = [NSMutableArray arrayWithCapacity:cells.size()];
+   
+    for (const BE::Float3& cell : cells) {
+        GLKVector3 p = GLKVector3Make(cell.x, cell.y, cell.z);
+        [points addObject:[NSValue valueWithBytes:&p objCType:@encode(GLKVector3)]];
     }
 
     return points;
 }
 
 /**
- * Search through the connected components, finding the largest slab of it.
- * @return the component id.
+ * Packed buffers of the same points; the NSData owns the vector they were filled into.
  */
-- (unsigned char) largestConnectedComponent {
-    // Build histogram of component counts.
-    int componentCounts[256];
-    bzero(componentCounts, sizeof(componentCounts));
-    for(int y = 0; y < connectedComponentMap.height; y++)
-    {
-        for(int x = 0; x < connectedComponentMap.width; x++)
-        {
-            unsigned char componentValue = connectedComponentMap.data[x][y];
-            componentCounts[componentValue]++;
-        }
-    }
+- (NSData*) occupiedPointData {
+    std::shared_ptr<std::vector<BE::Float3>> cells = std::make_shared<std::vector<BE::Float3>>();
+    MapReadLock lock(mapLock);
+    planner.occupiedCells([self gridTransform], *cells);
+    return dataWithBuffer(*cells, cells);
+}
 
-    // Find largest component in histogram. Ignoring component zero, unless there really are no components.
-    int bestComponent = 0;
-    int bestCount=0;
-    for( int i=1; i<255; i++ ) {
-        if( componentCounts[i] > bestCount ) {
-            bestComponent = i;
-            bestCount = componentCounts[i];
-        }
-    }
+- (NSData*) connectedComponentPointData {
+    std::shared_ptr<std::vector<BE::Float3>> cells = std::make_shared<std::vector<BE::Float3>>();
+    MapReadLock lock(mapLock);
+    planner.componentCells([self gridTransform], *cells);
+    return dataWithBuffer(*cells, cells);
+}
 
-    return bestComponent;
+/**
+ * Search through the connected components, finding the largest slab of it.
+ * @return the component id.
+ */
+- (uint32_t) largestConnectedComponent {
+    // Component sizes are kept up to date by the labeller.
+    MapReadLock lock(mapLock);
+    return planner.largestComponent();
 }
 
 
@@ -588,39 +706,20 @@ struct setNode
  * @param result If successfull result is stored here
  * @return Success if a valid nearest point is found.
  */ 
-- (BOOL) closestAccessiblePointTo:(GLKVector3)goalPoint inComponent:(unsigned char)targetComponent result:(GLKVector3*)result {
+- (BOOL) closestAccessiblePointTo:(GLKVector3)goalPoint inComponent:(uint32_t)targetComponent result:(GLKVector3*)result {
     int goalPointX, goalPointY;
     [self worldCoordToPixCoordWithWx:goalPoint.x Wy:goalPoint.z Pxp:&goalPointX Pyp:&goalPointY];
     
-    float minDistSq = FLT_MAX;
-    
-    int bestPointX=0, bestPointY=0;
-    for(int y = 0; y < map.height; y++)
-    {
-        for(int x = 0; x < map.width; x++)
-        {
-            unsigned char component = connectedComponentMap.data[x][y];
-            if( component == targetComponent )
-            {
-                float distSq = (goalPointX - x)*(goalPointX - x) + (goalPointY - y)*(goalPointY - y);
-                if(distSq < minDistSq)
-                {
-                    minDistSq = distSq;
-                    bestPointX = x;
-                    bestPointY = y;
-                }
-            }
-        }
-    }
-    
-    if( minDistSq == FLT_MAX ) {
-        be_NSDbg(@"No option with component. id: %d", (int)targetComponent);
+    BE::GridPoint best;
+    MapReadLock lock(mapLock);
+    if( !planner.nearestInComponent(targetComponent, BE::GridPoint{ goalPointX, goalPointY }, best) ) {
+        be_NSDbg(@"No option with component. id: %u", targetComponent);
         return NO;
     }
     
     float bestWorldPointX, bestWorldPointY;
     
-    [self pixCoordToWorldXYWithPx:bestPointX Py:bestPointY Wxp:&bestWorldPointX Wyp:&bestWorldPointY];
+    [self pixCoordToWorldXYWithPx:best.x Py:best.y Wxp:&bestWorldPointX Wyp:&bestWorldPointY];
     *result = GLKVector3Make(bestWorldPointX, 0, bestWorldPointY);
     return YES;
 }
@@ -635,10 +734,6 @@ struct setNode
  */ 
 - (BOOL) closestAccessiblePointTo:(GLKVector3)goalPoint fromPoint:(GLKVector3)sourcePoint result:(GLKVector3*)result
 {
-//     FIXME: Note this code should probably be completely refactored to use the above:
-//    - (BOOL) closestAccessiblePointTo:(GLKVector3)goalPoint inComponent:(unsigned char)targetComponent result:(GLKVector3*)result
-//    Just need to get the targetComponent from the sourcePoint.
-    
     int goalPointX, goalPointY;
     [self worldCoordToPixCoordWithWx:goalPoint.x Wy:goalPoint.z Pxp:&goalPointX Pyp:&goalPointY];
     
@@ -646,36 +741,19 @@ struct setNode
     [self worldCoordToPixCoordWithWx:sourcePoint.x Wy:sourcePoint.z Pxp:&sourcePointX Pyp:&sourcePointY];
 
     be_NSDbg( @"Getting closest point to map goal: (%d,%d)  from: (%d,%d)", goalPointX, goalPointY, sourcePointX, sourcePointY);
-    if( connectedComponentMap.data[sourcePointX][sourcePointY] == 0 ) {
+    MapReadLock lock(mapLock);
+    if( planner.isOccupied(sourcePointX, sourcePointY) ) {
         NSLog(@"Bad Source Point?");
     }
     
-    float minDistSq = FLT_MAX;
-    
-    int bestPointX=0, bestPointY=0;
-    for(int y = 0; y < map.height; y++)
-    {
-        for(int x = 0; x < map.width; x++)
-        {
-            if([self canPathFromStartPointX:sourcePointX startPointY:sourcePointY goalPointX:x goalPointY:y])
-            {
-                float distSq = (goalPointX - x)*(goalPointX - x) + (goalPointY - y)*(goalPointY - y);
-                if(distSq < minDistSq)
-                {
-                    minDistSq = distSq;
-                    bestPointX = x;
-                    bestPointY = y;
-                }
-            }
-        }
-    }
-    
-    if( minDistSq == FLT_MAX ) {
-        be_NSDbg(@"No pathing option from sourcePoint. id: %d", (int)connectedComponentMap.data[sourcePointX][sourcePointY]);
+    BE::GridPoint best;
+    if( !planner.nearestReachable(BE::GridPoint{ sourcePointX, sourcePointY }, BE::GridPoint{ goalPointX, goalPointY }, best) ) {
+        be_NSDbg(@"No pathing option from sourcePoint (%d,%d)", sourcePointX, sourcePointY);
         return NO;
     } else {
-        be_NSDbg(@"best: (%d,%d)", bestPointX,bestPointY);
+        be_NSDbg(@"best: (%d,%d)", best.x, best.y);
     }
+    const int bestPointX = best.x, bestPointY = best.y;
     
     float bestWorldPointX, bestWorldPointY;
     [self pixCoordToWorldXYWithPx:bestPointX Py:bestPointY Wxp:&bestWorldPointX Wyp:&bestWorldPointY];
@@ -695,7 +773,7 @@ struct setNode
 
 - (NSMutableArray*) runPathPlanningWithOperation:(PathFindingOperation*)pathOp
 {
-    static uint32_t path_id = 0;
+    static std::atomic<uint32_t> path_id(0);
     int startPosX;
     int startPosY;
     int goalPosX;
@@ -706,8 +784,8 @@ struct setNode
 
     be_NSDbg(@"Start of run path planning!");
     
-    if(startPosX < 0 || startPosX >= topoMap.width ||
-       startPosY < 0 || startPosY >= topoMap.height)
+    if(startPosX < 0 || startPosX >= planner.width() ||
+       startPosY < 0 || startPosY >= planner.height())
     {
         NSLog(@"Something strange happened to startPosX: %d or startPosY: %d\n",
               startPosX,
@@ -718,215 +796,67 @@ struct setNode
     
     be_NSDbg(@"Trying to path plan from (%d, %d) to (%d, %d)\n", startPosX, startPosY, goalPosX, goalPosY);
     
-    // ------------ Djikstra search for path ------------
-    // Algorithm should seek to minimize the sum of traversed values on the topoMap.
-    // This will keep the robot away from edges, and will probably cause it to follow smooth paths.
-    
-
     NSMutableArray *waypoints = [[NSMutableArray alloc] initWithCapacity:16];
 
     if(![self canPathFromStartPointX:startPosX startPointY:startPosY goalPointX:goalPosX goalPointY:goalPosY])
     {
         NSLog(@"Requested start and end points are not in the same connected component");
-
-        if( pathOp.closest ) {
-            GLKVector3 pt;
-            
-            if( [self closestAccessiblePointTo:pathOp.to fromPoint:pathOp.from result:&pt] ) {
-                [self worldCoordToPixCoordWithWx:pt.x Wy:pt.z Pxp:&goalPosX Pyp:&goalPosY];
-                NSLog(@"Pathing to (%d, %d) instead\n", goalPosX, goalPosY);
-            } else {
-                return waypoints;
-            }
-        } else {
+        if( !pathOp.closest ) {
             return waypoints;
         }
     }
 
-    
 #if defined(DEBUG)
     NSDate* startTime = [NSDate date];
 #endif
     
-    be_NSDbg(@"starting A*");
-
-    using GraphLocation = std::pair<int16_t, int16_t>;
-    const int w = topoMap.width;
-    const int h = topoMap.height;
-
-    // Normal, 2D -> linear array access
-    auto hashFcn = [w](const GraphLocation& g) -> size_t
-    {
-        return g.second * w + g.first;
-    };
-
-    // Normal unordered maps, but they accept a special hashing function for std::pair
-    // Holds "costs so far"
-    std::unordered_map<GraphLocation, float, decltype(hashFcn)> costEstimates(w*h, hashFcn);
-    // Holds parent node used to reach you. Used reconstruct the path
-    std::unordered_map<GraphLocation, GraphLocation, decltype(hashFcn)> parents(w*h, hashFcn);
-    // Key is cost estimate (cost so far + heursitic)
-    std::multimap<float, GraphLocation> priorityQueue;
-
-    const GraphLocation startLoc = std::make_pair(startPosX, startPosY);
-    const GraphLocation goalLoc = std::make_pair(goalPosX, goalPosY);
-
-    // Set up first node
-    parents[startLoc] = startLoc; // unique invariant for starting node: you are your parent
-    priorityQueue.insert(std::make_pair(0.f, startLoc));
-    costEstimates[startLoc] = 0.f;
-
-    // Returns true if a location is on the graph
-    auto inRange = [w, h](const GraphLocation& loc) -> bool
-    {
-        return ((loc.first >= 0) &&
-                (loc.second >= 0) &&
-                (loc.first < w) &&
-                (loc.second < h));
-    };
-
-    // Get all in-range, non-obstacle, neighbors from a location (excluding self)
-    auto getNeighbors = [inRange, self](const GraphLocation& currentLocation) -> std::vector<GraphLocation>
-    {
-        std::vector<GraphLocation> neighborCandidates;
-        neighborCandidates.resize(8);
-
-        const std::initializer_list<GraphLocation> neighborIndices { {-1, -1}, {-1, 0}, {-1, 1},
-                                                                     {0, -1} ,          {0, 1} ,
-                                                                     {1, -1} , {1, 0} , {1, 1} };
-        for (const auto& ni : neighborIndices)
-        {
-            int16_t x, y;
-            std::tie(x, y) = ni;
-            GraphLocation neighborCandidate(currentLocation.first + x, currentLocation.second + y);
-            if (inRange(neighborCandidate)
-                && (map.data[neighborCandidate.first][neighborCandidate.second] < 254))
-                neighborCandidates.push_back(neighborCandidate);
-        }
-        return neighborCandidates;
-    };
-
-    // Cost to take one step on the graph
-    auto stepCostFcn = [](const GraphLocation& current, const GraphLocation& next) -> float
-    {
-        if (current.first == next.first || current.second == next.second)
-            // directly left, right, up, or down
-            return 1.f;
-        else
-            // diagonal
-            return 1.414213f;
-    };
-
-    auto diagonalDist = [](const GraphLocation& a, const GraphLocation& b) -> float
-    {
-        const int dx = abs(a.first - b.first);
-        const int dy = abs(a.second - b.second);
-        return (dx + dy) + (1.41412f - 2.f) * std::min(dx, dy);
-    };
-
-    bool solutionFound = false;
-    while (!priorityQueue.empty())
-    {
-        // Get node on the frontier with lowest estimated cost
-        const GraphLocation current = priorityQueue.begin()->second;
-        priorityQueue.erase(priorityQueue.begin());
-
-        // A* is "best-first" so if we get here we're done
-        if (current == goalLoc)
-        {
-            solutionFound = true;
-            break;
-        }
-
-        for (auto neighbor : getNeighbors(current))
-        {
-            const float neighborCost = costEstimates[current] + stepCostFcn(current, neighbor);
-            const bool isNew = costEstimates.find(neighbor) == costEstimates.end();
-
-            // if the neighbor is not yet visited or if we found a new, better way to get there
-            if (isNew || neighborCost < costEstimates[neighbor])
-            {
-                costEstimates[neighbor] = neighborCost;
-                const float heuristicCost = neighborCost + diagonalDist(goalLoc, neighbor);
-                priorityQueue.insert(std::make_pair(heuristicCost, neighbor));
-                parents[neighbor] = current;
-            }
-        }
+    BE::PathPlanner::Query query;
+    query.start = BE::GridPoint{ startPosX, startPosY };
+    query.goal = BE::GridPoint{ goalPosX, goalPosY };
+    query.algorithm = plannerAlgorithm(pathOp.algorithm);
+    query.smoothing = plannerSmoothing(pathOp.smoothing);
+    query.closest = pathOp.closest;
+    query.worker = pathOp.worker;
+    query.cancel = pathOp.cancelFlag;
+    
+    BE::PathPlanner::Result result;
+    planner.findPath(query, result);
+    
+    if (result.builtAbstraction) {
+        const BE::PathPlanner::AbstractionStats stats = planner.abstractionStats();
+        be_NSDbg(@"Built path abstraction with %zu nodes, %zu edges in %fs", stats.nodes, stats.edges, stats.seconds);
+    }
+    
+    if (result.cancelled) {
+        be_NSDbg(@"Path planning cancelled after expanding %zu nodes", result.expanded);
+        return nil;
     }
-
-    std::stack<GraphLocation> simplifiedPath;
     
-    be_NSDbg(@"Completed in %fs", [[NSDate date] timeIntervalSinceDate:startTime]);
+    if (result.goal != query.goal) {
+        NSLog(@"Pathing to (%d, %d) instead\n", result.goal.x, result.goal.y);
+    }
     
-    // ------------- Draw the path if it exists. -------------
-    if (!solutionFound)
+    be_NSDbg(@"Completed in %fs, expanded %zu nodes%@", [[NSDate date] timeIntervalSinceDate:startTime], result.expanded,
+             result.cached ? @" (cached)" : @"");
+    
+    if (!result.found)
     {
         NSLog(@"Could not find a path!");
+        return waypoints;
+    }
+    
+    NSLog(@"Found a path with score %f, and path_id: %u", result.cost, ++path_id);
+    
+    for (const BE::PathPoint& point : result.waypoints) {
+        float wx, wy;
+        [self pixCoordToWorldXYWithPx:point.x Py:point.y Wxp:&wx Wyp:&wy];
         
-    } else{
-        
-        path_id++;
-        NSLog(@"Found a path with score %f, and path_id: %u", costEstimates[goalLoc], path_id);
-
-        float lastX = goalPosX;
-        float lastY = goalPosY;
-        
-        float lastDx = NAN;
-        float lastDy = NAN;
-        
-        float pointsSinceLastWp = 0;  //TODO float max
+        be_NSDbg(@"Waypoint: %f, %f \t %f, %f", point.x, point.y, wx, wy);
         
-        simplifiedPath.push(goalLoc);
-        GraphLocation currentLocation = goalLoc;
-
-        while(parents[currentLocation] != currentLocation)
-        {
-            //                mapImage(cn->x, cn->y)[0] = 255;
-            //                mapImage(cn->x, cn->y)[1] = 0;
-            //                mapImage(cn->x, cn->y)[2] = 0;
-            
-            float dx = lastX - currentLocation.first;
-            float dy = lastY - currentLocation.second;
-            
-            if(pointsSinceLastWp > robotRadiusInPixels/2 && (lastDx != dx || lastDy != dy))
-            {
-                pointsSinceLastWp = 0;
-                lastDx = dx;
-                lastDy = dy;
-                simplifiedPath.push(currentLocation);
-            }
-            
-            pointsSinceLastWp++;
-            
-            lastX = currentLocation.first;
-            lastY = currentLocation.second;
-
-            currentLocation = parents[currentLocation];
-        }
-        
-        uint32_t sequence_number = 0;
-        while(simplifiedPath.size() > 0)
-        {
-            GraphLocation node = simplifiedPath.top();
-            simplifiedPath.pop();
-            
-            //                mapImage(cn->x, cn->y)[0] = 255;
-            //                mapImage(cn->x, cn->y)[1] = 255;
-            //                mapImage(cn->x, cn->y)[2] = 0;
-            
-            float wx, wy;
-            [self pixCoordToWorldXYWithPx:node.first Py:node.second Wxp:&wx Wyp:&wy];
-
-            
-            be_NSDbg(@"Waypoint: %i, %i \t %f, %f", node.first, node.second, wx, wy);
-            
-            // if( cn->x != startPosX || cn->y != startPosY ) {
-            GLKVector3 target = GLKVector3Make( wx, 0.f,  wy);
-            [waypoints addObject:[NSValue valueWithBytes:&target objCType:@encode(GLKVector3)]];
-            // }
-            sequence_number++;
-        }
+        GLKVector3 target = GLKVector3Make( wx, 0.f,  wy);
+        [waypoints addObject:[NSValue valueWithBytes:&target objCType:@encode(GLKVector3)]];
     }
+    be_NSDbg(@"Reduced %zu path cells to %lu waypoints", result.cells, (unsigned long)waypoints.count);
     
     return waypoints;
 }
@@ -934,22 +864,46 @@ struct setNode
 @end
 
 @implementation PathFindingOperation
+{
+    std::shared_ptr<BE::PathService::Ticket> _ticket;
+}
 
-- (instancetype) initWithFrom:(GLKVector3)from to:(GLKVector3)to getClosest:(BOOL)closest daemon:(PathFinding*)daemon
+- (instancetype) initWithFrom:(GLKVector3)from to:(GLKVector3)to getClosest:(BOOL)closest algorithm:(PathFindingAlgorithm)algorithm daemon:(PathFinding*)daemon
 {
     self = [super init];
     if (self) {
         self.from = from;
         self.to = to;
         self.closest = closest;
+        self.algorithm = algorithm;
         self.pathDaemon = daemon;
         
     }
     return self;
 }
 
+- (void) setTicket:(std::shared_ptr<BE::PathService::Ticket>)ticket {
+    @synchronized(self) {
+        _ticket = ticket;
+        if( self.cancelled ) {
+            _ticket->cancel();
+        }
+    }
+}
+
+- (void) cancel {
+    [super cancel];
+    
+    // Also stops the search if it is already running.
+    @synchronized(self) {
+        if( _ticket ) {
+            _ticket->cancel();
+        }
+    }
+}
+
 - (void) main {
-    if( self.cancelled ) {
+    if( self.cancelled || (_cancelFlag && _cancelFlag->load()) ) {
         NSLog(@"PathFindingOperation was cancled");
         return;
     }
@@ -959,7 +913,5 @@ struct setNode
     be_NSDbg(@"PathFindingOperation finished with %lu waypoints", (unsigned long)[_waypoints count] );
 }
 
-// TODO: Handle cancelling an operation.
-
 @end
 
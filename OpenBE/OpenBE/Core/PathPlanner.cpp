@@ -0,0 +1,594 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "PathPlanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "OccupancyLayers.h"
+
+namespace BE {
+
+PathPlanner::PathPlanner (size_t workerCount)
+{
+    setWorkerCount (workerCount);
+}
+
+void PathPlanner::setWorkerCount (size_t workerCount)
+{
+    workerCount = std::max<size_t> (1, workerCount);
+    _planners.resize (workerCount);
+    _jumpPointPlanners.resize (workerCount);
+    _coarseToFinePlanners.resize (workerCount);
+    _anyAnglePlanners.resize (workerCount);
+    _bidirectionalPlanners.resize (workerCount);
+    _scratch.resize (workerCount);
+}
+
+void PathPlanner::load (const Grid<unsigned char>& raw, int robotRadius)
+{
+    // Raw occupancy is kept so the map can be edited or dilated again with another radius.
+    _rawMap.copy (raw, 0, 0);
+    _robotRadius = robotRadius;
+    buildLayers();
+    layersChanged();
+}
+
+bool PathPlanner::load (const OccupancyCache& cache)
+{
+    if (!cache.isOpen())
+        return false;
+
+    // Same guard bands as buildLayers().
+    const int width = cache.width();
+    const int height = cache.height();
+    _rawMap.resize (width, height, 0, 0);
+    _map.resize (width, height, 1, 255);
+    _topoMap.resize (width, height, 1, 255);
+    _componentMap.resize (width, height, 1, 0);
+    if (!cache.read (OccupancyCache::RawLayer, _rawMap) || !cache.read (OccupancyCache::DilatedLayer, _map)
+        || !cache.read (OccupancyCache::TopoLayer, _topoMap) || !cache.read (OccupancyCache::LabelLayer, _componentMap))
+        return false;
+
+    _robotRadius = cache.info().robotRadius;
+    _relabeller.reset (_componentMap);
+    layersChanged();
+    return true;
+}
+
+bool PathPlanner::save (const char* path, uint64_t sourceHash, OccupancyCache::Info info) const
+{
+    info.robotRadius = _robotRadius;
+    return OccupancyCache::write (path, sourceHash, info, _rawMap, _map, _topoMap, _componentMap);
+}
+
+void PathPlanner::buildLayers ()
+{
+    // Outside the map counts as occupied.
+    _map.resize (_rawMap.width(), _rawMap.height(), 1, 255);
+    dilateObstacles (_rawMap, _map, _robotRadius, _map.bounds());
+
+    _topoMap.resize (_map.width(), _map.height(), 1, 255);
+    buildTopoMap (_map, _topoMap, _robotRadius, _map.bounds());
+
+    // Areas are considered "connected" if they are not separated by an impassible obstacle.
+    _componentMap.resize (_map.width(), _map.height(), 1, 0);
+    labelConnectedComponents (_map, _componentMap);
+    _relabeller.reset (_componentMap);
+}
+
+void PathPlanner::layersChanged ()
+{
+    _pyramid.build (_map);
+    _nearestCells.invalidate();
+    _incrementalPlanner.invalidate();
+    _hierarchicalPlannerStale = true;
+    _pathCache.invalidate();
+    dropLandmarks();
+    rebuildFlowField();
+}
+
+void PathPlanner::setRobotRadius (int robotRadius)
+{
+    if (robotRadius == _robotRadius || !isLoaded())
+        return;
+
+    // The distance transform makes this cheap at any radius, so the raw map is simply dilated again.
+    _robotRadius = robotRadius;
+    dilateObstacles (_rawMap, _map, _robotRadius, _map.bounds());
+    buildTopoMap (_map, _topoMap, _robotRadius, _map.bounds());
+    labelConnectedComponents (_map, _componentMap);
+    _relabeller.reset (_componentMap);
+    _pyramid.build (_map);
+
+    _nearestCells.invalidate();
+    _incrementalPlanner.invalidate();
+    _hierarchicalPlannerStale = true;
+    _pathCache.invalidate();
+    dropLandmarks();
+    rebuildFlowField();
+}
+
+void PathPlanner::setOccupied (int cx, int cy, float radius, bool occupied)
+{
+    const int radiusInCells = (int)ceilf (radius);
+    const float radiusSq = radius * radius;
+    const GridRect changed = GridRect{ cx - radiusInCells, cy - radiusInCells,
+                                       cx + radiusInCells + 1, cy + radiusInCells + 1 }.clipped (_rawMap.width(), _rawMap.height());
+    if (changed.empty())
+        return;
+
+    for (int y = changed.y0; y < changed.y1; y++)
+    {
+        for (int x = changed.x0; x < changed.x1; x++)
+        {
+            if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= radiusSq)
+                _rawMap(x, y) = occupied ? 255 : 0;
+        }
+    }
+
+    // Dilation reaches one robot radius, the topo stencil two more and never less than one.
+    const GridRect dilated = changed.expanded (_robotRadius).clipped (_map.width(), _map.height());
+    Grid<unsigned char> before (dilated.x1 - dilated.x0, dilated.y1 - dilated.y0);
+    for (int y = dilated.y0; y < dilated.y1; y++)
+        for (int x = dilated.x0; x < dilated.x1; x++)
+            before(x - dilated.x0, y - dilated.y0) = _map(x, y);
+
+    dilateObstacles (_rawMap, _map, _robotRadius, dilated);
+
+    if (_incrementalPlanner.isInitialized())
+    {
+        for (int y = dilated.y0; y < dilated.y1; y++)
+            for (int x = dilated.x0; x < dilated.x1; x++)
+                if (isBlocked (before(x - dilated.x0, y - dilated.y0)) != isBlocked (_map(x, y)))
+                    _incrementalPlanner.cellChanged (x, y);
+    }
+
+    buildTopoMap (_map, _topoMap, _robotRadius, changed.expanded (_robotRadius + std::max (1, 2 * _robotRadius)));
+    _relabeller.relabel (_map, _componentMap, dilated);
+    _pyramid.update (_map, dilated);
+    _nearestCells.invalidate();
+    _hierarchicalPlannerStale = true;
+    // Blocking cells only lengthens the alternatives of paths that avoid them.
+    if (occupied)
+        _pathCache.invalidate (_map, dilated);
+    else
+        _pathCache.invalidate();
+    dropLandmarks();
+    rebuildFlowField();
+}
+
+bool PathPlanner::canPath (GridPoint start, GridPoint goal) const
+{
+    if (!_componentMap.inBounds (start.x, start.y) || !_componentMap.inBounds (goal.x, goal.y))
+        return false;
+
+    const uint32_t component = _componentMap(start.x, start.y);
+    return component != 0 && component == _componentMap(goal.x, goal.y);
+}
+
+bool PathPlanner::nearestInComponent (uint32_t component, GridPoint target, GridPoint& result)
+{
+    return _nearestCells.nearest (_componentMap, component, target, result);
+}
+
+bool PathPlanner::nearestReachable (GridPoint source, GridPoint target, GridPoint& result)
+{
+    const uint32_t component = _componentMap.inBounds (source.x, source.y) ? _componentMap(source.x, source.y) : 0;
+    return component != 0 && _nearestCells.nearest (_componentMap, component, target, result);
+}
+
+bool PathPlanner::findPath (const Query& query, Result& result)
+{
+    Scratch scratch;
+    findPath (query, result, scratch);
+    result.waypoints.swap (scratch.waypoints);
+    return result.found;
+}
+
+bool PathPlanner::findPaths (const Endpoints* endpoints, size_t count, const GridTransform& transform,
+                             const Query& options, Batch& batch)
+{
+    batch.clear();
+    batch.offsets.reserve (count + 1);
+    batch.found.reserve (count);
+
+    Scratch& scratch = _scratch[options.worker];
+    Query query = options;
+    Result result;
+    bool cancelled = false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        bool found = false;
+        if (!cancelled)
+        {
+            query.start = transform.toGrid (endpoints[i].from.x, endpoints[i].from.z);
+            query.goal = transform.toGrid (endpoints[i].to.x, endpoints[i].to.z);
+            found = findPath (query, result, scratch);
+            cancelled = result.cancelled;
+        }
+
+        if (found)
+        {
+            for (const PathPoint& point : scratch.waypoints)
+                batch.points.push_back (transform.toWorld (point.x, point.y));
+        }
+        batch.offsets.push_back ((uint32_t)batch.points.size());
+        batch.found.push_back (found);
+    }
+    return !cancelled;
+}
+
+void PathPlanner::occupiedCells (const GridTransform& transform, std::vector<Float3>& points) const
+{
+    points.clear();
+    for (int y = 0; y < _map.height(); y++)
+    {
+        const unsigned char* row = _map.row (y);
+        for (int x = 0; x < _map.width(); x++)
+        {
+            if (isBlocked (row[x]))
+                points.push_back (transform.toWorld ((float)x, (float)y));
+        }
+    }
+}
+
+void PathPlanner::componentCells (const GridTransform& transform, std::vector<Float3>& points) const
+{
+    points.clear();
+    for (int y = 0; y < _componentMap.height(); y++)
+    {
+        const uint32_t* row = _componentMap.row (y);
+        for (int x = 0; x < _componentMap.width(); x++)
+        {
+            if (row[x] != 0)
+                points.push_back (transform.toWorld ((float)x, (float)y, (float)row[x]));
+        }
+    }
+}
+
+bool PathPlanner::findPath (const Query& query, Result& result, Scratch& scratch)
+{
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    result.found = false;
+    result.cancelled = false;
+    result.cached = false;
+    result.cost = 0.f;
+    result.expanded = 0;
+    result.cells = 0;
+    result.builtAbstraction = false;
+    result.goal = query.goal;
+
+    std::vector<GridPoint>& path = scratch.path;
+    path.clear();
+    scratch.waypoints.clear();
+
+    if (!_map.inBounds (query.start.x, query.start.y))
+        return false;
+
+    PathCache::Key key;
+    key.start = query.start;
+    key.goal = query.goal;
+    key.algorithm = query.algorithm;
+    key.cornerRule = query.cornerRule;
+    key.closest = query.closest;
+    const bool useCache = _pathCache.capacity() > 0;
+
+    // Suffixes of a cached path are only shortest paths themselves if it was one.
+    const bool optimal = query.algorithm == AStarAlgorithm || query.algorithm == JumpPointAlgorithm
+        || query.algorithm == IncrementalAlgorithm || query.algorithm == BidirectionalAlgorithm;
+    if (useCache && _pathCache.find (key, optimal, path, result.cost, result.goal))
+    {
+        result.found = true;
+        result.cached = true;
+    }
+    else if (plan (query, result, path) && useCache)
+    {
+        _pathCache.insert (key, path, result.cost, result.goal, query.algorithm != AnyAngleAlgorithm);
+    }
+
+    if (result.found)
+    {
+        result.cells = path.size();
+        makeWaypoints (query, scratch);
+    }
+
+    if (useCache)
+        _pathCache.recordLatency (result.cached, std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count());
+    return result.found;
+}
+
+bool PathPlanner::plan (const Query& query, Result& result, std::vector<GridPoint>& path)
+{
+    if (!canPath (query.start, query.goal))
+    {
+        if (!query.closest || !nearestReachable (query.start, query.goal, result.goal))
+            return false;
+    }
+
+    const std::shared_ptr<const Landmarks> landmarks = this->landmarks();
+    AStar& planner = _planners[query.worker];
+    planner.setCornerRule (query.cornerRule);
+    JumpPointSearch& jumpPointPlanner = _jumpPointPlanners[query.worker];
+    const CancelFlag* cancel = query.cancel;
+
+    switch (query.algorithm)
+    {
+        case JumpPointAlgorithm:
+            result.found = jumpPointPlanner.findPath (_map, query.start, result.goal, path, cancel);
+            result.cost = jumpPointPlanner.pathCost();
+            result.expanded = jumpPointPlanner.stats().expanded;
+            break;
+
+        case HierarchicalAlgorithm:
+        {
+            bool cancelled = false;
+            {
+                std::lock_guard<std::mutex> lock (_hierarchicalMutex);
+                if (_hierarchicalPlannerStale)
+                {
+                    const std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+                    _hierarchicalPlanner.build (_map);
+                    _hierarchicalPlannerStale = false;
+                    _abstractionStats.nodes = _hierarchicalPlanner.nodeCount();
+                    _abstractionStats.edges = _hierarchicalPlanner.edgeCount();
+                    _abstractionStats.seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - buildStart).count();
+                    result.builtAbstraction = true;
+                }
+                result.found = _hierarchicalPlanner.findPath (query.start, result.goal, path, cancel);
+                result.cost = _hierarchicalPlanner.pathCost();
+                result.expanded = _hierarchicalPlanner.stats().expanded;
+                cancelled = _hierarchicalPlanner.stats().cancelled;
+            }
+            if (result.found || cancelled)
+                break;
+
+            // Routes squeezing diagonally past a cluster corner have no entrance, retry on the full grid.
+            result.found = planner.findPath (_map, query.start, result.goal, path, cancel, landmarks.get());
+            result.cost = planner.pathCost();
+            result.expanded += planner.stats().expanded;
+            break;
+        }
+
+        case IncrementalAlgorithm:
+        {
+            std::lock_guard<std::mutex> lock (_incrementalMutex);
+            // Keep the search tree while the goal stays put; map edits have already been fed in.
+            if (!_incrementalPlanner.isInitialized() || _incrementalPlanner.goal() != result.goal)
+                _incrementalPlanner.initialize (_map, query.start, result.goal);
+            else if (_incrementalPlanner.start() != query.start)
+                _incrementalPlanner.moveStart (query.start);
+            result.found = _incrementalPlanner.findPath (path, cancel);
+            result.cost = _incrementalPlanner.pathCost();
+            result.expanded = _incrementalPlanner.stats().expanded;
+            break;
+        }
+
+        case CoarseToFineAlgorithm:
+        {
+            CoarseToFinePlanner& coarseToFinePlanner = _coarseToFinePlanners[query.worker];
+            result.found = coarseToFinePlanner.findPath (_map, _pyramid, query.start, result.goal, path, cancel);
+            result.cost = coarseToFinePlanner.pathCost();
+            result.expanded = coarseToFinePlanner.stats().expanded;
+            break;
+        }
+
+        case AnyAngleAlgorithm:
+        {
+            LazyThetaStar& anyAnglePlanner = _anyAnglePlanners[query.worker];
+            result.found = anyAnglePlanner.findPath (_map, query.start, result.goal, path, cancel);
+            result.cost = anyAnglePlanner.pathCost();
+            result.expanded = anyAnglePlanner.stats().expanded;
+            break;
+        }
+
+        case BidirectionalAlgorithm:
+        {
+            BidirectionalAStar& bidirectionalPlanner = _bidirectionalPlanners[query.worker];
+            bidirectionalPlanner.setCornerRule (query.cornerRule);
+            result.found = bidirectionalPlanner.findPath (_map, query.start, result.goal, path, cancel);
+            result.cost = bidirectionalPlanner.pathCost();
+            result.expanded = bidirectionalPlanner.stats().expanded;
+            break;
+        }
+
+        case AStarAlgorithm:
+        default:
+            result.found = planner.findPath (_map, query.start, result.goal, path, cancel, landmarks.get());
+            result.cost = planner.pathCost();
+            result.expanded = planner.stats().expanded;
+            break;
+    }
+
+    if (cancel && cancel->load())
+    {
+        result.found = false;
+        result.cancelled = true;
+    }
+    return result.found;
+}
+
+void PathPlanner::makeWaypoints (const Query& query, Scratch& scratch) const
+{
+    const std::vector<GridPoint>& path = scratch.path;
+    std::vector<PathPoint>& points = scratch.waypoints;
+    std::vector<GridPoint>& corners = scratch.corners;
+    if (query.smoothing == NoSmoothing)
+    {
+        if (query.algorithm != AnyAngleAlgorithm)
+        {
+            simplifyPath (path, points);
+            return;
+        }
+        // Already near-taut, the vertices are the waypoints.
+        corners.assign (path.begin(), path.end());
+    }
+    else
+    {
+        pullString (_map, path, corners, scratch.pulled);
+    }
+
+    if (query.smoothing == SplineSmoothing)
+    {
+        smoothCatmullRom (_map, corners, (float)std::max (4, 2 * _robotRadius), points);
+    }
+    else
+    {
+        for (const GridPoint& corner : corners)
+            points.push_back (PathPoint{ (float)corner.x, (float)corner.y });
+    }
+
+    // Both start at the start cell.
+    if (points.size() > 1)
+        points.erase (points.begin());
+}
+
+void PathPlanner::simplifyPath (const std::vector<GridPoint>& path, std::vector<PathPoint>& waypoints) const
+{
+    waypoints.clear();
+    if (path.empty())
+        return;
+
+    const GridPoint goal = path.back();
+    float lastX = goal.x;
+    float lastY = goal.y;
+    float lastDx = NAN;
+    float lastDy = NAN;
+    float pointsSinceLastWp = 0;
+
+    waypoints.push_back (PathPoint{ (float)goal.x, (float)goal.y });
+
+    // Walk back from the goal, stopping short of the start cell.
+    for (size_t i = path.size() - 1; i > 0; i--)
+    {
+        const GridPoint current = path[i];
+        const float dx = lastX - current.x;
+        const float dy = lastY - current.y;
+
+        if (pointsSinceLastWp > _robotRadius / 2 && (lastDx != dx || lastDy != dy))
+        {
+            pointsSinceLastWp = 0;
+            lastDx = dx;
+            lastDy = dy;
+            waypoints.push_back (PathPoint{ (float)current.x, (float)current.y });
+        }
+
+        pointsSinceLastWp++;
+        lastX = current.x;
+        lastY = current.y;
+    }
+
+    std::reverse (waypoints.begin(), waypoints.end());
+}
+
+bool PathPlanner::setFlowFieldGoal (GridPoint goal, const CancelFlag* cancel)
+{
+    std::shared_ptr<const FlowField> current;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock (_flowFieldMutex);
+        current = _flowField;
+        generation = _flowFieldGeneration;
+    }
+
+    // Agents may still hold the current field, so the repair works on a copy.
+    std::shared_ptr<FlowField> next = std::make_shared<FlowField>();
+    bool repaired = false;
+    if (current)
+    {
+        *next = *current;
+        repaired = next->moveGoal (goal);
+    }
+    else
+    {
+        next->build (_map, _topoMap, goal);
+    }
+
+    // Checked under the lock: a newer goal raises the flag before its own job can publish,
+    // and a clear since the start bumps the generation.
+    std::lock_guard<std::mutex> lock (_flowFieldMutex);
+    if ((!cancel || !cancel->load()) && generation == _flowFieldGeneration)
+        _flowField = next;
+    return repaired;
+}
+
+std::shared_ptr<const FlowField> PathPlanner::flowField () const
+{
+    std::lock_guard<std::mutex> lock (_flowFieldMutex);
+    return _flowField;
+}
+
+void PathPlanner::clearFlowField ()
+{
+    std::lock_guard<std::mutex> lock (_flowFieldMutex);
+    _flowField.reset();
+    _flowFieldGeneration++;
+}
+
+PathPlanner::AbstractionStats PathPlanner::abstractionStats ()
+{
+    std::lock_guard<std::mutex> lock (_hierarchicalMutex);
+    return _abstractionStats;
+}
+
+void PathPlanner::rebuildFlowField ()
+{
+    std::shared_ptr<const FlowField> current;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock (_flowFieldMutex);
+        current = _flowField;
+        generation = _flowFieldGeneration;
+    }
+    if (!current)
+        return;
+
+    std::shared_ptr<FlowField> next = std::make_shared<FlowField>();
+    next->build (_map, _topoMap, current->goal());
+
+    std::lock_guard<std::mutex> lock (_flowFieldMutex);
+    if (generation == _flowFieldGeneration)
+        _flowField = next;
+}
+
+void PathPlanner::setLandmarkCount (int count)
+{
+    _landmarkCount = std::max (0, count);
+    dropLandmarks();
+}
+
+bool PathPlanner::updateLandmarks (const CancelFlag* cancel)
+{
+    if (_landmarkCount == 0 || !isLoaded() || landmarks())
+        return false;
+
+    std::shared_ptr<Landmarks> next = std::make_shared<Landmarks>();
+    if (!next->build (_map, _componentMap, _landmarkCount, cancel))
+        return false;
+
+    std::lock_guard<std::mutex> lock (_landmarksMutex);
+    _landmarks = next;
+    return true;
+}
+
+std::shared_ptr<const Landmarks> PathPlanner::landmarks () const
+{
+    std::lock_guard<std::mutex> lock (_landmarksMutex);
+    return _landmarks;
+}
+
+void PathPlanner::dropLandmarks ()
+{
+    std::lock_guard<std::mutex> lock (_landmarksMutex);
+    _landmarks.reset();
+}
+
+} // BE namespace
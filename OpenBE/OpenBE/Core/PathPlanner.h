@@ -0,0 +1,327 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AStar.h"
+#include "BidirectionalAStar.h"
+#include "CoarseToFinePlanner.h"
+#include "ConnectedComponents.h"
+#include "DStarLite.h"
+#include "FlowField.h"
+#include "Grid.h"
+#include "GridSearch.h"
+#include "HierarchicalPlanner.h"
+#include "JumpPointSearch.h"
+#include "Landmarks.h"
+#include "LazyThetaStar.h"
+#include "OccupancyCache.h"
+#include "OccupancyPyramid.h"
+#include "PathCache.h"
+#include "PathSmoothing.h"
+
+namespace BE {
+
+/**
+ * Platform-independent path planning over one occupancy map, in grid
+ * coordinates.
+ *
+ * Owns the raw occupancy grid, the layers derived from it (obstacles dilated
+ * by the robot radius, clearance cost, connected components, a min/max
+ * pyramid of the dilated map) and every
+ * planner searching them. PathFinding wraps it for Objective-C: it converts
+ * world coordinates, decodes images and schedules the calls on a PathService.
+ *
+ * Queries may run concurrently as long as each passes its own worker index,
+ * below workerCount(). Loading and editing the map must not overlap any query.
+ */
+class PathPlanner
+{
+public:
+    enum Algorithm
+    {
+        AStarAlgorithm = 0,
+        JumpPointAlgorithm,
+        HierarchicalAlgorithm,
+        IncrementalAlgorithm,
+        CoarseToFineAlgorithm,
+        AnyAngleAlgorithm,
+        BidirectionalAlgorithm
+    };
+
+    enum Smoothing
+    {
+        NoSmoothing = 0,
+        StringPullSmoothing,
+        SplineSmoothing
+    };
+
+    struct Query
+    {
+        GridPoint start = { 0, 0 };
+        GridPoint goal = { 0, 0 };
+        Algorithm algorithm = AStarAlgorithm;
+        Smoothing smoothing = NoSmoothing;
+        CornerRule cornerRule = CutCorners; // A* and bidirectional only; the other searches always cut corners
+        bool closest = false;   // head for the nearest reachable cell when the goal cannot be reached
+        size_t worker = 0;
+        const CancelFlag* cancel = nullptr;
+    };
+
+    struct Result
+    {
+        bool found = false;
+        bool cancelled = false;
+        bool cached = false;            // taken from the path cache instead of searched
+        GridPoint goal = { 0, 0 };      // goal actually planned to, see Query::closest
+        float cost = 0.f;
+        size_t expanded = 0;
+        size_t cells = 0;               // length of the grid path before simplification, vertices for AnyAngleAlgorithm
+        bool builtAbstraction = false;  // HierarchicalAlgorithm rebuilt the stale cluster abstraction first, see abstractionStats()
+        std::vector<PathPoint> waypoints;
+    };
+
+    /** Size of the HPA* cluster abstraction and how long its last build took. */
+    struct AbstractionStats
+    {
+        size_t nodes = 0;
+        size_t edges = 0;
+        double seconds = 0.0;
+    };
+
+    struct Endpoints
+    {
+        Float3 from;
+        Float3 to;
+    };
+
+    /**
+     * Waypoints of many paths in one contiguous buffer, in world coordinates
+     * with y = 0. Path i is points[offsets[i]] up to points[offsets[i + 1]].
+     * Keep one around and pass it to every findPaths() call: once its buffers
+     * have grown to fit, filling it again allocates nothing.
+     */
+    struct Batch
+    {
+        std::vector<Float3> points;
+        std::vector<uint32_t> offsets;  // size() + 1 entries, starting at 0
+        std::vector<uint8_t> found;     // per path; a path that was not found has no points
+
+        size_t size () const { return found.size(); }
+        const Float3* path (size_t i) const { return points.data() + offsets[i]; }
+        size_t pathSize (size_t i) const { return offsets[i + 1] - offsets[i]; }
+
+        void clear ()
+        {
+            points.clear();
+            offsets.assign (1, 0);
+            found.clear();
+        }
+    };
+
+    explicit PathPlanner (size_t workerCount = 1);
+
+    /** Number of queries that may run at once; resizes the per-worker search state. */
+    void setWorkerCount (size_t workerCount);
+    size_t workerCount () const { return _planners.size(); }
+
+    /**
+     * Take a raw occupancy map (255 = obstacle, border 0) and derive every layer
+     * for robots of the given radius in cells.
+     */
+    void load (const Grid<unsigned char>& raw, int robotRadius);
+
+    /** Take the raw map and its derived layers from an open cache instead. */
+    bool load (const OccupancyCache& cache);
+
+    /** Write the current layers to a cache; info supplies the map geometry. */
+    bool save (const char* path, uint64_t sourceHash, OccupancyCache::Info info) const;
+
+    bool isLoaded () const { return !_map.empty(); }
+
+    int width () const { return _map.width(); }
+    int height () const { return _map.height(); }
+    int robotRadius () const { return _robotRadius; }
+
+    const Grid<unsigned char>& rawMap () const { return _rawMap; }
+    const Grid<unsigned char>& map () const { return _map; }
+    const Grid<unsigned char>& topoMap () const { return _topoMap; }
+    const Grid<uint32_t>& componentMap () const { return _componentMap; }
+    const OccupancyPyramid& pyramid () const { return _pyramid; }
+
+    /** Dilate the raw map again for another robot radius. */
+    void setRobotRadius (int robotRadius);
+
+    /**
+     * Mark the raw cells within radius of (cx, cy) occupied or free and repair
+     * every layer and planner around them.
+     */
+    void setOccupied (int cx, int cy, float radius, bool occupied);
+
+    /** True for blocked cells and anywhere off the map. */
+    bool isOccupied (int x, int y) const
+    {
+        return !_map.inBounds (x, y) || isBlocked (_map(x, y));
+    }
+
+    /** True if start and goal lie in the same free region. */
+    bool canPath (GridPoint start, GridPoint goal) const;
+
+    /** Label of the largest free region, or 0 if there is none. */
+    uint32_t largestComponent () const { return _relabeller.largestComponent(); }
+
+    /** Closest cell of component to target. */
+    bool nearestInComponent (uint32_t component, GridPoint target, GridPoint& result);
+
+    /** Closest cell to target that can be reached from source. */
+    bool nearestReachable (GridPoint source, GridPoint target, GridPoint& result);
+
+    /**
+     * Plan a path and reduce it to waypoints in grid coordinates. The start is
+     * not a waypoint unless it is also the goal. Returns result.found.
+     */
+    bool findPath (const Query& query, Result& result);
+
+    /**
+     * Plan a path between each pair of world points and pack the waypoints
+     * into batch, replacing its contents. options supplies everything but the
+     * start and goal. Search and smoothing run in per-worker scratch buffers,
+     * so with flat searches (A*, Jump Point) and a warm batch nothing is
+     * allocated per path or per point, short of a path cache entry growing to
+     * hold a longer path. Returns false if options.cancel was
+     * raised; paths not planned by then are left empty.
+     */
+    bool findPaths (const Endpoints* endpoints, size_t count, const GridTransform& transform, const Query& options,
+                    Batch& batch);
+
+    /** World positions of every blocked cell, with y = 0. */
+    void occupiedCells (const GridTransform& transform, std::vector<Float3>& points) const;
+
+    /** World positions of every free cell, with its component label as y. */
+    void componentCells (const GridTransform& transform, std::vector<Float3>& points) const;
+
+    /**
+     * Point the shared flow field at goal, repairing the current field when it
+     * only moved a little. Returns true if it was repaired. The new field is
+     * not published if cancel is raised by the time it is ready, so a goal
+     * that was superseded meanwhile cannot replace the newer one, nor if
+     * clearFlowField() ran meanwhile.
+     */
+    bool setFlowFieldGoal (GridPoint goal, const CancelFlag* cancel = nullptr);
+
+    /**
+     * Landmarks per connected component for the A* heuristic; 0 (the default)
+     * turns them off. The tables are built by updateLandmarks().
+     */
+    void setLandmarkCount (int count);
+    int landmarkCount () const { return _landmarkCount; }
+
+    /**
+     * Build the landmark tables if they are enabled and missing, e.g. after a
+     * map edit dropped them. Only reads the map, so it may run alongside
+     * queries, which use the octile heuristic alone until it finishes. Returns
+     * true if tables were built.
+     */
+    bool updateLandmarks (const CancelFlag* cancel = nullptr);
+
+    /** Current landmark tables, or null. */
+    std::shared_ptr<const Landmarks> landmarks () const;
+
+    /** Current flow field, or null. Published fields never change, so no lock is needed to sample them. */
+    std::shared_ptr<const FlowField> flowField () const;
+
+    /** Drop the flow field; fields still being built when it is called are never published. */
+    void clearFlowField ();
+
+    /**
+     * The HPA* abstraction is built by the first HierarchicalAlgorithm query
+     * after a load or an edit, so maps that never use it do not pay for it.
+     */
+    AbstractionStats abstractionStats ();
+
+    /**
+     * Recently planned paths, consulted by findPath() and findPaths() before
+     * searching; see PathCache. On by default with PathCache::kDefaultCapacity
+     * entries, off with a capacity of 0. Map changes invalidate what they affect.
+     */
+    PathCache& pathCache () { return _pathCache; }
+    const PathCache& pathCache () const { return _pathCache; }
+
+private:
+    /** Search buffers reused by one worker's batches. */
+    struct Scratch
+    {
+        std::vector<GridPoint> path;
+        std::vector<GridPoint> corners;
+        std::vector<GridPoint> pulled;      // first string pulling pass
+        std::vector<PathPoint> waypoints;
+    };
+
+    /** findPath() into scratch: leaves the waypoints in scratch.waypoints and result.waypoints untouched. */
+    bool findPath (const Query& query, Result& result, Scratch& scratch);
+
+    /** Search for the cell path of query into path, filling result but for its waypoints. */
+    bool plan (const Query& query, Result& result, std::vector<GridPoint>& path);
+
+    /** Reduce scratch.path to scratch.waypoints as query.smoothing asks. */
+    void makeWaypoints (const Query& query, Scratch& scratch) const;
+
+    /** Dilate, build the clearance cost and label components over the whole map. */
+    void buildLayers ();
+
+    /** Reset everything that depends on the layers after they were replaced. */
+    void layersChanged ();
+
+    void rebuildFlowField ();
+
+    void dropLandmarks ();
+
+    /** The original waypoint thinning: keep a cell wherever the direction changes, at most every radius / 2 cells. */
+    void simplifyPath (const std::vector<GridPoint>& path, std::vector<PathPoint>& waypoints) const;
+
+    Grid<unsigned char> _rawMap;
+    Grid<unsigned char> _map;
+    Grid<unsigned char> _topoMap;
+    Grid<uint32_t> _componentMap;
+    OccupancyPyramid _pyramid;
+    int _robotRadius = 0;
+
+    ComponentRelabeller _relabeller;
+    NearestComponentCells _nearestCells;
+
+    // Flat searches get one planner per worker; the others share one search state each.
+    std::vector<AStar> _planners;
+    std::vector<JumpPointSearch> _jumpPointPlanners;
+    std::vector<CoarseToFinePlanner> _coarseToFinePlanners;
+    std::vector<LazyThetaStar> _anyAnglePlanners;
+    std::vector<BidirectionalAStar> _bidirectionalPlanners;
+    std::vector<Scratch> _scratch;
+    HierarchicalPlanner _hierarchicalPlanner;
+    DStarLite _incrementalPlanner;
+    bool _hierarchicalPlannerStale = true;  // map changed since the cluster abstraction was built
+    AbstractionStats _abstractionStats;
+    std::mutex _hierarchicalMutex;
+    std::mutex _incrementalMutex;
+
+    std::shared_ptr<const FlowField> _flowField;
+    uint64_t _flowFieldGeneration = 0;     // bumped by clearFlowField(), under _flowFieldMutex
+    mutable std::mutex _flowFieldMutex;
+
+    PathCache _pathCache;
+
+    int _landmarkCount = 0;
+    std::shared_ptr<const Landmarks> _landmarks;
+    mutable std::mutex _landmarksMutex;
+};
+
+} // BE namespace
@@ -0,0 +1,179 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "PathService.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace BE {
+
+struct PathService::State
+{
+    struct Entry
+    {
+        uint64_t agent;
+        Job job;
+        std::function<void ()> exclusive;  // set instead of job for exclusive entries
+        std::shared_ptr<Ticket> ticket;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake;  // a job may have become runnable
+    std::condition_variable idle;  // the queue drained
+    std::deque<Entry> queue;
+    std::vector<std::shared_ptr<Ticket>> running;  // per worker
+    std::unordered_map<uint64_t, std::shared_ptr<Ticket>> latest;  // newest job of each agent
+    size_t active = 0;
+    bool exclusiveActive = false;
+    bool stopping = false;
+
+    bool runnable () const
+    {
+        if (queue.empty() || exclusiveActive)
+            return false;
+        return queue.front().ticket || active == 0;
+    }
+};
+
+PathService::PathService (unsigned threads)
+    : _state (std::make_shared<State>())
+{
+    if (threads == 0)
+        threads = std::max (1u, std::thread::hardware_concurrency());
+
+    _state->running.resize (threads);
+    for (unsigned i = 0; i < threads; i++)
+        _threads.emplace_back (work, _state, (size_t)i);
+}
+
+PathService::~PathService ()
+{
+    {
+        std::lock_guard<std::mutex> lock (_state->mutex);
+        _state->stopping = true;
+        for (State::Entry& entry : _state->queue)
+        {
+            if (entry.ticket)
+                entry.ticket->cancel();
+        }
+        for (const std::shared_ptr<Ticket>& ticket : _state->running)
+        {
+            if (ticket)
+                ticket->cancel();
+        }
+    }
+    _state->wake.notify_all();
+
+    // The service may be released by one of its own jobs; that worker just exits on its own.
+    for (std::thread& thread : _threads)
+    {
+        if (thread.get_id() == std::this_thread::get_id())
+            thread.detach();
+        else
+            thread.join();
+    }
+}
+
+std::shared_ptr<PathService::Ticket> PathService::submit (uint64_t agent, Job job)
+{
+    std::shared_ptr<Ticket> ticket = std::make_shared<Ticket>();
+    {
+        std::lock_guard<std::mutex> lock (_state->mutex);
+        if (_state->stopping)
+            ticket->cancel();
+
+        if (agent != kNoAgent)
+        {
+            std::shared_ptr<Ticket>& latest = _state->latest[agent];
+            if (latest)
+                latest->cancel();
+            latest = ticket;
+        }
+        _state->queue.push_back (State::Entry{ agent, std::move (job), nullptr, ticket });
+    }
+    _state->wake.notify_one();
+    return ticket;
+}
+
+void PathService::submitExclusive (std::function<void ()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock (_state->mutex);
+        _state->queue.push_back (State::Entry{ kNoAgent, nullptr, std::move (job), nullptr });
+    }
+    _state->wake.notify_one();
+}
+
+void PathService::cancelAll ()
+{
+    std::lock_guard<std::mutex> lock (_state->mutex);
+    for (State::Entry& entry : _state->queue)
+    {
+        if (entry.ticket)
+            entry.ticket->cancel();
+    }
+    for (const std::shared_ptr<Ticket>& ticket : _state->running)
+    {
+        if (ticket)
+            ticket->cancel();
+    }
+}
+
+void PathService::waitIdle ()
+{
+    std::unique_lock<std::mutex> lock (_state->mutex);
+    _state->idle.wait (lock, [this] { return _state->queue.empty() && _state->active == 0; });
+}
+
+void PathService::work (std::shared_ptr<State> state, size_t worker)
+{
+    std::unique_lock<std::mutex> lock (state->mutex);
+    for (;;)
+    {
+        state->wake.wait (lock, [&state] { return state->runnable() || (state->stopping && state->queue.empty()); });
+        if (state->queue.empty())
+            return;
+
+        State::Entry entry = std::move (state->queue.front());
+        state->queue.pop_front();
+        state->active++;
+
+        if (entry.ticket)
+        {
+            state->running[worker] = entry.ticket;
+            lock.unlock();
+            entry.job (worker, entry.ticket->_cancelled);
+            entry.job = nullptr;  // release captures outside the lock
+            lock.lock();
+            state->running[worker].reset();
+
+            auto latest = state->latest.find (entry.agent);
+            if (latest != state->latest.end() && latest->second == entry.ticket)
+                state->latest.erase (latest);
+        }
+        else
+        {
+            state->exclusiveActive = true;
+            lock.unlock();
+            entry.exclusive();
+            entry.exclusive = nullptr;
+            lock.lock();
+            state->exclusiveActive = false;
+        }
+
+        state->active--;
+        if (state->queue.empty() && state->active == 0)
+            state->idle.notify_all();
+        state->wake.notify_all();
+    }
+}
+
+} // BE namespace
@@ -0,0 +1,90 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "GridSearch.h"
+
+namespace BE {
+
+/**
+ * Pool of worker threads answering path requests concurrently.
+ *
+ * Jobs run in submission order, several at a time. Each one is told which
+ * worker runs it, so callers can keep one planner instance per worker, and
+ * gets a CancelFlag to hand to the search.
+ *
+ * Requests from the same agent are coalesced: submitting a new one cancels
+ * whatever that agent still has queued or running, so a character retargeting
+ * every frame costs one search rather than a backlog of stale ones. Cancelled
+ * jobs still run (with their flag raised and nothing to search) so their
+ * completion handlers always fire.
+ *
+ * Exclusive jobs, meant for map edits, wait until every job submitted before
+ * them has finished and hold back every job submitted after them.
+ */
+class PathService
+{
+public:
+    typedef std::function<void (size_t worker, const CancelFlag& cancelled)> Job;
+
+    /** Handle to a submitted job. */
+    class Ticket
+    {
+    public:
+        void cancel () { _cancelled.store (true, std::memory_order_relaxed); }
+        bool isCancelled () const { return _cancelled.load (std::memory_order_relaxed); }
+
+    private:
+        friend class PathService;
+        CancelFlag _cancelled { false };
+    };
+
+    /** No agent: the job is never coalesced with others. */
+    static const uint64_t kNoAgent = 0;
+
+    /** Start `threads` workers, 0 picks one per core. */
+    explicit PathService (unsigned threads = 0);
+
+    /** Cancels everything still pending, lets it drain, then stops the workers. */
+    ~PathService ();
+
+    PathService (const PathService&) = delete;
+    PathService& operator= (const PathService&) = delete;
+
+    size_t threadCount () const { return _threads.size(); }
+
+    /** Queue a search job, cancelling any earlier job of the same agent. */
+    std::shared_ptr<Ticket> submit (uint64_t agent, Job job);
+
+    /** Queue a job that runs alone, in order with every other job. */
+    void submitExclusive (std::function<void ()> job);
+
+    /** Cancel every queued and running job. */
+    void cancelAll ();
+
+    /** Block until no job is queued or running. Must not be called from a job. */
+    void waitIdle ();
+
+private:
+    struct State;
+
+    static void work (std::shared_ptr<State> state, size_t worker);
+
+    // Shared with the workers so one of them may drop the last reference to the service.
+    std::shared_ptr<State> _state;
+    std::vector<std::thread> _threads;
+};
+
+} // BE namespace
@@ -0,0 +1,183 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "PathSmoothing.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace BE {
+
+namespace {
+
+    inline PathPoint toPoint (GridPoint p) { return PathPoint{ (float)p.x, (float)p.y }; }
+
+    inline GridPoint toCell (PathPoint p) { return GridPoint{ (int)lroundf (p.x), (int)lroundf (p.y) }; }
+
+    inline PathPoint lerp (PathPoint a, PathPoint b, float ta, float tb, float t)
+    {
+        const float u = (t - ta) / (tb - ta);
+        return PathPoint{ a.x + (b.x - a.x) * u, a.y + (b.y - a.y) * u };
+    }
+
+    /** Parameter step of the centripetal parameterization: sqrt of the chord length. */
+    inline float knotStep (PathPoint a, PathPoint b)
+    {
+        return sqrtf (sqrtf ((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y)));
+    }
+
+    /** One greedy pass: keep the vertex before each one the last kept vertex cannot see. */
+    void pullPass (const Grid<unsigned char>& map, const std::vector<GridPoint>& path, std::vector<GridPoint>& result)
+    {
+        result.clear();
+        if (path.empty())
+            return;
+
+        result.push_back (path.front());
+        size_t anchor = 0;
+        for (size_t i = 2; i < path.size(); i++)
+        {
+            // Neighbouring vertices are always connected, even diagonally between two obstacles.
+            if (!lineOfSight (map, path[anchor], path[i]))
+            {
+                anchor = i - 1;
+                result.push_back (path[anchor]);
+            }
+        }
+        if (path.size() > 1)
+            result.push_back (path.back());
+    }
+
+} // anonymous
+
+bool lineOfSight (const Grid<unsigned char>& map, GridPoint a, GridPoint b)
+{
+    auto blocked = [&map](int x, int y) { return isBlocked (map(x, y)); };
+
+    const int dx = abs(b.x - a.x);
+    const int dy = abs(b.y - a.y);
+    const int sx = b.x > a.x ? 1 : -1;
+    const int sy = b.y > a.y ? 1 : -1;
+
+    // error tracks which cell border the segment crosses next, scaled by 2 dx dy.
+    int x = a.x, y = a.y;
+    int error = dx - dy;
+    int remaining = dx + dy;
+    if (blocked (x, y))
+        return false;
+
+    while (remaining > 0)
+    {
+        if (error > 0)
+        {
+            x += sx;
+            error -= 2 * dy;
+            remaining--;
+        }
+        else if (error < 0)
+        {
+            y += sy;
+            error += 2 * dx;
+            remaining--;
+        }
+        else
+        {
+            // Exactly through a corner: it may graze one obstacle (the map is already dilated) but not squeeze between two.
+            if (blocked (x + sx, y) && blocked (x, y + sy))
+                return false;
+            x += sx;
+            y += sy;
+            error += 2 * (dx - dy);
+            remaining -= 2;
+        }
+
+        if (blocked (x, y))
+            return false;
+    }
+    return true;
+}
+
+void pullString (const Grid<unsigned char>& map, const std::vector<GridPoint>& path, std::vector<GridPoint>& result)
+{
+    // The first pass keeps a vertex wherever a staircase step breaks the view; pulling
+    // the kept vertices once more drops most of those (about 20% fewer on cluttered maps).
+    std::vector<GridPoint> corners;
+    pullString (map, path, result, corners);
+}
+
+void pullString (const Grid<unsigned char>& map, const std::vector<GridPoint>& path, std::vector<GridPoint>& result,
+                 std::vector<GridPoint>& scratch)
+{
+    pullPass (map, path, scratch);
+    pullPass (map, scratch, result);
+}
+
+void smoothCatmullRom (const Grid<unsigned char>& map, const std::vector<GridPoint>& corners, float spacing,
+                       std::vector<PathPoint>& result)
+{
+    result.clear();
+    if (corners.empty())
+        return;
+
+    result.push_back (toPoint (corners.front()));
+    if (corners.size() < 2)
+        return;
+
+    spacing = std::max (spacing, 0.5f);
+    const size_t last = corners.size() - 1;
+
+    for (size_t i = 0; i < last; i++)
+    {
+        const PathPoint p1 = toPoint (corners[i]);
+        const PathPoint p2 = toPoint (corners[i + 1]);
+
+        // Mirror the neighbours at both ends so the curve leaves and arrives straight.
+        const PathPoint p0 = i > 0 ? toPoint (corners[i - 1]) : PathPoint{ 2.f * p1.x - p2.x, 2.f * p1.y - p2.y };
+        const PathPoint p3 = i + 1 < last ? toPoint (corners[i + 2]) : PathPoint{ 2.f * p2.x - p1.x, 2.f * p2.y - p1.y };
+
+        const float t0 = 0.f;
+        const float t1 = t0 + knotStep (p0, p1);
+        const float t2 = t1 + knotStep (p1, p2);
+        const float t3 = t2 + knotStep (p2, p3);
+
+        const float length = sqrtf ((p2.x - p1.x) * (p2.x - p1.x) + (p2.y - p1.y) * (p2.y - p1.y));
+        const int samples = std::max (1, (int)ceilf (length / spacing));
+
+        // Barry-Goldman pyramid evaluation at each sample, appended as we go and taken back if the span is not clear.
+        const size_t spanStart = result.size();
+        bool clear = true;
+        GridPoint previous = corners[i];
+        for (int s = 1; s <= samples && clear; s++)
+        {
+            PathPoint point = p2;
+            if (s < samples)
+            {
+                const float t = t1 + (t2 - t1) * s / samples;
+                const PathPoint a1 = lerp (p0, p1, t0, t1, t);
+                const PathPoint a2 = lerp (p1, p2, t1, t2, t);
+                const PathPoint a3 = lerp (p2, p3, t2, t3, t);
+                const PathPoint b1 = lerp (a1, a2, t0, t2, t);
+                const PathPoint b2 = lerp (a2, a3, t1, t3, t);
+                point = lerp (b1, b2, t1, t2, t);
+            }
+
+            const GridPoint cell = toCell (point);
+            clear = map.inBounds (cell.x, cell.y) && lineOfSight (map, previous, cell);
+            previous = cell;
+            result.push_back (point);
+        }
+
+        // Corners of a pulled string see each other, so the straight span is always safe.
+        if (!clear)
+        {
+            result.resize (spanStart);
+            result.push_back (p2);
+        }
+    }
+}
+
+} // BE namespace
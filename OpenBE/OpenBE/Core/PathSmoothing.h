@@ -0,0 +1,59 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "Grid.h"
+#include "GridSearch.h"
+
+namespace BE {
+
+/**
+ * Post-processing of grid paths into fewer, straighter waypoints.
+ */
+
+/**
+ * Point in continuous grid coordinates; cell (x, y) is centred on (x, y).
+ */
+struct PathPoint
+{
+    float x, y;
+};
+
+/**
+ * True if the segment between the centres of cells a and b only crosses free
+ * cells. Supercover traversal: every cell the segment passes through is
+ * tested. Where it passes exactly through a cell corner, one of the two cells
+ * beside it may be blocked but not both.
+ */
+bool lineOfSight (const Grid<unsigned char>& map, GridPoint a, GridPoint b);
+
+/**
+ * String pulling: keep only the cells of path where the line of sight from
+ * the previous kept cell breaks, plus both ends, then pull the kept cells once
+ * more. Consecutive result cells can see each other, so the result is a valid
+ * polyline through free space with far fewer vertices than an 8-connected
+ * staircase. Runs in O(path length x segment length).
+ */
+void pullString (const Grid<unsigned char>& map, const std::vector<GridPoint>& path, std::vector<GridPoint>& result);
+
+/** Same as above, keeping the first pass in scratch so a caller reusing it allocates nothing. */
+void pullString (const Grid<unsigned char>& map, const std::vector<GridPoint>& path, std::vector<GridPoint>& result,
+                 std::vector<GridPoint>& scratch);
+
+/**
+ * Centripetal Catmull-Rom spline through corners (e.g. a pulled string),
+ * resampled every `spacing` cells. The curve bulges around corners, so spans
+ * that would clip an obstacle are kept straight. The result starts at the first
+ * corner and ends exactly at the last.
+ */
+void smoothCatmullRom (const Grid<unsigned char>& map, const std::vector<GridPoint>& corners, float spacing,
+                       std::vector<PathPoint>& result);
+
+} // BE namespace
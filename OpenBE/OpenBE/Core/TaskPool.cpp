@@ -0,0 +1,129 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "TaskPool.h"
+
+#include <algorithm>
+
+namespace BE {
+
+namespace {
+
+    // Pool and index of the worker running on this thread, if any.
+    thread_local const TaskPool* tPool = nullptr;
+    thread_local size_t tWorker = 0;
+
+} // anonymous
+
+TaskPool::TaskPool (unsigned threads)
+{
+    if (threads == 0)
+        threads = std::max (1u, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i <= threads; i++)
+        _queues.emplace_back (new Queue());
+    for (unsigned i = 0; i < threads; i++)
+        _threads.emplace_back (&TaskPool::work, this, (size_t)i);
+}
+
+TaskPool::~TaskPool ()
+{
+    {
+        std::lock_guard<std::mutex> lock (_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (std::thread& thread : _threads)
+        thread.join();
+}
+
+void TaskPool::submit (Task task)
+{
+    // Counted before it is queued, so an idle worker never sleeps through it.
+    {
+        std::lock_guard<std::mutex> lock (_mutex);
+        _queued++;
+        _pending++;
+    }
+
+    Queue& queue = tPool == this ? *_queues[tWorker] : *_queues.back();
+    {
+        std::lock_guard<std::mutex> lock (queue.mutex);
+        queue.tasks.push_back (std::move (task));
+    }
+    _wake.notify_one();
+}
+
+void TaskPool::waitIdle ()
+{
+    std::unique_lock<std::mutex> lock (_mutex);
+    _idle.wait (lock, [this] { return _pending == 0; });
+}
+
+bool TaskPool::take (size_t worker, Task& task)
+{
+    {
+        Queue& own = *_queues[worker];
+        std::lock_guard<std::mutex> lock (own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move (own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // The shared queue first, then the other workers starting after this one.
+    const size_t workers = _queues.size() - 1;
+    for (size_t i = 0; i < workers; i++)
+    {
+        Queue& other = *_queues[i == 0 ? workers : (worker + i) % workers];
+        std::lock_guard<std::mutex> lock (other.mutex);
+        if (!other.tasks.empty())
+        {
+            task = std::move (other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskPool::work (size_t worker)
+{
+    tPool = this;
+    tWorker = worker;
+
+    for (;;)
+    {
+        Task task;
+        if (take (worker, task))
+        {
+            {
+                std::lock_guard<std::mutex> lock (_mutex);
+                _queued--;
+            }
+            task();
+            task = nullptr;     // release captures before counting the task done
+
+            std::lock_guard<std::mutex> lock (_mutex);
+            if (--_pending == 0)
+                _idle.notify_all();
+            continue;
+        }
+
+        // Nothing found: either everything is taken, or a counted task is still being queued.
+        std::unique_lock<std::mutex> lock (_mutex);
+        if (_queued > 0)
+            continue;
+        if (_stopping)
+            return;
+        _wake.wait (lock, [this] { return _queued > 0 || _stopping; });
+    }
+}
+
+} // BE namespace
@@ -0,0 +1,78 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BE {
+
+/**
+ * Work-stealing pool of threads for fine-grained tasks, such as the tiles of
+ * a map build.
+ *
+ * Every worker keeps its own queue. Tasks a worker submits go on its own
+ * queue and are taken back newest first, so follow-up work runs where its
+ * input is still in cache. Tasks from other threads go on a shared queue
+ * served oldest first, so they start in submission order. An idle worker
+ * takes from the shared queue, then steals the oldest task of another.
+ *
+ * Unlike PathService there is no cancellation or coalescing; tasks are
+ * expected to check their own flags.
+ */
+class TaskPool
+{
+public:
+    typedef std::function<void ()> Task;
+
+    /** Start `threads` workers, 0 picks one per core. */
+    explicit TaskPool (unsigned threads = 0);
+
+    /** Runs everything still queued, then stops the workers. */
+    ~TaskPool ();
+
+    TaskPool (const TaskPool&) = delete;
+    TaskPool& operator= (const TaskPool&) = delete;
+
+    size_t threadCount () const { return _threads.size(); }
+
+    void submit (Task task);
+
+    /** Block until no task is queued or running. Must not be called from a task. */
+    void waitIdle ();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void work (size_t worker);
+
+    /** Next task for worker: its own newest, the shared oldest, else another's oldest. */
+    bool take (size_t worker, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> _queues;    // one per worker, then the shared one
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;                  // a task was queued
+    std::condition_variable _idle;                  // nothing queued or running
+    size_t _queued = 0;
+    size_t _pending = 0;                            // queued or running
+    bool _stopping = false;
+};
+
+} // BE namespace
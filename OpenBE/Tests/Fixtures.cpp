@@ -0,0 +1,195 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include "Fixtures.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <random>
+
+#include <dirent.h>
+
+namespace BE {
+namespace Fixtures {
+
+namespace {
+
+    /** Next whitespace separated field of a PGM header, skipping # comments. */
+    bool readHeaderField (FILE* file, int& value)
+    {
+        int c = fgetc (file);
+        for (;;)
+        {
+            while (c != EOF && isspace (c))
+                c = fgetc (file);
+            if (c != '#')
+                break;
+            while (c != EOF && c != '\n')
+                c = fgetc (file);
+        }
+        if (c == EOF || !isdigit (c))
+            return false;
+
+        value = 0;
+        while (c != EOF && isdigit (c))
+        {
+            value = value * 10 + (c - '0');
+            c = fgetc (file);
+        }
+        // The single whitespace after the last field is consumed here too.
+        return c != EOF && isspace (c);
+    }
+
+    bool endsWith (const std::string& s, const char* suffix)
+    {
+        const std::string end (suffix);
+        return s.size() >= end.size() && s.compare (s.size() - end.size(), end.size(), end) == 0;
+    }
+
+} // anonymous
+
+bool readOccupancyMap (const std::string& path, Grid<unsigned char>& raw)
+{
+    FILE* file = fopen (path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    int width = 0, height = 0, maxValue = 0;
+    bool ok = fgetc (file) == 'P' && fgetc (file) == '5'
+        && readHeaderField (file, width) && readHeaderField (file, height) && readHeaderField (file, maxValue)
+        && width > 0 && height > 0 && maxValue == 255;
+    if (ok)
+    {
+        raw.resize (width, height, 0, 0);
+        for (int y = 0; y < height && ok; y++)
+            ok = fread (raw.row (y), 1, (size_t)width, file) == (size_t)width;
+    }
+    fclose (file);
+    return ok;
+}
+
+const std::vector<CorpusMap>& mapCorpus ()
+{
+    static const std::vector<CorpusMap> corpus = []
+    {
+        std::vector<CorpusMap> maps;
+        const std::string directory = OPENBE_MAP_DIRECTORY;
+        if (DIR* dir = opendir (directory.c_str()))
+        {
+            while (dirent* entry = readdir (dir))
+            {
+                const std::string file = entry->d_name;
+                if (!endsWith (file, ".pgm"))
+                    continue;
+                CorpusMap map;
+                map.name = file.substr (0, file.size() - 4);
+                if (readOccupancyMap (directory + "/" + file, map.raw))
+                    maps.push_back (std::move (map));
+            }
+            closedir (dir);
+        }
+        std::sort (maps.begin(), maps.end(), [](const CorpusMap& a, const CorpusMap& b) { return a.name < b.name; });
+        return maps;
+    }();
+    return corpus;
+}
+
+const CorpusMap* corpusMap (const std::string& name)
+{
+    for (const CorpusMap& map : mapCorpus())
+    {
+        if (map.name == name)
+            return &map;
+    }
+    return nullptr;
+}
+
+void clutteredMap (int width, int height, unsigned seed, Grid<unsigned char>& raw)
+{
+    std::mt19937 rng (seed);
+    raw.resize (width, height, 0, 0);
+
+    // Boxes of 2 to 31 cells a side, as many as it takes to cover about a fifth of the floor.
+    const size_t boxes = (size_t)width * height / 1300;
+    for (size_t i = 0; i < boxes; i++)
+    {
+        const int x0 = (int)(rng() % (unsigned)width);
+        const int y0 = (int)(rng() % (unsigned)height);
+        const int x1 = std::min (width, x0 + 2 + (int)(rng() % 30));
+        const int y1 = std::min (height, y0 + 2 + (int)(rng() % 30));
+        for (int y = y0; y < y1; y++)
+            std::fill (raw.row (y) + x0, raw.row (y) + x1, (unsigned char)255);
+    }
+}
+
+std::vector<std::pair<GridPoint, GridPoint>> endpointPairs (const PathPlanner& planner, size_t count, unsigned seed)
+{
+    std::mt19937 rng (seed);
+    std::vector<std::pair<GridPoint, GridPoint>> pairs;
+    if (planner.largestComponent() == 0)
+        return pairs;
+
+    // Tries are bounded, so a map with little free space gives fewer pairs rather than hanging.
+    const size_t tries = count * 1000;
+    for (size_t i = 0; i < tries && pairs.size() < count; i++)
+    {
+        const GridPoint start = { (int)(rng() % (unsigned)planner.width()), (int)(rng() % (unsigned)planner.height()) };
+        const GridPoint goal = { (int)(rng() % (unsigned)planner.width()), (int)(rng() % (unsigned)planner.height()) };
+        if (!planner.isOccupied (start.x, start.y) && !planner.isOccupied (goal.x, goal.y) && planner.canPath (start, goal))
+            pairs.emplace_back (start, goal);
+    }
+    return pairs;
+}
+
+std::vector<Float3> Mesh::triangles () const
+{
+    std::vector<Float3> soup;
+    soup.reserve (faces.size());
+    for (uint16_t face : faces)
+        soup.push_back (vertices[face]);
+    return soup;
+}
+
+Mesh roomMesh (unsigned seed, int boxes, int debris)
+{
+    std::mt19937 rng (seed);
+    std::uniform_real_distribution<float> unit (0.f, 1.f);
+    Mesh mesh;
+
+    // Counter-clockwise seen from the front, as SceneKit culls.
+    auto quad = [&mesh](Float3 a, Float3 b, Float3 c, Float3 d)
+    {
+        const uint16_t first = (uint16_t)mesh.vertices.size();
+        mesh.vertices.insert (mesh.vertices.end(), { a, b, c, d });
+        const uint16_t faces[6] = { first, (uint16_t)(first + 1), (uint16_t)(first + 2),
+                                    first, (uint16_t)(first + 2), (uint16_t)(first + 3) };
+        mesh.faces.insert (mesh.faces.end(), faces, faces + 6);
+    };
+
+    quad ({ -3.f, 0.f, -3.f }, { -3.f, 0.f, 3.f }, { 3.f, 0.f, 3.f }, { 3.f, 0.f, -3.f });
+    for (int i = 0; i < boxes; i++)
+    {
+        const float x = unit (rng) * 5.f - 3.f, z = unit (rng) * 5.f - 3.f;
+        const float size = 0.1f + unit (rng) * 0.6f, top = 0.05f + unit (rng) * 1.5f;
+        quad ({ x, top, z }, { x, top, z + size }, { x + size, top, z + size }, { x + size, top, z });
+        quad ({ x, 0.f, z }, { x, top, z }, { x + size, top, z }, { x + size, 0.f, z });
+    }
+    for (int i = 0; i < debris; i++)
+    {
+        const Float3 a = { unit (rng) * 6.f - 3.f, unit (rng) * 2.f, unit (rng) * 6.f - 3.f };
+        const Float3 b = { a.x + unit (rng) * 0.6f - 0.3f, unit (rng) * 2.f, a.z + unit (rng) * 0.6f - 0.3f };
+        const Float3 c = { a.x + unit (rng) * 0.6f - 0.3f, unit (rng) * 2.f, a.z + unit (rng) * 0.6f - 0.3f };
+        const uint16_t first = (uint16_t)mesh.vertices.size();
+        mesh.vertices.insert (mesh.vertices.end(), { a, b, c });
+        mesh.faces.insert (mesh.faces.end(), { first, (uint16_t)(first + 1), (uint16_t)(first + 2) });
+    }
+    return mesh;
+}
+
+} // Fixtures namespace
+} // BE namespace
@@ -0,0 +1,67 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Grid.h"
+#include "PathPlanner.h"
+
+namespace BE {
+namespace Fixtures {
+
+/** Robot radius in cells PathFinding plans with by default. */
+static const int kRobotRadius = 2;
+
+/** Occupancy map of the corpus in Maps/, 255 = obstacle like PathFinding's raw map. */
+struct CorpusMap
+{
+    std::string name;
+    Grid<unsigned char> raw;
+};
+
+/** Read a binary PGM occupancy map into raw, without guard cells. */
+bool readOccupancyMap (const std::string& path, Grid<unsigned char>& raw);
+
+/** Every map of the corpus, sorted by name; read on first use. */
+const std::vector<CorpusMap>& mapCorpus ();
+
+/** Map of the corpus called name, or null. */
+const CorpusMap* corpusMap (const std::string& name);
+
+/**
+ * Random boxes over a free width x height floor, about a fifth of it blocked,
+ * for sizes the corpus does not have. The same seed gives the same map.
+ */
+void clutteredMap (int width, int height, unsigned seed, Grid<unsigned char>& raw);
+
+/** count random start and goal cells that are free and connected on planner's map. */
+std::vector<std::pair<GridPoint, GridPoint>> endpointPairs (const PathPlanner& planner, size_t count, unsigned seed);
+
+/** Indexed triangle mesh, laid out like BEMesh's meshVertices: and meshFaces:. */
+struct Mesh
+{
+    std::vector<Float3> vertices;
+    std::vector<uint16_t> faces;    // three vertex indices per triangle
+
+    /** The triangles as a soup, three vertices each. */
+    std::vector<Float3> triangles () const;
+};
+
+/**
+ * A scanned 6 x 6 m room centred on the origin: the floor at y = 0 facing
+ * up, boxes up to 1.55 m tall with outward walls, and loose triangles of
+ * any orientation like scan debris. The same seed gives the same mesh.
+ */
+Mesh roomMesh (unsigned seed, int boxes = 60, int debris = 300);
+
+} // Fixtures namespace
+} // BE namespace
@@ -0,0 +1,137 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "FlowField.h"
+#include "Fixtures.h"
+
+using namespace BE;
+
+namespace {
+
+    /** Free width x height map with the blocked guard band FlowField needs, and flat costs. */
+    struct OpenFloor
+    {
+        Grid<unsigned char> map;
+        Grid<unsigned char> costs;
+
+        OpenFloor (int width, int height)
+            : map (width, height, 1, 255)
+            , costs (width, height, 1, 0)
+        {
+            for (int y = 0; y < height; y++)
+                std::fill (map.row (y), map.row (y) + width, (unsigned char)0);
+        }
+    };
+
+} // anonymous
+
+TEST (FlowField, MovingTheGoalOffTheMapRebuildsAnEmptyField)
+{
+    OpenFloor floor (50, 50);
+    FlowField field;
+    field.build (floor.map, floor.costs, { 10, 10 });
+    ASSERT_TRUE (std::isfinite (field.distance (40, 40)));
+
+    const GridPoint offMap[] = { { 5000, -4000 }, { -1, 10 }, { 50, 49 }, { 10, -1 } };
+    for (const GridPoint& goal : offMap)
+    {
+        EXPECT_FALSE (field.moveGoal (goal));
+        EXPECT_EQ (field.goal(), goal);
+        EXPECT_TRUE (std::isinf (field.distance (40, 40)));
+        int dx, dy;
+        EXPECT_FALSE (field.step (40, 40, dx, dy));
+    }
+
+    // And back onto the map from there.
+    field.moveGoal ({ 20, 20 });
+    EXPECT_FLOAT_EQ (field.distance (20, 20), 0.f);
+    EXPECT_TRUE (std::isfinite (field.distance (0, 0)));
+}
+
+TEST (FlowField, ClearingDropsAFieldStillBeingBuilt)
+{
+    PathPlanner planner;
+    planner.load (Fixtures::corpusMap ("warehouse")->raw, Fixtures::kRobotRadius);
+    const auto goals = Fixtures::endpointPairs (planner, 4, 5);
+    ASSERT_EQ (goals.size(), 4u);
+
+    // A fresh build of the whole warehouse takes tens of milliseconds, so the
+    // clear lands mid-build; rounds where the build won anyway prove nothing.
+    int cleared = 0;
+    for (const auto& endpoints : goals)
+    {
+        std::atomic<bool> started { false }, finished { false };
+        std::thread builder ([&]
+        {
+            started = true;
+            planner.setFlowFieldGoal (endpoints.first);
+            finished = true;
+        });
+        while (!started)
+            std::this_thread::yield();
+        std::this_thread::sleep_for (std::chrono::milliseconds (2));
+        planner.clearFlowField();
+        const bool midBuild = !finished;
+        builder.join();
+
+        if (midBuild)
+        {
+            EXPECT_EQ (planner.flowField(), nullptr);
+            cleared++;
+        }
+        planner.clearFlowField();
+    }
+    EXPECT_GT (cleared, 0);
+
+    // A goal set after the clear is published as usual.
+    planner.setFlowFieldGoal (goals[0].first);
+    ASSERT_NE (planner.flowField(), nullptr);
+    EXPECT_EQ (planner.flowField()->goal(), goals[0].first);
+}
+
+TEST (FlowField, RepairedFieldStaysWithinTheMarginOfARebuild)
+{
+    PathPlanner planner;
+    planner.load (Fixtures::corpusMap ("apartment")->raw, Fixtures::kRobotRadius);
+    const GridPoint goal = Fixtures::endpointPairs (planner, 1, 11).at (0).first;
+
+    FlowField repaired;
+    repaired.build (planner.map(), planner.topoMap(), goal);
+    GridPoint moved = goal;
+    for (int i = 0; i < 8; i++)
+    {
+        const GridPoint next = { moved.x + (i % 2 ? 1 : 0), moved.y + (i % 2 ? 0 : 1) };
+        if (planner.isOccupied (next.x, next.y))
+            break;
+        moved = next;
+        repaired.moveGoal (moved);
+    }
+
+    FlowField exact;
+    exact.build (planner.map(), planner.topoMap(), moved);
+    for (int y = 0; y < planner.height(); y++)
+    {
+        for (int x = 0; x < planner.width(); x++)
+        {
+            const float want = exact.distance (x, y);
+            const float got = repaired.distance (x, y);
+            ASSERT_EQ (std::isinf (want), std::isinf (got)) << x << ", " << y;
+            if (!std::isinf (want))
+            {
+                ASSERT_GE (got, want - 1e-3f * want) << x << ", " << y;
+                ASSERT_LE (got, want + FlowField::kDefaultRepairMargin) << x << ", " << y;
+            }
+        }
+    }
+}
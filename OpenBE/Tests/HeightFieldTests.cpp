@@ -0,0 +1,80 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Fixtures.h"
+#include "HeightField.h"
+#include "HeightRasterizer.h"
+
+using namespace BE;
+
+namespace {
+
+    const float kNoHeight = HeightField::kNoHeight;
+
+    /** The room at 5 cm cells, as HeightField and as the heights it was assigned. */
+    HeightField roomField (std::vector<float>& heights)
+    {
+        const Fixtures::Mesh mesh = Fixtures::roomMesh (5);
+        HeightRasterizer rasterizer;
+        rasterizer.reset (120, 120, GridTransform{ -3.f, -3.f, 0.05f }, 1.8f, -0.5f);
+        rasterizer.addTriangles (mesh.vertices.data(), mesh.vertices.size(), mesh.faces.data(), mesh.faces.size() / 3);
+        heights = rasterizer.heights();
+
+        HeightField field;
+        field.assign (120, 120, -3.f, -3.f, 0.05f, heights.data());
+        return field;
+    }
+
+} // anonymous
+
+TEST (HeightField, CellsReadBackAsAssigned)
+{
+    std::vector<float> heights;
+    const HeightField field = roomField (heights);
+    for (int y = 0; y < field.height(); y++)
+    {
+        for (int x = 0; x < field.width(); x++)
+            ASSERT_EQ (field.height (x, y), heights[(size_t)x + (size_t)y * 120]) << x << ", " << y;
+    }
+    EXPECT_EQ (field.height (-1, 0), kNoHeight);
+    EXPECT_EQ (field.height (0, 120), kNoHeight);
+    EXPECT_EQ (HeightField().height (0, 0), kNoHeight);
+}
+
+TEST (HeightField, BatchMatchesSingleQueries)
+{
+    std::vector<float> heights;
+    const HeightField field = roomField (heights);
+
+    // Partial batches of eight, and positions well off the map.
+    const size_t count = 1003;
+    std::mt19937 rng (3);
+    std::uniform_real_distribution<float> coordinate (-3.5f, 3.5f);
+    std::vector<float> positions (2 * count);
+    for (float& p : positions)
+        p = coordinate (rng);
+
+    std::vector<float> batch (count);
+    std::vector<uint32_t> valid ((count + 31) / 32);
+    const size_t validCount = field.interpolate (positions.data(), count, batch.data(), valid.data());
+
+    size_t expected = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const float single = field.interpolate (positions[2 * i], positions[2 * i + 1]);
+        expected += single != kNoHeight;
+        EXPECT_FLOAT_EQ (batch[i], single) << i;
+        EXPECT_EQ ((valid[i / 32] >> (i % 32)) & 1, single != kNoHeight ? 1u : 0u) << i;
+    }
+    EXPECT_EQ (validCount, expected);
+    EXPECT_GT (validCount, count / 2);
+}
@@ -0,0 +1,165 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Fixtures.h"
+#include "HeightRasterizer.h"
+
+using namespace BE;
+
+/*
+ * HeightRasterizer against a reference doing what NavigationComponent did
+ * before: one vertical ray cast per sample, hitting front faces only, the
+ * way SceneKit's hitTestWithSegmentFromPoint: does.
+ */
+
+namespace {
+
+    const float kNoHeight = HeightRasterizer::kNoHeight;
+
+    struct Setting
+    {
+        float cellSize;
+        float startY;
+        float endY;
+    };
+
+    // Down from above and up from below the floor, on two cell sizes.
+    const Setting kSettings[] = {
+        { 0.05f, 1.8f, -0.5f },
+        { 0.05f, -0.5f, 1.8f },
+        { 0.037f, 1.8f, -0.5f },
+        { 0.037f, -0.5f, 1.8f },
+    };
+
+    /** Nearest front-facing hit of a vertical segment through every sample, in double precision. */
+    std::vector<float> rayCast (const Fixtures::Mesh& mesh, int width, int height, const GridTransform& transform,
+                                float startY, float endY)
+    {
+        std::vector<float> heights ((size_t)width * height, kNoHeight);
+        const double direction = endY < startY ? -1.0 : 1.0;
+        const double low = std::min (startY, endY), high = std::max (startY, endY);
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                const Float3 p = transform.toWorld ((float)x, (float)y);
+                float& sample = heights[(size_t)x + (size_t)y * width];
+                for (size_t i = 0; i < mesh.faces.size(); i += 3)
+                {
+                    const Float3& a = mesh.vertices[mesh.faces[i]];
+                    const Float3& b = mesh.vertices[mesh.faces[i + 1]];
+                    const Float3& c = mesh.vertices[mesh.faces[i + 2]];
+
+                    // The y of the face normal: the ray only hits faces turned towards where it starts.
+                    const double normalY = (double)(b.z - a.z) * (c.x - a.x) - (double)(b.x - a.x) * (c.z - a.z);
+                    if (normalY * direction >= 0.0)
+                        continue;
+
+                    const double area = -normalY;
+                    const double w0 = ((double)(c.x - b.x) * (p.z - b.z) - (double)(c.z - b.z) * (p.x - b.x)) / area;
+                    const double w1 = ((double)(a.x - c.x) * (p.z - c.z) - (double)(a.z - c.z) * (p.x - c.x)) / area;
+                    const double w2 = ((double)(b.x - a.x) * (p.z - a.z) - (double)(b.z - a.z) * (p.x - a.x)) / area;
+                    if (w0 < -1e-6 || w1 < -1e-6 || w2 < -1e-6)
+                        continue;
+
+                    const double hit = w0 * a.y + w1 * b.y + w2 * c.y;
+                    if (hit < low || hit > high)
+                        continue;
+                    if (sample == kNoHeight || (hit - sample) * direction < 0.0)
+                        sample = (float)hit;
+                }
+            }
+        }
+        return heights;
+    }
+
+    int samplesAcross (float cellSize) { return (int)(6.f / cellSize); }
+
+} // anonymous
+
+TEST (HeightRasterizer, SampleCoverageMatchesRayCasts)
+{
+    const Fixtures::Mesh mesh = Fixtures::roomMesh (7);
+    for (const Setting& setting : kSettings)
+    {
+        const int size = samplesAcross (setting.cellSize);
+        const GridTransform transform = { -3.f, -3.f, setting.cellSize };
+        const std::vector<float> reference = rayCast (mesh, size, size, transform, setting.startY, setting.endY);
+
+        HeightRasterizer rasterizer;
+        rasterizer.reset (size, size, transform, setting.startY, setting.endY, HeightRasterizer::SampleCoverage);
+        rasterizer.addTriangles (mesh.vertices.data(), mesh.vertices.size(), mesh.faces.data(), mesh.faces.size() / 3);
+
+        size_t hits = 0, mismatches = 0;
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            hits += reference[i] != kNoHeight;
+            mismatches += std::fabs (reference[i] - rasterizer.heights()[i]) > 1e-3f;
+        }
+        // From below, only the undersides of debris face the rays; the floor and boxes are culled.
+        EXPECT_GT (hits, reference.size() / 20) << "cell " << setting.cellSize << " from " << setting.startY;
+        EXPECT_EQ (mismatches, 0u) << "cell " << setting.cellSize << " from " << setting.startY;
+    }
+}
+
+TEST (HeightRasterizer, ConservativeCoverageNeverMissesARayCastHit)
+{
+    const Fixtures::Mesh mesh = Fixtures::roomMesh (7);
+    for (const Setting& setting : kSettings)
+    {
+        const int size = samplesAcross (setting.cellSize);
+        const GridTransform transform = { -3.f, -3.f, setting.cellSize };
+        const std::vector<float> reference = rayCast (mesh, size, size, transform, setting.startY, setting.endY);
+
+        HeightRasterizer rasterizer;
+        rasterizer.reset (size, size, transform, setting.startY, setting.endY, HeightRasterizer::ConservativeCoverage);
+        rasterizer.addTriangles (mesh.vertices.data(), mesh.vertices.size(), mesh.faces.data(), mesh.faces.size() / 3);
+
+        // Every hit is kept, at the ray cast's height or nearer the start of the segment.
+        const float direction = setting.endY < setting.startY ? -1.f : 1.f;
+        size_t violations = 0;
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            const float height = rasterizer.heights()[i];
+            if (reference[i] != kNoHeight && (height == kNoHeight || (height - reference[i]) * direction > 1e-4f))
+                violations++;
+        }
+        EXPECT_EQ (violations, 0u) << "cell " << setting.cellSize << " from " << setting.startY;
+    }
+}
+
+TEST (HeightRasterizer, WindowMatchesTheWholeMap)
+{
+    const Fixtures::Mesh mesh = Fixtures::roomMesh (9);
+    const int size = samplesAcross (0.037f);
+    const GridTransform transform = { -3.f, -3.f, 0.037f };
+
+    HeightRasterizer whole;
+    whole.reset (size, size, transform, 1.8f, -0.5f);
+    whole.addTriangles (mesh.vertices.data(), mesh.vertices.size(), mesh.faces.data(), mesh.faces.size() / 3);
+
+    const GridRect window = { 37, 51, 101, 90 };
+    HeightRasterizer tile;
+    tile.reset (window, transform, 1.8f, -0.5f);
+    tile.addTriangles (mesh.vertices.data(), mesh.vertices.size(), mesh.faces.data(), mesh.faces.size() / 3);
+
+    for (int y = window.y0; y < window.y1; y++)
+    {
+        for (int x = window.x0; x < window.x1; x++)
+        {
+            ASSERT_EQ (tile.heights()[(size_t)(x - window.x0) + (size_t)(y - window.y0) * tile.width()],
+                       whole.heights()[(size_t)x + (size_t)y * size]) << x << ", " << y;
+        }
+    }
+}
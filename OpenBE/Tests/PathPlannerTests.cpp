@@ -0,0 +1,178 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "Fixtures.h"
+#include "PathPlanner.h"
+
+using namespace BE;
+
+namespace {
+
+    template <typename T>
+    bool sameCells (const Grid<T>& a, const Grid<T>& b)
+    {
+        if (a.width() != b.width() || a.height() != b.height())
+            return false;
+        for (int y = 0; y < a.height(); y++)
+        {
+            for (int x = 0; x < a.width(); x++)
+            {
+                if (a(x, y) != b(x, y))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    const Grid<unsigned char>& apartment ()
+    {
+        const Fixtures::CorpusMap* map = Fixtures::corpusMap ("apartment");
+        EXPECT_NE (map, nullptr);
+        static const Grid<unsigned char> empty (1, 1);
+        return map ? map->raw : empty;
+    }
+
+} // anonymous
+
+TEST (PathPlanner, ReadsTheMapCorpus)
+{
+    ASSERT_FALSE (Fixtures::mapCorpus().empty());
+    for (const Fixtures::CorpusMap& map : Fixtures::mapCorpus())
+    {
+        PathPlanner planner;
+        planner.load (map.raw, Fixtures::kRobotRadius);
+        EXPECT_NE (planner.largestComponent(), 0u) << map.name;
+        EXPECT_FALSE (Fixtures::endpointPairs (planner, 10, 1).empty()) << map.name;
+    }
+}
+
+TEST (PathPlanner, EditedLayersMatchAFreshLoad)
+{
+    PathPlanner planner;
+    planner.load (apartment(), Fixtures::kRobotRadius);
+    planner.setOccupied (80, 60, 10.5f, true);
+    planner.setOccupied (150, 120, 6.f, false);
+    planner.setRobotRadius (3);
+    planner.setOccupied (250, 40, 8.f, true);
+
+    PathPlanner fresh;
+    fresh.load (planner.rawMap(), 3);
+    EXPECT_TRUE (sameCells (planner.map(), fresh.map()));
+    EXPECT_TRUE (sameCells (planner.topoMap(), fresh.topoMap()));
+
+    // Labels may be numbered differently; the regions they describe must not be.
+    const GridPoint probe = Fixtures::endpointPairs (fresh, 1, 7).at (0).first;
+    for (int y = 0; y < fresh.height(); y++)
+    {
+        for (int x = 0; x < fresh.width(); x++)
+            ASSERT_EQ (planner.canPath ({ x, y }, probe), fresh.canPath ({ x, y }, probe)) << x << ", " << y;
+    }
+}
+
+TEST (PathPlanner, EditsAtEveryRadiusMatchAFreshLoad)
+{
+    // The topo map reaches at least one cell past the dilation, even with no robot radius.
+    for (int radius : { 0, 1, 2, 5 })
+    {
+        PathPlanner planner;
+        planner.load (apartment(), radius);
+        planner.setOccupied (80, 60, 3.f, true);
+        planner.setOccupied (150, 120, 0.5f, true);
+        planner.setOccupied (80, 60, 1.5f, false);
+
+        PathPlanner fresh;
+        fresh.load (planner.rawMap(), radius);
+        EXPECT_TRUE (sameCells (planner.map(), fresh.map())) << "radius " << radius;
+        EXPECT_TRUE (sameCells (planner.topoMap(), fresh.topoMap())) << "radius " << radius;
+    }
+}
+
+TEST (PathPlanner, CacheRoundTripsTheLayers)
+{
+    PathPlanner planner;
+    planner.load (apartment(), Fixtures::kRobotRadius);
+
+    const std::string path = testing::TempDir() + "PathPlannerTests.cache";
+    OccupancyCache::Info info;
+    info.metersPerPixel = 0.04f;
+    ASSERT_TRUE (planner.save (path.c_str(), 42, info));
+
+    OccupancyCache cache;
+    PathPlanner loaded;
+    ASSERT_TRUE (cache.open (path.c_str(), 42));
+    ASSERT_TRUE (loaded.load (cache));
+    EXPECT_EQ (loaded.robotRadius(), Fixtures::kRobotRadius);
+    EXPECT_TRUE (sameCells (loaded.rawMap(), planner.rawMap()));
+    EXPECT_TRUE (sameCells (loaded.map(), planner.map()));
+    EXPECT_TRUE (sameCells (loaded.topoMap(), planner.topoMap()));
+    EXPECT_TRUE (sameCells (loaded.componentMap(), planner.componentMap()));
+
+    OccupancyCache stale;
+    EXPECT_FALSE (stale.open (path.c_str(), 43));
+    remove (path.c_str());
+}
+
+TEST (PathPlanner, EveryAlgorithmReachesConnectedGoals)
+{
+    const PathPlanner::Algorithm algorithms[] = {
+        PathPlanner::AStarAlgorithm, PathPlanner::JumpPointAlgorithm, PathPlanner::HierarchicalAlgorithm,
+        PathPlanner::IncrementalAlgorithm, PathPlanner::CoarseToFineAlgorithm, PathPlanner::AnyAngleAlgorithm,
+        PathPlanner::BidirectionalAlgorithm
+    };
+
+    PathPlanner planner;
+    planner.load (apartment(), Fixtures::kRobotRadius);
+    planner.pathCache().setCapacity (0);
+
+    for (const auto& endpoints : Fixtures::endpointPairs (planner, 40, 3))
+    {
+        PathPlanner::Query query;
+        query.start = endpoints.first;
+        query.goal = endpoints.second;
+
+        PathPlanner::Result optimal;
+        ASSERT_TRUE (planner.findPath (query, optimal));
+        for (PathPlanner::Algorithm algorithm : algorithms)
+        {
+            query.algorithm = algorithm;
+            PathPlanner::Result result;
+            ASSERT_TRUE (planner.findPath (query, result)) << "algorithm " << algorithm;
+            ASSERT_FALSE (result.waypoints.empty());
+            EXPECT_EQ (result.waypoints.back().x, (float)query.goal.x) << "algorithm " << algorithm;
+            EXPECT_EQ (result.waypoints.back().y, (float)query.goal.y) << "algorithm " << algorithm;
+            // Any-angle paths may beat the grid optimum; the others can only match it.
+            if (algorithm != PathPlanner::AnyAngleAlgorithm)
+                EXPECT_GE (result.cost, optimal.cost * (1.f - 1e-4f)) << "algorithm " << algorithm;
+            if (algorithm == PathPlanner::JumpPointAlgorithm || algorithm == PathPlanner::BidirectionalAlgorithm)
+                EXPECT_NEAR (result.cost, optimal.cost, 1e-3f * optimal.cost) << "algorithm " << algorithm;
+        }
+    }
+}
+
+TEST (PathPlanner, UnreachableGoalFailsUnlessClosestIsAsked)
+{
+    PathPlanner planner;
+    planner.load (apartment(), Fixtures::kRobotRadius);
+
+    PathPlanner::Query query;
+    query.start = Fixtures::endpointPairs (planner, 1, 5).at (0).first;
+    query.goal = { 0, 0 };
+    ASSERT_TRUE (planner.isOccupied (0, 0));
+
+    PathPlanner::Result result;
+    EXPECT_FALSE (planner.findPath (query, result));
+
+    query.closest = true;
+    ASSERT_TRUE (planner.findPath (query, result));
+    EXPECT_FALSE (planner.isOccupied (result.goal.x, result.goal.y));
+    EXPECT_TRUE (planner.canPath (query.start, result.goal));
+}
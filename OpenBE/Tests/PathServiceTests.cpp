@@ -0,0 +1,205 @@
+/*
+ Bridge Engine Open Source
+ This file is part of the Structure SDK.
+ Copyright © 2016 Occipital, Inc. All rights reserved.
+ http://structure.io
+ */
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Fixtures.h"
+#include "PathPlanner.h"
+#include "PathService.h"
+
+using namespace BE;
+
+/*
+ * Stress tests of the path service with many agents planning at once on one
+ * PathPlanner, the way PathFinding drives it.
+ */
+
+namespace {
+
+    const unsigned kThreads = 4;
+    const int kAgents = 63;
+    const int kRetargets = 3;
+
+} // anonymous
+
+TEST (PathService, ManyAgentsPlanConcurrentlyBetweenEdits)
+{
+    PathService service (kThreads);
+    PathPlanner planner (service.threadCount());
+    planner.load (Fixtures::corpusMap ("office")->raw, Fixtures::kRobotRadius);
+
+    std::mt19937 rng (3);
+    std::atomic<bool> editing (false);
+    std::atomic<int> overlaps (0), invalid (0), done (0), found (0), cancelled (0);
+    std::mutex mutex;
+    std::vector<int> lastCancelled;     // ids of cancelled jobs that were the newest of their agent
+
+    const int rounds = 12;
+    int submitted = 0;
+    for (int round = 0; round < rounds; round++)
+    {
+        for (int agent = 1; agent <= kAgents; agent++)
+        {
+            for (int k = 0; k < kRetargets; k++)
+            {
+                PathPlanner::Query query;
+                query.start = { (int)(rng() % (unsigned)planner.width()), (int)(rng() % (unsigned)planner.height()) };
+                query.goal = { (int)(rng() % (unsigned)planner.width()), (int)(rng() % (unsigned)planner.height()) };
+                query.algorithm = (PathPlanner::Algorithm)(rng() % 3);
+                const bool newest = round == rounds - 1 && k == kRetargets - 1;
+                const int id = submitted++;
+
+                service.submit ((uint64_t)agent, [&, query, newest, id](size_t worker, const CancelFlag& flag)
+                {
+                    if (editing.load())
+                        overlaps++;
+                    PathPlanner::Query q = query;
+                    q.worker = worker;
+                    q.cancel = &flag;
+                    PathPlanner::Result result;
+                    const bool ok = !flag.load() && planner.findPath (q, result);
+                    if (ok)
+                    {
+                        found++;
+                        if (!planner.canPath (q.start, result.goal) || result.waypoints.empty()
+                            || result.waypoints.back().x != (float)result.goal.x || result.waypoints.back().y != (float)result.goal.y)
+                            invalid++;
+                    }
+                    if (flag.load())
+                    {
+                        cancelled++;
+                        if (newest)
+                        {
+                            std::lock_guard<std::mutex> lock (mutex);
+                            lastCancelled.push_back (id);
+                        }
+                    }
+                    if (editing.load())
+                        overlaps++;
+                    done++;
+                });
+            }
+        }
+
+        // A map edit after every round, as setOccupied: does.
+        const GridPoint edit = { (int)(rng() % (unsigned)planner.width()), (int)(rng() % (unsigned)planner.height()) };
+        const bool occupied = round % 2 == 0;
+        service.submitExclusive ([&, edit, occupied]
+        {
+            editing = true;
+            planner.setOccupied (edit.x, edit.y, 6.f, occupied);
+            editing = false;
+        });
+    }
+    service.waitIdle();
+
+    EXPECT_EQ (done.load(), submitted);
+    EXPECT_EQ (overlaps.load(), 0);
+    EXPECT_EQ (invalid.load(), 0);
+    EXPECT_GT (found.load(), 0);
+    // Nothing supersedes the last request of each agent.
+    EXPECT_TRUE (lastCancelled.empty());
+    EXPECT_LT (cancelled.load(), submitted);
+}
+
+TEST (PathService, CancellingStopsARunningSearch)
+{
+    // An open map whose goal is walled in: A* would have to settle every cell to fail.
+    Grid<unsigned char> raw (1500, 1500, 0, 0);
+    for (int dy = -3; dy <= 3; dy++)
+    {
+        for (int dx = -3; dx <= 3; dx++)
+        {
+            if (abs (dx) == 3 || abs (dy) == 3)
+                raw (750 + dx, 750 + dy) = 255;
+        }
+    }
+    PathPlanner planner (1);
+    planner.load (raw, 0);
+
+    PathService service (1);
+    std::atomic<bool> started (false);
+    PathPlanner::Result result;
+    auto ticket = service.submit (1, [&](size_t worker, const CancelFlag& flag)
+    {
+        started = true;
+        PathPlanner::Query query;
+        query.start = { 0, 0 };
+        query.goal = { 750, 750 };
+        query.worker = worker;
+        query.cancel = &flag;
+        // canPath would reject the query up front, so search directly.
+        std::vector<GridPoint> path;
+        AStar search;
+        search.findPath (planner.map(), query.start, query.goal, path, query.cancel);
+        result.cancelled = search.stats().cancelled;
+        result.expanded = search.stats().expanded;
+    });
+
+    while (!started.load())
+        std::this_thread::yield();
+    ticket->cancel();
+    service.waitIdle();
+
+    EXPECT_TRUE (result.cancelled);
+    EXPECT_LT (result.expanded, (size_t)1500 * 1500);
+}
+
+TEST (PathService, NewerRequestOfAnAgentSupersedesQueuedOnes)
+{
+    PathService service (1);
+    std::atomic<bool> release (false);
+    std::atomic<int> ran (0), cancelled (0);
+
+    // Keeps the only worker busy until everything below is queued.
+    service.submit (PathService::kNoAgent, [&](size_t, const CancelFlag&)
+    {
+        while (!release.load())
+            std::this_thread::yield();
+    });
+
+    const int requests = 20;
+    for (int i = 0; i < requests; i++)
+    {
+        service.submit (7, [&](size_t, const CancelFlag& flag)
+        {
+            ran++;
+            if (flag.load())
+                cancelled++;
+        });
+    }
+    release = true;
+    service.waitIdle();
+
+    // Superseded jobs still run so their completions fire, flagged cancelled.
+    EXPECT_EQ (ran.load(), requests);
+    EXPECT_EQ (cancelled.load(), requests - 1);
+}
+
+TEST (PathService, DestroyingTheServiceDrainsPendingJobs)
+{
+    std::atomic<int> ran (0);
+    const int requests = 200;
+    {
+        PathService service (kThreads);
+        for (int i = 0; i < requests; i++)
+        {
+            service.submit ((uint64_t)(i % 5 + 1), [&](size_t, const CancelFlag&)
+            {
+                std::this_thread::sleep_for (std::chrono::microseconds (50));
+                ran++;
+            });
+        }
+    }
+    EXPECT_EQ (ran.load(), requests);
+}